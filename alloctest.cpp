@@ -0,0 +1,100 @@
+//-----------------------------------------------------------------------//
+// ALLOCTEST.CPP                                                         //
+//                                                                       //
+// Allocation counts of Poly expressions                                 //
+//-----------------------------------------------------------------------//
+// Build and run like test.cpp, e.g.                                     //
+//                                                                       //
+//     g++ -o alloctest alloctest.cpp && ./alloctest                     //
+//                                                                       //
+// operator new and new[] are replaced below to count every heap         //
+// allocation; each expression is run between two readings of the        //
+// count, which must be the number below, and "ok" is printed.  The      //
+// operands have more than INLINE_SIZE terms, so every result needs an   //
+// array, and fewer than polymul::KARATSUBA_THRESHOLD, so the product    //
+// needs no scratch:                                                     //
+//                                                                       //
+//   -- C = A + B         1: the sum is built in C's new array           //
+//   -- D = A * B - 15    1: - works in the product's array              //
+//   -- A + B - C + D     1: one array for the whole chain               //
+//   -- Poly F(move(E))   0: F takes over E's array                      //
+//   -- 1000 setCoeff()   about log2(1000): capacity at least doubles    //
+//-----------------------------------------------------------------------//
+
+#include "poly.cpp"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+using namespace std;
+
+//heap allocations so far
+static long long allocations = 0;
+
+//-------------------------- operator new ---------------------------------
+// Count every heap allocation of the program
+void* operator new(size_t size) {
+   allocations++;
+   void* p = malloc((size != 0) ? size : 1);
+   if (p == NULL)
+      throw bad_alloc();
+   return p;
+}
+
+void* operator new[](size_t size) {
+   return operator new(size);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+//------------------------------- expect ----------------------------------
+// Check that the allocations since start are in [low, high]
+static void expect(const char* what, long long start, long long low,
+                   long long high) {
+   long long count = allocations - start;
+   cout << what << ": " << count << " allocations" << endl;
+   if (count < low || count > high) {
+      cout << "FAILED: expected " << low;
+      if (high != low)
+         cout << " to " << high;
+      cout << endl;
+      exit(1);
+   }
+}
+
+int main() {
+   Poly A, B, C, D;
+   for (int e = 0; e < 16; e++) {
+      A.setCoeff(e + 1, e);
+      B.setCoeff(2 * e - 7, e);
+   }
+
+   long long start = allocations;
+   C = A + B;
+   expect("C = A + B", start, 1, 1);
+
+   start = allocations;
+   D = A * B - 15;
+   expect("D = A * B - 15", start, 1, 1);
+
+   start = allocations;
+   Poly E = A + B - C + D;
+   expect("A + B - C + D", start, 1, 1);
+
+   start = allocations;
+   Poly F(move(E));
+   expect("Poly F(move(E))", start, 0, 0);
+
+   Poly grow;
+   start = allocations;
+   for (int e = 0; e < 1000; e++)
+      grow.setCoeff(e + 1, e);
+   long long growths = (long long)ceil(log2(1000.0));
+   expect("1000 setCoeff()", start, 1, growths + 1);
+
+   cout << "ok" << endl;
+   return 0;
+}
@@ -0,0 +1,797 @@
+//-----------------------------------------------------------------------//
+// BENCH.CPP                                                             //
+//                                                                       //
+// Timing driver for class Poly                                          //
+//-----------------------------------------------------------------------//
+// Build and run with optimization, e.g.                                 //
+//                                                                       //
+//     g++ -O2 -o bench bench.cpp poly.cpp                               //
+//     ./bench [--csv | --json] [--min-time S] [--max-size N] [filter]   //
+//                                                                       //
+// runs every workload whose name contains filter, at each size from 8   //
+// up to 10^6 (or N) that it supports.  Each is repeated until it has    //
+// run for at least S seconds (default MIN_SECONDS) and reported as      //
+//                                                                       //
+//   -- ns/op:      nanoseconds per operation                            //
+//   -- allocs/op:  heap allocations per operation, counted by the       //
+//                  replacement operator new below                       //
+//   -- bytes/op:   bytes in those allocations                           //
+//   -- Melem/s:    millions of coefficients or terms processed per      //
+//                  second                                               //
+//                                                                       //
+// as a table, as CSV with a header line, or as a JSON array, so runs    //
+// can be compared by a script.  A checksum of the results is printed    //
+// too (to stderr for CSV and JSON), so the work cannot be optimized     //
+// away.                                                                 //
+//                                                                       //
+//     ./bench multipoint [maxPoints]                                    //
+//                                                                       //
+// instead times evaluation at n points one point at a time against one  //
+// batch call (the subproduct tree), and interpolation, for n = 1024 up  //
+// to maxPoints (default 2^20), in milliseconds.                         //
+//                                                                       //
+//     ./bench gcd [maxDegree]                                           //
+//                                                                       //
+// times the gcd of two ModPolys of degree about 9n/8 with a common      //
+// factor of degree n/8 by the Euclidean algorithm on % against          //
+// ModPoly::gcd() (half-GCD), and a resultant, for n = 1024 up to        //
+// maxDegree (default 2^17), in milliseconds.                            //
+//                                                                       //
+//     ./bench compose [maxDegree]                                       //
+//                                                                       //
+// times pow() against a loop of *=, taylorShift() against Horner's rule //
+// in x + c, and compose() against Horner's rule with mullow(), for n =  //
+// 256 up to maxDegree (default 2^14), in milliseconds.                  //
+//                                                                       //
+//     POLY_THREADS=8 ./bench parallel [maxTerms]                        //
+//                                                                       //
+// times products of n terms with EXEC_SERIAL against EXEC_PARALLEL on   //
+// the shared thread pool, for n = 4096 up to maxTerms (default 2^18).   //
+//                                                                       //
+// Built with -DPOLY_INLINE_SIZE=0, Poly stores no array inline, so the  //
+// two builds compare the workloads with and without inline storage:     //
+//                                                                       //
+//     g++ -O2 -DPOLY_INLINE_SIZE=0 -o bench0 bench.cpp poly.cpp         //
+//-----------------------------------------------------------------------//
+
+#include "poly.h"
+#include "polycache.h"
+#include "polymulti.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+//shortest time each workload is run for, by default
+const double MIN_SECONDS = 0.25;
+
+//sizes the workloads are run at: degree + 1 for DENSE Polys
+const int SIZES[] = { 8, 64, 512, 4096, 32768, 262144, 1000000 };
+
+//SPARSE workloads use Polys of size/SPARSE_GAP terms, at most
+//SPARSE_TERMS of them
+const int SPARSE_GAP = 64;
+const int SPARSE_TERMS = 2048;
+
+//setCoeff() in decreasing exponent order takes quadratic time above a
+//few thousand terms, so it is only run up to here
+const int SLOW_MAX = 32768;
+
+//MultiPoly workloads run up to this many terms
+const int MULTI_MAX = 32768;
+
+//result of every workload is folded in here
+static long long checksum = 0;
+
+//heap allocations so far, and their bytes
+static atomic<long long> allocations(0);
+static atomic<long long> allocatedBytes(0);
+
+//-------------------------- operator new ---------------------------------
+// Count every heap allocation of the program; operator new[] and the
+// other forms call this one
+void* operator new(size_t size) {
+   allocations.fetch_add(1, memory_order_relaxed);
+   allocatedBytes.fetch_add(size, memory_order_relaxed);
+   void* p = malloc((size != 0) ? size : 1);
+   if (p == NULL)
+      throw bad_alloc();
+   return p;
+}
+
+//kept out of line: inlined, free() would meet pointers from new and
+//trip -Wmismatched-new-delete
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+   free(p);
+}
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+
+//------------------------------- Options ---------------------------------
+// Command line of the workload suite
+struct Options {
+   enum Format { TABLE, CSV, JSON } format;
+   double minSeconds;
+   int maxSize;
+   string filter;
+};
+
+static Options options = { Options::TABLE, MIN_SECONDS, 1000000, "" };
+
+//------------------------------- report ----------------------------------
+// Print one result in the chosen format
+static void report(const string& name, int size, double ns, double allocs,
+                   double bytes, double elementsPerOp) {
+   static bool first = true;
+   double mElemPerSec = elementsPerOp * 1e3 / ns;
+   if (options.format == Options::CSV) {
+      if (first)
+         cout << "workload,size,ns_per_op,allocs_per_op,bytes_per_op,"
+              << "melem_per_s" << endl;
+      cout << name << ',' << size << ',' << ns << ',' << allocs << ','
+           << bytes << ',' << mElemPerSec << endl;
+   } else if (options.format == Options::JSON) {
+      cout << (first ? "" : ",\n") << "  {\"workload\": \"" << name
+           << "\", \"size\": " << size << ", \"ns_per_op\": " << ns
+           << ", \"allocs_per_op\": " << allocs << ", \"bytes_per_op\": "
+           << bytes << ", \"melem_per_s\": " << mElemPerSec << "}";
+   } else {
+      if (first)
+         cout << left << setw(22) << "workload" << right << setw(9)
+              << "size" << setw(14) << "ns/op" << setw(11) << "allocs/op"
+              << setw(13) << "bytes/op" << setw(11) << "Melem/s" << endl;
+      cout << left << setw(22) << name << right << fixed << setw(9) << size
+           << setprecision(1) << setw(14) << ns << setprecision(2)
+           << setw(11) << allocs << setprecision(0) << setw(13) << bytes
+           << setprecision(1) << setw(11) << mElemPerSec << endl;
+   }
+   first = false;
+}
+
+//-------------------------------- run ------------------------------------
+// Time one operation, fn(), which processes elementsPerOp coefficients
+// or terms, and report it.  fn runs in batches that double until a
+// batch takes a tenth of the time, so the clock is read rarely
+template <class F>
+static void run(const string& name, int size, double elementsPerOp, F fn) {
+   if (name.find(options.filter) == string::npos)
+      return;
+   typedef chrono::steady_clock Clock;
+   fn();                               //warm up caches and allocators
+   long long calls = 0, batch = 1;
+   long long allocs = allocations, bytes = allocatedBytes;
+   Clock::time_point start = Clock::now();
+   double seconds = 0;
+   while (seconds < options.minSeconds) {
+      double before = seconds;
+      for (long long i = 0; i < batch; i++)
+         fn();
+      calls += batch;
+      seconds = chrono::duration<double>(Clock::now() - start).count();
+      if (seconds - before < options.minSeconds / 10)
+         batch *= 2;
+   }
+   report(name, size, seconds * 1e9 / calls,
+          (double)(allocations - allocs) / calls,
+          (double)(allocatedBytes - bytes) / calls, elementsPerOp);
+}
+
+//------------------------------ makeDense --------------------------------
+// A DENSE Poly of size terms, none of them zero
+static Poly makeDense(int size) {
+   Poly a;
+   a.setRepresentation(PolyBase::DENSE);
+   for (int e = size - 1; e >= 0; e--)
+      a.setCoeff(rand() % 1999 - 999 + (rand() % 2 == 0 ? 1000 : -1000), e);
+   return a;
+}
+
+//------------------------------ makeSparse -------------------------------
+// A SPARSE Poly of degree size - 1 with size/SPARSE_GAP terms, at most
+// SPARSE_TERMS
+static Poly makeSparse(int size) {
+   Poly a;
+   a.setRepresentation(PolyBase::SPARSE);
+   int count = max(1, min(size / SPARSE_GAP, SPARSE_TERMS));
+   for (int k = 0; k < count; k++)
+      a.setCoeff(rand() % 1000 + 1, (int)((long long)(size - 1) * k /
+                                          max(1, count - 1)));
+   return a;
+}
+
+//---------------------------- construction -------------------------------
+// Construct and destroy low degree Polys, as in Poly(int) and the
+// temporaries of A + 5, and copy, assign and compare Polys of each size:
+// copies share the array until one is written to, and compares are
+// also timed once the hashes are known
+static void construction() {
+   run("construct/int", 1, 1, [] {
+      Poly a(7);
+      checksum += a.getCoeff(0);
+   });
+   run("construct/term", 8, 1, [] {
+      Poly b(3, 7);
+      checksum += b.getCoeff(7);
+   });
+   for (int size : SIZES) {
+      if (size > options.maxSize)
+         break;
+      Poly a = makeDense(size), target;
+      Poly same(a), other(a);
+      other.setCoeff(other.getCoeff(0) + 1, 0);
+      run("copy", size, size, [&a] {
+         Poly b(a);
+         checksum += b.getCoeff(0);
+      });
+      run("assign", size, size, [&a, &target] {
+         target = a;
+         checksum += target.getCoeff(0);
+      });
+      run("copy/write", size, size, [&a] {
+         Poly b(a);
+         b.setCoeff(b.getCoeff(0) + 1, 0);
+         checksum += b.getCoeff(0);
+      });
+      run("equal/same", size, size, [&a, &same] {
+         checksum += (a == same);
+      });
+      run("equal/differs", size, size, [&a, &other] {
+         checksum += (a == other);
+      });
+      checksum += a.hash() + other.hash();
+      run("equal/hashed", size, size, [&a, &other] {
+         checksum += (a == other);
+      });
+   }
+}
+
+//----------------------------- arithmetic --------------------------------
+// +, -, *, += and divmod() of DENSE and SPARSE Polys of each size
+static void arithmetic() {
+   for (int size : SIZES) {
+      if (size > options.maxSize)
+         break;
+      Poly a = makeDense(size), b = makeDense(size), c;
+      run("add/dense", size, size, [&] {
+         c = a + b;
+         checksum += c.getCoeff(0);
+      });
+      run("sub/dense", size, size, [&] {
+         c = a - b;
+         checksum += c.getCoeff(0);
+      });
+      run("add-assign/dense", size, size, [&] {
+         c = a;
+         c += b;
+         checksum += c.getCoeff(0);
+      });
+      run("mul/dense", size, 2.0 * size, [&] {
+         c = a * b;
+         checksum += c.getCoeff(0);
+      });
+      run("mul-scalar/dense", size, size, [&] {
+         c = a * 3;
+         checksum += c.getCoeff(0);
+      });
+      Poly monic(b), dividend;
+      monic.setCoeff(1, size - 1);
+      dividend = a * monic + b;
+      run("divmod/dense", size, 3.0 * size, [&] {
+         Poly q, r;
+         dividend.divmod(monic, q, r);
+         checksum += q.getCoeff(0) + r.getCoeff(0);
+      });
+      if (size < 4096)
+         continue;
+      Poly s = makeSparse(size), t = makeSparse(size - size / 3);
+      double terms = s.termCount() + t.termCount();
+      run("add/sparse", size, terms, [&] {
+         c = s + t;
+         checksum += c.termCount();
+      });
+      run("mul/sparse", size, terms, [&] {
+         c = s * t;
+         checksum += c.termCount();
+      });
+      run("mul/dense*sparse", size, size + terms, [&] {
+         c = a * t;
+         checksum += c.getCoeff(0);
+      });
+      //(x^(size-1) + 1)(x^(size/2) + x + 3), stored SPARSE and DENSE:
+      //the terms are merged in a heap either way
+      Poly u(1, size - 1), v(1, size / 2);
+      u += Poly(1);
+      v += Poly(1, 1) + Poly(3);
+      Poly denseU(u), denseV(v);
+      denseU.setRepresentation(PolyBase::DENSE);
+      denseV.setRepresentation(PolyBase::DENSE);
+      run("mul/few-terms", size, 5, [&] {
+         c = u * v;
+         checksum += c.termCount();
+      });
+      run("mul/few-terms-dense", size, 2.0 * size, [&] {
+         c = denseU * denseV;
+         checksum += c.termCount();
+      });
+   }
+}
+
+//------------------------------- series ----------------------------------
+// Truncated products and power series functions of ModPolys to size
+// terms; mul/mod-full is the whole product that mullow() truncates.
+// Under a PolyCache, mul/mod-cached repeats one product, and
+// mul/mod-fixed multiplies a by an input changed every time, reusing
+// a's transforms
+static void series() {
+   typedef ModInt<998244353> Mod;
+   typedef ModPoly<998244353> MP;
+   for (int size : SIZES) {
+      if (size > options.maxSize)
+         break;
+      MP a, b, c;
+      for (int e = size - 1; e >= 0; e--) {   //top term first: one grow
+         a.setCoeff(Mod(rand()), e);
+         b.setCoeff(Mod(rand()), e);
+      }
+      MP one = a, zero = a;
+      one.setCoeff(Mod(1), 0);
+      zero.setCoeff(Mod(0), 0);
+      run("mul/mod-full", size, 2.0 * size, [&] {
+         c = a * b;
+         checksum += c.getCoeff(0).value();
+      });
+      {
+         PolyCache<Mod> cache;
+         PolyCacheScope<Mod> scope(&cache);
+         run("mul/mod-cached", size, 2.0 * size, [&] {
+            c = a * b;
+            checksum += c.getCoeff(0).value();
+         });
+         MP input(b);
+         int step = 0;
+         run("mul/mod-fixed", size, 2.0 * size, [&] {
+            input.setCoeff(Mod(++step), 0);
+            c = a * input;
+            checksum += c.getCoeff(0).value();
+         });
+      }
+      run("mullow/mod", size, 2.0 * size, [&] {
+         c = a.mullow(b, size);
+         checksum += c.getCoeff(0).value();
+      });
+      run("mulhigh/mod", size, 2.0 * size, [&] {
+         c = a.mulhigh(b, size);
+         checksum += c.getCoeff(0).value();
+      });
+      run("series/inverse", size, size, [&] {
+         c = one.seriesInverse(size);
+         checksum += c.getCoeff(0).value();
+      });
+      run("series/log", size, size, [&] {
+         c = one.seriesLog(size);
+         checksum += c.getCoeff(1).value();
+      });
+      run("series/exp", size, size, [&] {
+         c = zero.seriesExp(size);
+         checksum += c.getCoeff(1).value();
+      });
+      run("series/sqrt", size, size, [&] {
+         c = one.seriesSqrt(size);
+         checksum += c.getCoeff(1).value();
+      });
+   }
+}
+
+//---------------------------- multivariate -------------------------------
+// MultiPoly +, * and evaluate() of size terms: sparse ones in 4
+// variables, whose products merge in a heap, and dense ones in 3 (every
+// monomial below x^d y^d z^d), whose products go to Poly by Kronecker
+// substitution
+static void multivariate() {
+   for (int size : SIZES) {
+      if (size > options.maxSize || size > MULTI_MAX)
+         break;
+      MultiPoly a(4), b(4), few(4), c(4);
+      vector<int> e(4);
+      for (int k = 0; k < size; k++) {
+         for (int v = 0; v < 4; v++)
+            e[v] = rand() % 1024;
+         a.setCoeff(rand() % 1000 + 1, e);
+         for (int v = 0; v < 4; v++)
+            e[v] = rand() % 1024;
+         b.setCoeff(rand() % 1000 + 1, e);
+         if (k < 64)
+            few.setCoeff(rand() % 1000 + 1, e);
+      }
+      int d = 1;
+      while ((d + 1) * (d + 1) * (d + 1) <= size)
+         d++;
+      MultiPoly cube(3), product(3);
+      for (int i = 0; i < d; i++)
+         for (int j = 0; j < d; j++)
+            for (int k = 0; k < d; k++)
+               cube.setCoeff(rand() % 1000 + 1, { i, j, k });
+      vector<int> point = { 3, 5, 7, 11 };
+      double terms = a.termCount() + b.termCount();
+      run("multi/add", size, terms, [&] {
+         c = a + b;
+         checksum += c.termCount();
+      });
+      run("multi/mul-sparse", size, (double)a.termCount() * 64, [&] {
+         c = a * few;
+         checksum += c.termCount();
+      });
+      run("multi/mul-dense", size, 2.0 * cube.termCount(), [&] {
+         product = cube * cube;
+         checksum += product.termCount();
+      });
+      run("multi/evaluate", size, a.termCount(), [&] {
+         checksum += a.evaluate(point);
+      });
+   }
+}
+
+//------------------------------ growth -----------------------------------
+// Build a Poly of each size with setCoeff() in increasing, decreasing
+// and (with DENSE requested) decreasing exponent order, and with
+// reserve() first
+static void growth() {
+   for (int size : SIZES) {
+      if (size > options.maxSize)
+         break;
+      run("setCoeff/ascending", size, size, [size] {
+         Poly a;
+         for (int e = 0; e < size; e++)
+            a.setCoeff(e + 1, e);
+         checksum += a.getCoeff(size - 1);
+      });
+      if (size <= SLOW_MAX) {
+         run("setCoeff/descending", size, size, [size] {
+            Poly a;
+            for (int e = size - 1; e >= 0; e--)
+               a.setCoeff(e + 1, e);
+            checksum += a.getCoeff(0);
+         });
+      }
+      run("setCoeff/dense-desc", size, size, [size] {
+         Poly a;
+         a.setRepresentation(PolyBase::DENSE);
+         for (int e = size - 1; e >= 0; e--)
+            a.setCoeff(e + 1, e);
+         checksum += a.getCoeff(0);
+      });
+      run("setCoeff/reserved-asc", size, size, [size] {
+         Poly a;
+         a.setRepresentation(PolyBase::DENSE);
+         a.reserve(size);
+         for (int e = 0; e < size; e++)
+            a.setCoeff(e + 1, e);
+         checksum += a.getCoeff(size - 1);
+      });
+   }
+}
+
+//------------------------------ streams ----------------------------------
+// Text output with <<, input with >> and parse(), and binary save() and
+// load(), of DENSE Polys of each size
+static void streams() {
+   for (int size : SIZES) {
+      if (size > options.maxSize)
+         break;
+      Poly a = makeDense(size);
+      string printed, pairs;
+      a.format(printed);
+      for (int e = size - 1; e >= 0; e--)
+         pairs += to_string(a.getCoeff(e)) + ' ' + to_string(e) + ' ';
+      pairs += "-1 -1";
+      stringstream binary(ios::in | ios::out | ios::binary);
+      a.save(binary);
+      string saved = binary.str();
+
+      run("write/<<", size, size, [&a] {
+         ostringstream out;
+         out << a;
+         checksum += out.tellp();
+      });
+      run("write/format", size, size, [&a, &printed] {
+         printed.clear();
+         a.format(printed);
+         checksum += printed.size();
+      });
+      run("read/>>", size, size, [&pairs] {
+         istringstream in(pairs);
+         Poly b;
+         in >> b;
+         checksum += b.getCoeff(0);
+      });
+      run("read/parse", size, size, [&printed] {
+         Poly b = Poly::parse(printed);
+         checksum += b.getCoeff(0);
+      });
+      run("save", size, size, [&a] {
+         ostringstream out(ios::binary);
+         a.save(out);
+         checksum += out.tellp();
+      });
+      run("load", size, size, [&saved] {
+         Poly b = Poly::load(saved.data(), saved.size());
+         checksum += b.getCoeff(0);
+      });
+   }
+}
+
+//------------------------------ evaluate ---------------------------------
+// Evaluate a degree 15 Poly at BATCH double points with one batch call
+static void evaluate() {
+   const int BATCH = 10000;
+   static double points[BATCH], values[BATCH];
+   Poly a;
+   for (int e = 0; e < 16; e++)
+      a.setCoeff(e - 8, e);
+   for (int i = 0; i < BATCH; i++)
+      points[i] = i * 1e-4;
+   run("evaluate/double", 16, BATCH, [&a] {
+      a.evaluate(points, values, BATCH);
+      checksum += (long long)values[BATCH - 1];
+   });
+}
+
+//------------------------------ seconds ----------------------------------
+// Time one call of a function
+template <class F>
+static double seconds(F fn) {
+   typedef chrono::steady_clock Clock;
+   Clock::time_point start = Clock::now();
+   fn();
+   return chrono::duration<double>(Clock::now() - start).count();
+}
+
+//points evaluated one at a time only up to here, as it takes O(n^2)
+const int NAIVE_MAX = 1 << 16;
+
+//----------------------------- multipoint --------------------------------
+// Evaluate a degree n - 1 ModPoly at n points one point at a time and
+// with one batch call, which uses the subproduct tree from
+// MOD_TREE_MIN_SIZE points up, then interpolate it back from the values
+static void multipoint(int maxPoints) {
+   typedef ModInt<998244353> Mod;
+   cout << setw(9) << "n" << setw(14) << "one at a time" << setw(10) << "batch"
+        << setw(13) << "interpolate" << "   (ms)" << endl;
+   for (int n = 1024; n <= maxPoints; n *= 4) {
+      ModPoly<998244353> a;
+      vector<Mod> points(n), values(n), naive(n);
+      for (int i = n - 1; i >= 0; i--) {      //top term first: one grow
+         a.setCoeff(Mod(rand()), i);
+         points[i] = Mod(3LL * i + rand() % 3);    //distinct
+      }
+      double oneAtATime = 0;
+      if (n <= NAIVE_MAX)
+         oneAtATime = seconds([&] {
+            for (int i = 0; i < n; i++)
+               naive[i] = a.evaluate(points[i]);
+         });
+      double tree = seconds([&] {
+         a.evaluate(&points[0], &values[0], n);
+      });
+      ModPoly<998244353> back;
+      double interpolate = seconds([&] {
+         back = ModPoly<998244353>::interpolate(&points[0], &values[0], n);
+      });
+      if ((n <= NAIVE_MAX && naive != values) || back != a)
+         cout << "mismatch at n = " << n << endl;
+      cout << setw(9) << n << fixed << setprecision(1) << setw(14);
+      if (n <= NAIVE_MAX)
+         cout << oneAtATime * 1e3;
+      else
+         cout << "-";
+      cout << setw(10) << tree * 1e3 << setw(13) << interpolate * 1e3
+           << endl;
+   }
+}
+
+//----------------------------- parallel ----------------------------------
+// Multiply two Poly64s and two ModPolys of n terms serially and on the
+// thread pool
+static void parallel(int maxTerms) {
+   cout << "threads " << PolyThreadPool::shared().size() << endl;
+   cout << setw(9) << "n" << setw(14) << "Poly64 serial" << setw(10)
+        << "parallel" << setw(15) << "ModPoly serial" << setw(10)
+        << "parallel" << "   (ms)" << endl;
+   for (int n = 4096; n <= maxTerms; n *= 2) {
+      Poly64 a, b, serial, pooled;
+      ModPoly<998244353> c, d, modSerial, modPooled;
+      for (int i = n - 1; i >= 0; i--) {      //top term first: one grow
+         a.setCoeff(rand() - RAND_MAX / 2, i);
+         b.setCoeff(rand() - RAND_MAX / 2, i);
+         c.setCoeff(rand(), i);
+         d.setCoeff(rand(), i);
+      }
+      double times[4];
+      times[0] = seconds([&] {
+         serial = a.multiply(b, PolyBase::MUL_AUTO, PolyBase::EXEC_SERIAL);
+      });
+      times[1] = seconds([&] {
+         pooled = a.multiply(b, PolyBase::MUL_AUTO, PolyBase::EXEC_PARALLEL);
+      });
+      times[2] = seconds([&] {
+         modSerial = c.multiply(d, PolyBase::MUL_AUTO,
+                                PolyBase::EXEC_SERIAL);
+      });
+      times[3] = seconds([&] {
+         modPooled = c.multiply(d, PolyBase::MUL_AUTO,
+                                PolyBase::EXEC_PARALLEL);
+      });
+      if (serial != pooled || modSerial != modPooled)
+         cout << "mismatch at n = " << n << endl;
+      cout << setw(9) << n << fixed << setprecision(1) << setw(14)
+           << times[0] * 1e3 << setw(10) << times[1] * 1e3 << setw(15)
+           << times[2] * 1e3 << setw(10) << times[3] * 1e3 << endl;
+   }
+}
+
+//plain Euclid is only timed up to this degree
+const int EUCLID_MAX = 1 << 15;
+
+//-------------------------------- gcd ------------------------------------
+// Time gcd(A*G, B*G) for random ModPolys A, B of degree n and G of degree
+// n/8, by the Euclidean algorithm on % against ModPoly::gcd() (half-GCD),
+// and resultant(A, B), for n = 1024 up to maxDegree, in milliseconds
+static void gcd(int maxDegree) {
+   typedef ModInt<998244353> Mod;
+   typedef ModPoly<998244353> MP;
+   cout << setw(9) << "n" << setw(10) << "Euclid" << setw(10) << "gcd"
+        << setw(11) << "resultant" << "   (ms)" << endl;
+   for (int n = 1024; n <= maxDegree; n *= 2) {
+      MP a, b, g;
+      for (int i = n; i >= 0; i--) {          //top term first: one grow
+         a.setCoeff(Mod(rand()), i);
+         b.setCoeff(Mod(rand()), i);
+         if (i <= n / 8)
+            g.setCoeff(Mod(rand()), i);
+      }
+      MP x = a * g, y = b * g, euclid, fast;
+      Mod res;
+      double plain = 0;
+      if (n <= EUCLID_MAX)
+         plain = seconds([&] {
+            MP p = x, q = y;
+            while (q != MP()) {
+               MP r = p % q;
+               p = std::move(q);
+               q = std::move(r);
+            }
+            euclid = p;
+         });
+      double half = seconds([&] { fast = MP::gcd(x, y); });
+      double resultant = seconds([&] { res = MP::resultant(a, b); });
+      if ((n <= EUCLID_MAX && (euclid % fast != MP() || fast % euclid != MP()))
+            || fast % g != MP())
+         cout << "mismatch at n = " << n << endl;
+      checksum += res.value();
+      cout << setw(9) << n << fixed << setprecision(1) << setw(10);
+      if (n <= EUCLID_MAX)
+         cout << plain * 1e3;
+      else
+         cout << "-";
+      cout << setw(10) << half * 1e3 << setw(11) << resultant * 1e3 << endl;
+   }
+}
+
+//Horner's rule for compose() only up to here, as it takes n products
+const int HORNER_MAX = 1 << 12;
+
+//------------------------------ compose ----------------------------------
+// Raise a ModPoly of degree n/16 to the 16th power by *= and by pow(),
+// shift one of degree n by Horner's rule in x + c and by taylorShift(),
+// and compose two mod x^n by Horner's rule with mullow() and by compose()
+static void compose(int maxDegree) {
+   typedef ModInt<998244353> Mod;
+   typedef ModPoly<998244353> MP;
+   const int K = 16;
+   cout << setw(9) << "n" << setw(10) << "*= loop" << setw(10) << "pow"
+        << setw(12) << "shift loop" << setw(10) << "shift" << setw(14)
+        << "compose loop" << setw(10) << "compose" << "   (ms)" << endl;
+   for (int n = 256; n <= maxDegree; n *= 4) {
+      MP a, b, small, loop, fast, xc(Mod(1), 1);
+      for (int i = n - 1; i >= 0; i--) {      //top term first: one grow
+         a.setCoeff(Mod(rand()), i);
+         b.setCoeff(Mod(rand()), i);
+      }
+      for (int i = n / K; i >= 0; i--)
+         small.setCoeff(Mod(rand()), i);
+      Mod c(rand());
+      xc += MP(c, 0);
+      bool ok = true;
+      double times[6] = { 0 };
+
+      times[0] = seconds([&] {
+         loop = small;
+         for (int i = 1; i < K; i++)
+            loop *= small;
+      });
+      times[1] = seconds([&] { fast = small.pow(K); });
+      ok = ok && loop == fast;
+
+      times[2] = seconds([&] {
+         loop = MP();
+         for (int i = n - 1; i >= 0; i--)
+            loop = loop * xc + MP(a.getCoeff(i), 0);
+      });
+      times[3] = seconds([&] { fast = a.taylorShift(c); });
+      ok = ok && loop == fast;
+
+      if (n <= HORNER_MAX) {
+         times[4] = seconds([&] {
+            loop = MP();
+            for (int i = n - 1; i >= 0; i--)
+               loop = loop.mullow(b, n) + MP(a.getCoeff(i), 0);
+         });
+      }
+      times[5] = seconds([&] { fast = a.compose(b, n); });
+      ok = ok && (n > HORNER_MAX || loop == fast);
+      if (!ok)
+         cout << "mismatch at n = " << n << endl;
+      checksum += fast.getCoeff(0).value();
+      cout << setw(9) << n << fixed << setprecision(1);
+      for (int i = 0; i < 6; i++) {
+         cout << setw(i == 2 ? 12 : (i == 4 ? 14 : 10));
+         if (i == 4 && n > HORNER_MAX)
+            cout << "-";
+         else
+            cout << times[i] * 1e3;
+      }
+      cout << endl;
+   }
+}
+
+int main(int argc, char* argv[]) {
+   if (argc > 1 && string(argv[1]) == "multipoint") {
+      multipoint((argc > 2) ? atoi(argv[2]) : 1 << 20);
+      return 0;
+   }
+   if (argc > 1 && string(argv[1]) == "gcd") {
+      gcd((argc > 2) ? atoi(argv[2]) : 1 << 17);
+      return 0;
+   }
+   if (argc > 1 && string(argv[1]) == "compose") {
+      compose((argc > 2) ? atoi(argv[2]) : 1 << 14);
+      return 0;
+   }
+   if (argc > 1 && string(argv[1]) == "parallel") {
+      parallel((argc > 2) ? atoi(argv[2]) : 1 << 18);
+      return 0;
+   }
+   for (int i = 1; i < argc; i++) {
+      string arg = argv[i];
+      if (arg == "--csv")
+         options.format = Options::CSV;
+      else if (arg == "--json")
+         options.format = Options::JSON;
+      else if (arg == "--min-time" && i + 1 < argc)
+         options.minSeconds = atof(argv[++i]);
+      else if (arg == "--max-size" && i + 1 < argc)
+         options.maxSize = atoi(argv[++i]);
+      else
+         options.filter = arg;
+   }
+   if (options.format == Options::JSON)
+      cout << "[" << endl;
+   construction();
+   arithmetic();
+   series();
+   multivariate();
+   growth();
+   streams();
+   evaluate();
+   if (options.format == Options::JSON)
+      cout << "\n]" << endl;
+   (options.format == Options::TABLE ? cout : cerr)
+         << "checksum " << checksum << endl;
+   return 0;
+}
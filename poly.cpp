@@ -1,448 +1,2747 @@
-//-----------------------------------------------------------------------//
-// POLY.CPP                                                              //
-// Author: Luke Selbeck                                                  //
-// Date: April 9th, 2014                                                 //
-// Class: CSS 343                                                        //
-//                                                                       //
-// Member function definitions for class Poly                            //
-// Poly holds a polynomial with non-negative exponents                   //
-//-----------------------------------------------------------------------//
-// Polynomial:  defined as a sum of coefficient and exponent pairs,      //
-//     called terms.                                                     //
-//                                                                       //
-//     Term example:       Coefficient  Exponent                         //
-//                               \         /                             //
-//                               +3  *  x^5                              //
-//                                                                       //
-//     Polynomial example: +3*x^5 +7*x^3 -2*x^2 +9*x +1                  //
-//                                                                       //
-// Implementation and assumptions:                                       //
-//   -- terms are stored in an array                                     //
-//         > array position denotates exponent value                     //
-//         > array values denotate coefficient values                    //
-//   -- does not accept non-int coefficient/exponent values              //
-//   -- does not accept non-positive exponent values                     //
-//-----------------------------------------------------------------------//
-
-#include "poly.h"
-
-//-------------------------- Constructor ----------------------------------
-// Default constructor for class Poly
-// Preconditions:   none
-// Postconditions:  
-//       -- an array of size 1 is created  
-//       -- one term is in the array
-//             -- coefficient=0, and exponent=0
-//             -- i.e. 0*x^0
-Poly::Poly() {
-   highestExp = 0;
-   coeffPtr = new int[highestExp + 1];
-   for (int i = highestExp; i >= 0; i--)
-      coeffPtr[i] = 0;
-}
-
-//-------------------------- Constructor ----------------------------------
-// Constructor accepting newCoeff as the coefficient of the 0th term
-// Preconditions:  none
-// Postconditions: 
-//       -- an array of size 1 is created  
-//       -- one term is inserted into the array
-//             -- coefficient=newCoeff, and exponent=0
-//             -- i.e. newCoeff*x^0
-Poly::Poly(int newCoeff) {
-   highestExp = 0;
-   coeffPtr = new int[highestExp + 1];
-   for (int i = highestExp; i >= 0; i--)
-      coeffPtr[i] = 0;
-      
-   coeffPtr[0] = newCoeff;   //array position == exponent value
-} 
-
-//-------------------------- Constructor ----------------------------------
-// Constructor accepting two ints as coefficient and exponent, respectively
-//    of the term to be inserted 
-// Preconditions:  expIsValid() checks for exponent validity
-// Postconditions:
-//       -- an array of size 1 is created  
-//       -- non-positive exponent value throws error message
-//       -- one term is inserted into the array
-//             -- coefficient = newCoeff, and exponent = newExp
-//             -- i.e. newCoeff*x^newExp
-Poly::Poly(int newCoeff, int newExp) {
-   if (expIsValid(newExp)) {
-      highestExp = newExp;
-      coeffPtr = new int[highestExp + 1];
-      for (int i = highestExp; i >= 0; i--)
-         coeffPtr[i] = 0;
-         
-      coeffPtr[newExp] = newCoeff;   //array position == exponent value
-   }
-} 
-
-//------------------------- Copy Constructor ------------------------------
-// Constructor accepting a Poly to be deep copied 
-// Preconditions:  none
-// Postconditions:
-//       -- a Poly an exact copy of the parameter is made
-Poly::Poly(const Poly& toBeCopied) {
-   //*this = toBeCopied;
-   
-   
-   highestExp = toBeCopied.highestExp;
-   coeffPtr = new int[highestExp + 1];
-   for (int i = highestExp; i >= 0; i--)
-      coeffPtr[i] = toBeCopied.coeffPtr[i];
-   
-}
-
-//--------------------------- Destructor ----------------------------------
-// Destructor for class Poly
-// Preconditions:   coeffPtr points to memory on the heap
-// Postconditions:
-//       -- array for coeffPtr is deallocated
-//       -- highestExp = 0
-Poly::~Poly() {
-   delete[] coeffPtr;
-   coeffPtr = NULL;
-   highestExp = 0;
-}
-
-//---------------------------- getCoeff -----------------------------------
-// Get the coefficient of an int exponent
-// Preconditions:
-//       -- coeffPtr points to an array
-//       -- expIsValid() checks for exponent validity
-//       -- exponent is a valid value, otherwise nothing is done
-// Postconditions:  Returns the coefficient value for the exponent
-int Poly::getCoeff(int exponent) const {
-   if (!expIsValid(exponent) || exponent > highestExp) //out of array bounds
-      return 0;
-   else
-      return coeffPtr[exponent];
-}
-
-//---------------------------- setCoeff -----------------------------------
-// Overwrite a term in Poly
-// Preconditions:
-//       -- coeffPtr points to an array
-//       -- expIsValid() checks for exponent validity
-//       -- newExp is a valid exponent value, otherwise nothing is done
-// Postconditions:  
-//       -- params are coefficient and exponent respectively
-//       -- if the exponent already exists within the Poly, that term is
-//          replaced with the new coefficient and exponent pair
-//       -- if the exponent is not already in the Poly, a new term is added
-//          to the Poly, consisting of the new coefficient and new exponent
-void Poly::setCoeff(int newCoeff, int newExp) {
-   if (expIsValid(newExp)) {
-      if (newExp > highestExp) {         
-         resizeArray(newExp + 1);
-         highestExp = newExp;
-      }
-      coeffPtr[newExp] = newCoeff;
-   }
-}
-
-//---------------------------- addCoeff -----------------------------------
-// Add a term to Poly
-// Preconditions:
-//       -- coeffPtr points to an array
-//       -- expIsValid() checks for exponent validity
-//       -- newExp is a valid exponent value, otherwise nothing is done
-//       -- setCoeff() overwrites a term into Poly
-// Postconditions:  
-//       -- params are coefficient and exponent respectively
-//       -- if the exponent already exists within the Poly, that term is
-//          added with the new coefficient and exponent pair
-//       -- if the exponent is not already in the Poly, a new term is added
-//          to the Poly using setCoeff()
-void Poly::addCoeff(int newCoeff, int newExp) {
-   if (expIsValid(newExp)) {
-      if (newExp > highestExp) setCoeff(newCoeff, newExp);
-      else coeffPtr[newExp] += newCoeff;
-   }
-}
-
-//---------------------------- subCoeff -----------------------------------
-// Subtract a term from Poly
-// Preconditions:
-//       -- coeffPtr points to an array
-//       -- addCoeff adds a term to Poly
-//       -- newExp is a valid exponent value, otherwise nothing is done
-// Postconditions:  
-//       -- params are coefficient and exponent respectively
-//       -- if the exponent already exists within the Poly, the new
-//          coefficient and exponent pair is subtracted from the existing
-//          term          
-//       -- if the exponent is not already in the Poly, a new term is added
-//          to the Poly, consisting of the new coefficient's inverse
-//          and new exponent
-void Poly::subCoeff(int newCoeff, int newExp) {
-   addCoeff((-1 * newCoeff), newExp);
-}
-
-//--------------------------- expIsValid ----------------------------------
-// Determines if the int passed is a valid exponent value in Poly
-// Preconditions:  none
-// Postconditions:
-//       -- returns true if exponent >= 0
-//       -- returns false if otherwise, and throws a cerr message
-bool Poly::expIsValid(int exponent) const {
-   return exponent >= 0;
-}
-
-//--------------------------- resizeArray ---------------------------------
-// Copies coeffPtr's array into a new array of newSize
-// **WARNING** this resize should only be used if you are going to insert a 
-//             term into the last element, and then assign highestExp to
-//             that last element after this method is finished.  Otherwise,
-//             it screws everything up because highestExp isn't set to the
-//             right place.
-// **NOTE** -- newSize should be greater than highestExp+1, otherwise, loss
-//             of data
-// Preconditions:
-//       -- coeffPtr points to an array
-// Postconditions:
-//       -- coeffPtr points to a new array of size newSize, with all the
-//          old array elements copied over
-//       -- the old array is deallocated
-void Poly::resizeArray(int newSize) {
-   int* tmp = new int[newSize];
-   
-   for (int i = 0; i < newSize; i++)
-      tmp[i] = 0;
-   
-   for (int i = 0; i <= highestExp; i++) 
-      tmp[i] = coeffPtr[i];
-      
-   delete[] coeffPtr;
-   coeffPtr = tmp;
-   tmp = NULL;
-}
-
-//------------------------------  +  --------------------------------------
-// Overloaded addition operator; add 2 Polys
-// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
-//       least 1
-// Postconditions:  a Poly is returned, which is the sum of this object and
-//       rhs
-const Poly Poly::operator+(const Poly& rhs) const {
-   Poly sum;
-   sum = *this;
-   for (int i = rhs.highestExp; i >= 0; i--)
-      sum.addCoeff(rhs.coeffPtr[i], i);
-   return sum;
-}
-
-
-//------------------------------  +  --------------------------------------
-// Overloaded addition operator; add a Poly and an int
-// Preconditions:   coeffPtr points to array with size at least 1
-// Postconditions:  a Poly is returned, which is the sum of this object and
-//       int
-const Poly Poly::operator+(int rhs) const {
-   Poly sum;
-   sum = *this;
-   sum.addCoeff(rhs, 0);
-   return sum;
-}
-
-//------------------------------  -  --------------------------------------
-// Overloaded subtraction operator; subtract 2 Polys
-// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
-//       least 1
-// Postconditions:  a Poly is returned, which is the negation of this
-//       object and rhs  i.e. this - rhs
-const Poly Poly::operator-(const Poly& rhs) const {
-   Poly negation;
-   negation = *this;
-   for (int i = rhs.highestExp; i >= 0; i--)
-         negation.subCoeff(rhs.coeffPtr[i], i);
-   return negation;
-}
-
-
-//------------------------------  -  --------------------------------------
-// Overloaded subtraction operator; subtract an int from a Poly
-// Preconditions:   coeffPtr points to array with size at least 1
-// Postconditions:  a Poly is returned, which is the negation of this
-//       object and the int
-const Poly Poly::operator-(int rhs) const {
-   Poly negation;
-   negation = *this;
-   negation.subCoeff(rhs, 0);
-   return negation;
-}
-
-//------------------------------  *  --------------------------------------
-// Overloaded multiplication operator; multiply 2 Polys
-// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
-//       least 1
-// Postconditions:  a Poly is returned, which is the product of this object
-//       and rhs  
-const Poly Poly::operator*(const Poly& rhs) const {
-   Poly product;
-   for (int i = highestExp; i >= 0; i--)
-      for (int j = rhs.highestExp; j >= 0; j--)
-         product.addCoeff((coeffPtr[i] * rhs.coeffPtr[j]), (i + j));
-   return product;
-}
-
-
-//------------------------------  *  --------------------------------------
-// Overloaded multiplication operator; multiply a Poly and an int
-// Preconditions:   coeffPtr points to array with size at least 1
-// Postconditions:  a Poly is returned, which is the product of this object
-//       and the int
-const Poly Poly::operator*(int rhs) const {
-   Poly product;
-   for (int i = highestExp; i >= 0; i--)
-      product.setCoeff((coeffPtr[i] * rhs), i);
-   return product;
-}
-
-//------------------------------  =  --------------------------------------
-// Overloaded assignment operator; current object = parameter
-// Preconditions:
-//       -- rhs.coeffPtr points to an array of at least size 1
-//       -- setCoeff overwrites a term into Poly
-// Postconditions:
-//       -- this object's array is deleted, and a new one with size equal
-//          to rhs's array is created
-//       -- all the terms from rhs's array are deep copied to this object's
-//          array
-Poly& Poly::operator=(const Poly& rhs) {  
-   if (*this == rhs)
-      return *this;
-      
-   delete[] coeffPtr;
-   coeffPtr = new int[rhs.highestExp + 1];
-   highestExp = rhs.highestExp;
-   
-   for (int i = highestExp; i >= 0; i--)
-      setCoeff(rhs.coeffPtr[i], i);
-   
-   return *this;
-}
-
-//-----------------------------  +=  --------------------------------------
-// current object += parameter
-// Preconditions:
-//       -- rhs.coeffPtr points to an array of at least size 1
-//       -- addCoeff() adds a term to Poly
-// Postconditions:
-//       -- all the terms from rhs's array are passed into this object's
-//          array using addCoeff()
-Poly& Poly::operator+=(const Poly& rhs) {
-   for (int i = rhs.highestExp; i >= 0; i--)
-      addCoeff(rhs.coeffPtr[i], i);
-   return *this;
-}
-
-//-----------------------------  -=  --------------------------------------
-// current object -= parameter
-// Preconditions:
-//       -- rhs.coeffPtr points to an array of at least size 1
-//       -- subCoeff() subtracts a term from Poly
-// Postconditions:
-//       -- all the terms from rhs's array are passed into this object's
-//          array using subCoeff()
-Poly& Poly::operator-=(const Poly& rhs) {
-   for (int i = rhs.highestExp; i >= 0; i--)
-      subCoeff(rhs.coeffPtr[i], i);
-   return *this;
-}
-
-//-----------------------------  *=  --------------------------------------
-// current object *= parameter
-// Preconditions:   rhs.coeffPtr points to an array of at least size 1
-// Postconditions:  *this is assigned to be the product of this and rhs
-Poly& Poly::operator*=(const Poly& rhs) {
-   // I couldn't find a more efficient way than this, which is the same as
-   // return *this = *this * rhs
-   Poly product;
-   for (int i = highestExp; i >= 0; i--)
-      for (int j = rhs.highestExp; j >= 0; j--)
-         product.addCoeff((coeffPtr[i] * rhs.coeffPtr[j]), (i + j));
-   *this = product;
-   return *this;
-}
-
-//-----------------------------  ==  --------------------------------------
-// Determine if two Polys are equal
-// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
-//       least 1
-// Postconditions:  
-//       -- true is returned if all terms in this object and rhs are equal
-//       -- false is returned if otherwise
-bool Poly::operator==(const Poly& rhs) const {
-   if (highestExp != rhs.highestExp) 
-      return false;
-   for (int i = highestExp; i >= 0; i--)
-      if (coeffPtr[i] != rhs.coeffPtr[i]) 
-         return false;
-   return true;
-}
-
-//-----------------------------  !=  --------------------------------------
-// Determine if two Polys are not equal
-// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
-//       least 1
-// Postconditions:  
-//       -- false is returned if all terms in this object and rhs are equal
-//       -- true is returned if otherwise
-bool Poly::operator!=(const Poly& rhs) const {
-   return !(*this == rhs);
-}
-
-//-----------------------------  <<  --------------------------------------
-// Overloaded output operator for class Poly
-// Preconditions:   coeffPtr must point to an array
-// Postconditions:  prints polynomial in this fashion, with no trailing endl
-//          +3x^5 +7x^3 -2x^2 +9x +1
-//          note: includes positive/negative sign for first coefficient
-ostream& operator<<(ostream& out, const Poly& a) {
-   for (int i = a.highestExp; i >= 0; i--) {
-      //print coefficient
-      if (a.coeffPtr[i] > 0) {
-         out << " +" << a.coeffPtr[i];
-      } else if (a.coeffPtr[i] < 0) {
-         out << " " << a.coeffPtr[i];
-      }
-      
-      //print exponent
-      if (a.coeffPtr[i] != 0) {
-         if (i > 1)
-            out << "x^" << i;
-         else if (i == 1)
-            out << "x";
-      }
-   }
-   return out;
-}
-
-//-----------------------------  >>  --------------------------------------
-// Overloaded input operator for class Poly; overwrites terms into Poly
-// *WARNING**  must be inputted in the specified format:
-//       [newCoeff] [newExp]   [newCoeff] [newExp] ...etc... -1 -1
-//       -- input "-1 -1" to end the input stream
-// Preconditions:
-//       -- coeffPtr must point to an array
-// Postconditions:  takes two ints as coefficient and exponent, does no
-//    error checking, inserts/overwrites term into Poly
-istream& operator>>(istream& in, Poly& rhs) {
-   int newCoeff = -1;
-   int newExp = -1;
-   bool done = false;
-   
-   while (!done) {      
-      in >> newCoeff;
-      in >> newExp;
-      if (newCoeff == -1 && newExp == -1)
-         done = true;
-      else
-         rhs.setCoeff(newCoeff, newExp);
-   }
-   return in;
-}
-
+//-----------------------------------------------------------------------//
+// POLY.CPP                                                              //
+// Author: Luke Selbeck                                                  //
+// Date: April 9th, 2014                                                 //
+// Class: CSS 343                                                        //
+//                                                                       //
+// Member function definitions for class BasicPoly, and the coefficient  //
+// types they are instantiated for                                       //
+// Poly holds a polynomial with non-negative exponents                   //
+//-----------------------------------------------------------------------//
+// Polynomial:  defined as a sum of coefficient and exponent pairs,      //
+//     called terms.                                                     //
+//                                                                       //
+//     Term example:       Coefficient  Exponent                         //
+//                               \         /                             //
+//                               +3  *  x^5                              //
+//                                                                       //
+//     Polynomial example: +3*x^5 +7*x^3 -2*x^2 +9*x +1                  //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- terms are stored in one of two layouts                           //
+//      DENSE:  terms are stored in an array                             //
+//         > array position denotates exponent value                     //
+//         > array values denotate coefficient values                    //
+//      SPARSE: only nonzero terms are stored                            //
+//         > (coefficient, exponent) pairs sorted by exponent            //
+//   -- the layout is picked from the term density unless one is         //
+//      requested with setRepresentation()                               //
+//   -- coefficients are of type T; see the instantiations at the end    //
+//   -- does not accept non-int exponent values                          //
+//   -- does not accept non-positive exponent values                     //
+//-----------------------------------------------------------------------//
+
+#include "poly.h"
+#include "polycache.h"
+#include "polycompose.h"
+#include "polygcd.h"
+#include "polymul.h"
+#include "polyntt.h"
+#include "polyseries.h"
+#include "polysparse.h"
+#include "polytree.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+//--------------------------- termExpLess ---------------------------------
+// Orders SPARSE terms by increasing exponent, for sort()
+template <class Term>
+static bool termExpLess(const Term& a, const Term& b) {
+   return a.exp < b.exp;
+}
+
+//-------------------------- Constructor ----------------------------------
+// Default constructor for class Poly
+// Preconditions:   none
+// Postconditions:  
+//       -- an array of size 1 is created  
+//       -- one term is in the array
+//             -- coefficient=0, and exponent=0
+//             -- i.e. 0*x^0
+template <class T>
+BasicPoly<T>::BasicPoly() {
+   highestExp = 0;
+   capacity = highestExp + 1;
+   sparse = false;
+   storage = AUTO;
+   allocator = PolyAllocator::getDefault();
+   coeffPtr = NULL;
+   coeffPtr = allocArray(capacity);
+   for (int i = capacity - 1; i >= 0; i--)
+      coeffPtr[i] = 0;
+}
+
+//-------------------------- Constructor ----------------------------------
+// Constructor accepting newCoeff as the coefficient of the 0th term
+// Preconditions:  none
+// Postconditions: 
+//       -- an array of size 1 is created  
+//       -- one term is inserted into the array
+//             -- coefficient=newCoeff, and exponent=0
+//             -- i.e. newCoeff*x^0
+template <class T>
+BasicPoly<T>::BasicPoly(T newCoeff) {
+   highestExp = 0;
+   capacity = highestExp + 1;
+   sparse = false;
+   storage = AUTO;
+   allocator = PolyAllocator::getDefault();
+   coeffPtr = NULL;
+   coeffPtr = allocArray(capacity);
+   for (int i = capacity - 1; i >= 0; i--)
+      coeffPtr[i] = 0;
+      
+   coeffPtr[0] = newCoeff;   //array position == exponent value
+} 
+
+//-------------------------- Constructor ----------------------------------
+// Constructor accepting two ints as coefficient and exponent, respectively
+//    of the term to be inserted 
+// Preconditions:  expIsValid() checks for exponent validity
+// Postconditions:
+//       -- an array of size 1 is created, or a single SPARSE term if
+//          newExp is large enough for wantsSparse()
+//       -- non-positive exponent value or a zero coefficient creates
+//          the Poly 0*x^0; for a zero coefficient the array still has
+//          room for newExp, so a product can be written into it
+//       -- one term is inserted into the array
+//             -- coefficient = newCoeff, and exponent = newExp
+//             -- i.e. newCoeff*x^newExp
+template <class T>
+BasicPoly<T>::BasicPoly(T newCoeff, int newExp) {
+   highestExp = 0;
+   capacity = 0;
+   sparse = false;
+   storage = AUTO;
+   allocator = PolyAllocator::getDefault();
+   coeffPtr = NULL;
+   if (!expIsValid(newExp)) {
+      resetDense(0);
+   } else if (wantsSparse(newExp + 1, (newCoeff != 0) ? 1 : 0, false)) {
+      sparse = true;
+      if (newCoeff != 0) {
+         highestExp = newExp;
+         Term t = { newCoeff, newExp };
+         terms.push_back(t);
+      }
+   } else {
+      resetDense(newExp);
+      coeffPtr[newExp] = newCoeff;   //array position == exponent value
+      normalize();
+   }
+} 
+
+//------------------------- Copy Constructor ------------------------------
+// Constructor accepting a Poly to be deep copied 
+// Preconditions:  none
+// Postconditions:
+//       -- a Poly an exact copy of the parameter is made, in the same
+//          layout
+//       -- an allocated DENSE array is shared with shareArray() instead
+//          of copied
+template <class T>
+BasicPoly<T>::BasicPoly(const BasicPoly& toBeCopied) {
+   highestExp = toBeCopied.highestExp;
+   sparse = toBeCopied.sparse;
+   storage = toBeCopied.storage;
+   terms = toBeCopied.terms;
+   allocator = PolyAllocator::getDefault();
+   coeffPtr = NULL;
+   capacity = 0;
+   POLY_STATS_ADD(COPIES, 1);
+   if (!sparse && !shareArray(toBeCopied)) {
+      capacity = highestExp + 1;
+      coeffPtr = allocArray(capacity);
+      for (int i = highestExp; i >= 0; i--)
+         coeffPtr[i] = toBeCopied.coeffPtr[i];
+      for (int i = highestExp + 1; i < capacity; i++)
+         coeffPtr[i] = 0;
+   }
+   copyCache(toBeCopied);
+}
+
+//------------------------- Move Constructor ------------------------------
+// Constructor taking over the terms of a Poly that is about to go away
+// Preconditions:  none
+// Postconditions:
+//       -- this Poly holds the parameter's terms and array, nothing is
+//          copied or allocated
+//       -- the parameter is left as the Poly 0*x^0 with no array, i.e.
+//          SPARSE with no terms
+template <class T>
+BasicPoly<T>::BasicPoly(BasicPoly&& toBeMoved) noexcept {
+   POLY_STATS_ADD(MOVES, 1);
+   highestExp = toBeMoved.highestExp;
+   capacity = toBeMoved.capacity;
+   sparse = toBeMoved.sparse;
+   storage = toBeMoved.storage;
+   allocator = toBeMoved.allocator;
+   coeffPtr = toBeMoved.coeffPtr;
+   if (coeffPtr == toBeMoved.inlineCoeffs) {
+      for (int i = INLINE_SIZE - 1; i >= 0; i--)
+         inlineCoeffs[i] = toBeMoved.inlineCoeffs[i];
+      coeffPtr = inlineCoeffs;
+   }
+   terms.swap(toBeMoved.terms);
+   copyCache(toBeMoved);
+
+   toBeMoved.coeffPtr = NULL;
+   toBeMoved.capacity = 0;
+   toBeMoved.highestExp = 0;
+   toBeMoved.sparse = true;
+   toBeMoved.changed();
+}
+
+//--------------------------- Destructor ----------------------------------
+// Destructor for class Poly
+// Preconditions:   coeffPtr points to memory on the heap, or is NULL
+// Postconditions:
+//       -- array for coeffPtr is given back to its allocator
+//       -- highestExp = 0
+template <class T>
+BasicPoly<T>::~BasicPoly() {
+   freeArray();
+   highestExp = 0;
+}
+
+//---------------------------- getCoeff -----------------------------------
+// Get the coefficient of an int exponent
+// Preconditions:
+//       -- coeffPtr points to an array, or the SPARSE layout is in use
+//       -- expIsValid() checks for exponent validity
+//       -- exponent is a valid value, otherwise nothing is done
+// Postconditions:  Returns the coefficient value for the exponent
+template <class T>
+T BasicPoly<T>::getCoeff(int exponent) const {
+   if (!expIsValid(exponent) || exponent > highestExp) //out of array bounds
+      return 0;
+   if (sparse) {
+      int pos = findTerm(exponent);
+      if (pos < (int)terms.size() && terms[pos].exp == exponent)
+         return terms[pos].coeff;
+      return 0;
+   }
+   return coeffPtr[exponent];
+}
+
+//---------------------------- setCoeff -----------------------------------
+// Overwrite a term in Poly
+// Preconditions:
+//       -- coeffPtr points to an array, or the SPARSE layout is in use
+//       -- expIsValid() checks for exponent validity
+//       -- newExp is a valid exponent value, otherwise nothing is done
+// Postconditions:  
+//       -- params are coefficient and exponent respectively
+//       -- if the exponent already exists within the Poly, that term is
+//          replaced with the new coefficient and exponent pair
+//       -- if the exponent is not already in the Poly, a new term is added
+//          to the Poly, consisting of the new coefficient and new exponent
+//       -- under AUTO, growing past highestExp may switch the layout
+//       -- zeroing the leading term lowers highestExp to the next
+//          nonzero term; a zero above highestExp changes nothing
+template <class T>
+void BasicPoly<T>::setCoeff(T newCoeff, int newExp) {
+   if (!expIsValid(newExp))
+      return;
+
+   if (sparse) {
+      int pos = findTerm(newExp);
+      bool found = pos < (int)terms.size() && terms[pos].exp == newExp;
+      recordTerm(newExp, found ? terms[pos].coeff : T(0), newCoeff);
+      if (found && newCoeff == 0) {
+         terms.erase(terms.begin() + pos);
+      } else if (found) {
+         terms[pos].coeff = newCoeff;
+      } else if (newCoeff != 0) {
+         Term t = { newCoeff, newExp };
+         terms.insert(terms.begin() + pos, t);
+      }
+      normalize();
+      if (storage == AUTO && 
+            !wantsSparse(highestExp + 1, (int)terms.size(), true))
+         toDense();
+      return;
+   }
+
+   if (newExp > highestExp) {
+      if (newCoeff == 0)
+         return;
+      if (storage == AUTO && wantsSparse(newExp + 1, termCount() + 1,
+                                         false)) {
+         toSparse();
+         setCoeff(newCoeff, newExp);
+         return;
+      }
+      growDense(newExp);
+   }
+   unshare();
+   recordTerm(newExp, coeffPtr[newExp], newCoeff);
+   coeffPtr[newExp] = newCoeff;
+   if (newCoeff == 0 && newExp == highestExp)
+      normalize();
+}
+
+//---------------------------- addCoeff -----------------------------------
+// Add a term to Poly
+// Preconditions:
+//       -- coeffPtr points to an array, or the SPARSE layout is in use
+//       -- expIsValid() checks for exponent validity
+//       -- newExp is a valid exponent value, otherwise nothing is done
+//       -- setCoeff() overwrites a term into Poly
+// Postconditions:  
+//       -- params are coefficient and exponent respectively
+//       -- if the exponent already exists within the Poly, that term is
+//          added with the new coefficient and exponent pair
+//       -- if the exponent is not already in the Poly, a new term is added
+//          to the Poly using setCoeff()
+//       -- the sum is written by setCoeff(), which keeps the cached term
+//          count, hash and highestExp up to date
+template <class T>
+void BasicPoly<T>::addCoeff(T newCoeff, int newExp) {
+   if (expIsValid(newExp)) {
+      if (newExp > highestExp) setCoeff(newCoeff, newExp);
+      else setCoeff(getCoeff(newExp) + newCoeff, newExp);
+   }
+}
+
+//---------------------------- subCoeff -----------------------------------
+// Subtract a term from Poly
+// Preconditions:
+//       -- coeffPtr points to an array, or the SPARSE layout is in use
+//       -- addCoeff adds a term to Poly
+//       -- newExp is a valid exponent value, otherwise nothing is done
+// Postconditions:  
+//       -- params are coefficient and exponent respectively
+//       -- if the exponent already exists within the Poly, the new
+//          coefficient and exponent pair is subtracted from the existing
+//          term          
+//       -- if the exponent is not already in the Poly, a new term is added
+//          to the Poly, consisting of the new coefficient's inverse
+//          and new exponent
+template <class T>
+void BasicPoly<T>::subCoeff(T newCoeff, int newExp) {
+   addCoeff((-1 * newCoeff), newExp);
+}
+
+//--------------------------- expIsValid ----------------------------------
+// Determines if the int passed is a valid exponent value in Poly
+// Preconditions:  none
+// Postconditions:
+//       -- returns true if exponent >= 0
+//       -- returns false if otherwise, and throws a cerr message
+template <class T>
+bool BasicPoly<T>::expIsValid(int exponent) const {
+   return exponent >= 0;
+}
+
+//------------------------ setRepresentation ------------------------------
+// Choose the storage layout of this Poly
+// Preconditions:   none
+// Postconditions:
+//       -- the terms are converted to the requested layout; AUTO picks
+//          the layout from the term density, now and whenever the Poly
+//          grows
+//       -- the terms themselves are unchanged
+template <class T>
+void BasicPoly<T>::setRepresentation(Representation rep) {
+   storage = rep;
+   chooseRepresentation();
+}
+
+//------------------------ getRepresentation ------------------------------
+// Get the storage layout requested for this Poly
+// Preconditions:   none
+// Postconditions:  returns AUTO, DENSE or SPARSE as last requested
+template <class T>
+PolyBase::Representation BasicPoly<T>::getRepresentation() const {
+   return storage;
+}
+
+//----------------------------- isSparse ----------------------------------
+// Determine which layout currently holds the terms
+// Preconditions:   none
+// Postconditions:  returns true if the SPARSE layout is in use
+template <class T>
+bool BasicPoly<T>::isSparse() const {
+   return sparse;
+}
+
+//----------------------------- reserve -----------------------------------
+// Make room in the DENSE array for a number of exponents
+// Preconditions:   none
+// Postconditions:  the array has room for at least newCapacity exponents,
+//       so setCoeff() below it does not reallocate.  Does nothing for the
+//       SPARSE layout
+template <class T>
+void BasicPoly<T>::reserve(int newCapacity) {
+   if (!sparse && newCapacity > capacity)
+      resizeArray(newCapacity);
+}
+
+//--------------------------- getCapacity ---------------------------------
+// Get the number of exponents the DENSE array has room for
+// Preconditions:   none
+// Postconditions:  returns the array size, >= highestExp + 1, or 0 for the
+//       SPARSE layout
+template <class T>
+int BasicPoly<T>::getCapacity() const {
+   return capacity;
+}
+
+//---------------------------- termCount ----------------------------------
+// Count the nonzero terms of Poly
+// Preconditions:   none
+// Postconditions:  returns the number of terms with a nonzero coefficient:
+//       the SPARSE term count, or the DENSE count cached in knownTerms
+template <class T>
+int BasicPoly<T>::termCount() const {
+   if (sparse)
+      return (int)terms.size();
+   int count = knownTerms.load(memory_order_relaxed);
+   if (count >= 0)
+      return count;
+   count = 0;
+   for (int i = highestExp; i >= 0; i--)
+      if (coeffPtr[i] != 0)
+         count++;
+   knownTerms.store(count, memory_order_relaxed);
+   return count;
+}
+
+//------------------------------- hash ------------------------------------
+// 64-bit hash of the value of Poly
+// Preconditions:   none
+// Postconditions:  returns the sum of termHash() over the nonzero terms,
+//       cached in knownHash.  The flag is set after the hash is stored,
+//       so a thread that sees it set also sees the hash
+template <class T>
+uint64_t BasicPoly<T>::hash() const {
+   if (hashKnown.load(memory_order_acquire))
+      return knownHash.load(memory_order_relaxed);
+   uint64_t sum = 0;
+   if (sparse) {
+      for (int i = (int)terms.size() - 1; i >= 0; i--)
+         sum += termHash(terms[i].exp, terms[i].coeff);
+   } else {
+      int count = 0;
+      for (int i = highestExp; i >= 0; i--) {
+         if (coeffPtr[i] != 0) {
+            sum += termHash(i, coeffPtr[i]);
+            count++;
+         }
+      }
+      knownTerms.store(count, memory_order_relaxed);
+   }
+   knownHash.store(sum, memory_order_relaxed);
+   hashKnown.store(true, memory_order_release);
+   return sum;
+}
+
+//----------------------------- termHash ----------------------------------
+// Hash of one term for hash()
+// Preconditions:   none
+// Postconditions:  returns the exponent and the 8-byte words of the
+//       polyio.h encoding of the coefficient, each folded in by the
+//       SplitMix64 finalizer
+template <class T>
+uint64_t BasicPoly<T>::termHash(int exponent, T coeff) {
+   typedef polyio::Codec<T> Codec;
+   unsigned char bytes[16] = { 0 };
+   Codec::encode(coeff, bytes);
+   uint64_t h = (uint64_t)exponent;
+   for (int k = 0; k < Codec::WIDTH; k += 8) {
+      h ^= polyio::getLE(bytes + k, min(8, Codec::WIDTH - k));
+      h += 0x9e3779b97f4a7c15ULL;
+      h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+      h ^= h >> 31;
+   }
+   return h;
+}
+
+//---------------------------- recordTerm ---------------------------------
+// Update the cached term count and hash for one coefficient changing
+// Preconditions:   called with the exponent and the old and new
+//       coefficients, before or after the change
+// Postconditions:  a known count or hash is adjusted in O(1): the hash is
+//       a sum over terms, so the old term's hash is taken out and the new
+//       one's put in
+template <class T>
+void BasicPoly<T>::recordTerm(int exponent, T oldCoeff, T newCoeff) {
+   int count = knownTerms.load(memory_order_relaxed);
+   if (count >= 0)
+      knownTerms.store(count + (newCoeff != 0) - (oldCoeff != 0),
+                       memory_order_relaxed);
+   if (hashKnown.load(memory_order_relaxed)) {
+      uint64_t sum = knownHash.load(memory_order_relaxed);
+      if (oldCoeff != 0)
+         sum -= termHash(exponent, oldCoeff);
+      if (newCoeff != 0)
+         sum += termHash(exponent, newCoeff);
+      knownHash.store(sum, memory_order_relaxed);
+   }
+}
+
+//----------------------------- changed -----------------------------------
+// Forget the cached term count and hash
+// Preconditions:   none
+// Postconditions:  termCount() and hash() count the terms again
+template <class T>
+void BasicPoly<T>::changed() {
+   knownTerms.store(-1, memory_order_relaxed);
+   hashKnown.store(false, memory_order_relaxed);
+}
+
+//---------------------------- copyCache ----------------------------------
+// Take the cached term count and hash of a Poly with the same terms
+// Preconditions:   source holds the terms this Poly now holds
+// Postconditions:  the caches are those of source
+template <class T>
+void BasicPoly<T>::copyCache(const BasicPoly& source) {
+   bool known = source.hashKnown.load(memory_order_acquire);
+   knownTerms.store(source.knownTerms.load(memory_order_relaxed),
+                    memory_order_relaxed);
+   knownHash.store(source.knownHash.load(memory_order_relaxed),
+                   memory_order_relaxed);
+   hashKnown.store(known, memory_order_relaxed);
+}
+
+//---------------------------- normalize ----------------------------------
+// Lower highestExp to the true degree of Poly
+// Preconditions:   none
+// Postconditions:  highestExp is the exponent of the last SPARSE term, or
+//       of the highest nonzero DENSE coefficient found by
+//       polytext::lastNonzero(); 0 for the zero Poly.  The DENSE array
+//       keeps its size, and the positions above highestExp are zero
+template <class T>
+void BasicPoly<T>::normalize() {
+   if (sparse)
+      highestExp = terms.empty() ? 0 : terms.back().exp;
+   else
+      highestExp = max(0, polytext::lastNonzero(coeffPtr, highestExp));
+}
+
+//--------------------------- getAllocator --------------------------------
+// Get the allocator the DENSE array comes from
+// Preconditions:   none
+// Postconditions:  returns the allocator, the thread's default when this
+//       Poly was made unless it was moved from another Poly or changed
+//       with setAllocator()
+template <class T>
+PolyAllocator* BasicPoly<T>::getAllocator() const {
+   return allocator;
+}
+
+//--------------------------- setAllocator --------------------------------
+// Change the allocator the DENSE array comes from
+// Preconditions:   newAllocator outlives this Poly; NULL means the
+//       thread's default allocator
+// Postconditions:  the DENSE array is copied into an array from
+//       newAllocator and the old one is let go of; the terms are
+//       unchanged
+template <class T>
+void BasicPoly<T>::setAllocator(PolyAllocator* newAllocator) {
+   if (newAllocator == NULL)
+      newAllocator = PolyAllocator::getDefault();
+   if (newAllocator == allocator)
+      return;
+   if (coeffPtr == NULL || coeffPtr == inlineCoeffs) {
+      allocator = newAllocator;
+      return;
+   }
+   PolyAllocator* oldAllocator = allocator;
+   int size = capacity;
+   allocator = newAllocator;
+   T* tmp = allocArray(size);
+   for (int i = capacity - 1; i >= 0; i--)
+      tmp[i] = coeffPtr[i];
+   for (int i = capacity; i < size; i++)
+      tmp[i] = 0;
+   allocator = oldAllocator;
+   freeArray();
+   allocator = newAllocator;
+   coeffPtr = tmp;
+   capacity = size;
+}
+
+//---------------------------- denseCoeffs --------------------------------
+// The coefficients of Poly up to its highest nonzero one, as an array
+// Preconditions:   none
+// Postconditions:  returns coeffPtr when DENSE, else scratch filled with
+//       the SPARSE terms; n is the number of coefficients, 0 for the zero
+//       Poly
+template <class T>
+const T* BasicPoly<T>::denseCoeffs(vector<T>& scratch, int& n) const {
+   return lowCoeffs(scratch, INT_MAX, n);
+}
+
+//----------------------------- lowCoeffs ---------------------------------
+// The coefficients of Poly below x^limit, as an array
+// Preconditions:   none
+// Postconditions:  returns coeffPtr when DENSE, else scratch filled with
+//       the SPARSE terms below the limit; n is the number of coefficients
+//       up to the highest nonzero one below the limit
+template <class T>
+const T* BasicPoly<T>::lowCoeffs(vector<T>& scratch, int limit,
+                                 int& n) const {
+   if (!sparse) {
+      n = polytext::lastNonzero(coeffPtr, min(highestExp, limit - 1)) + 1;
+      return coeffPtr;
+   }
+   size_t count = 0;
+   while (count < terms.size() && terms[count].exp < limit)
+      count++;
+   n = (count == 0) ? 0 : terms[count - 1].exp + 1;
+   scratch.assign(n, T(0));
+   for (size_t i = 0; i < count; i++)
+      scratch[terms[i].exp] = terms[i].coeff;
+   return scratch.data();
+}
+
+//---------------------------- sparseTerms --------------------------------
+// The nonzero terms of Poly, sorted by increasing exponent
+// Preconditions:   none
+// Postconditions:  returns terms' array when SPARSE, else scratch filled
+//       from the DENSE array; n is the number of terms
+template <class T>
+const typename BasicPoly<T>::Term*
+BasicPoly<T>::sparseTerms(vector<Term>& scratch, int& n) const {
+   if (sparse) {
+      n = (int)terms.size();
+      return terms.data();
+   }
+   getTerms(scratch);
+   n = (int)scratch.size();
+   return scratch.data();
+}
+
+//----------------------------- fromDense ---------------------------------
+// Build a Poly from an array of n coefficients
+// Preconditions:   none
+// Postconditions:  returns the Poly, in the layout picked by
+//       chooseRepresentation(), without leading zeros; n == 0 or all
+//       zero coefficients give the zero Poly
+template <class T>
+BasicPoly<T> BasicPoly<T>::fromDense(const T* coeffs, int n) {
+   BasicPoly result;
+   while (n > 0 && coeffs[n - 1] == T(0))
+      n--;
+   if (n == 0)
+      return result;
+   result.resetDense(n - 1);
+   for (int i = n - 1; i >= 0; i--)
+      result.coeffPtr[i] = coeffs[i];
+   result.chooseRepresentation();
+   return result;
+}
+
+//---------------------------- storedSize ---------------------------------
+// Number of coefficients or terms Poly stores
+// Preconditions:   none
+// Postconditions:  returns highestExp + 1 for DENSE, the term count for
+//       SPARSE
+template <class T>
+int BasicPoly<T>::storedSize() const {
+   return sparse ? (int)terms.size() : highestExp + 1;
+}
+
+//--------------------------- resizeArray ---------------------------------
+// Copies coeffPtr's array into a new array of newSize
+// **NOTE** -- newSize should be greater than highestExp+1, otherwise, loss
+//             of data
+// Preconditions:
+//       -- coeffPtr points to an array
+// Postconditions:
+//       -- coeffPtr points to a new array of size newSize, with all the
+//          old array elements copied over and the rest zeroed
+//       -- capacity = newSize, highestExp is unchanged
+//       -- the old array is deallocated
+template <class T>
+void BasicPoly<T>::resizeArray(int newSize) {
+   POLY_STATS_ADD(RESIZES, 1);
+   T* tmp = allocArray(newSize);
+   
+   for (int i = 0; i < newSize; i++)
+      tmp[i] = 0;
+   
+   for (int i = 0; i <= highestExp; i++) 
+      tmp[i] = coeffPtr[i];
+      
+   freeArray();
+   coeffPtr = tmp;
+   capacity = newSize;
+   tmp = NULL;
+}
+
+//---------------------------- allocArray ---------------------------------
+// Get an uninitialized array of size ints
+// Preconditions:   size >= 1
+// Postconditions:  returns inlineCoeffs if it is large enough and not in
+//       use, and raises size to INLINE_SIZE; otherwise returns an array
+//       from allocator, COUNT_BYTES into a block that starts with its
+//       count, set to 1.  coeffPtr and capacity are unchanged
+template <class T>
+T* BasicPoly<T>::allocArray(int& size) {
+   if (size <= INLINE_SIZE && coeffPtr != inlineCoeffs) {
+      size = INLINE_SIZE;
+      return inlineCoeffs;
+   }
+   POLY_STATS_ADD(ALLOCATIONS, 1);
+   POLY_STATS_ADD(BYTES, (long long)size * sizeof(T));
+   char* block = static_cast<char*>(
+         allocator->allocate(size * sizeof(T) + COUNT_BYTES));
+   new (block) atomic<int>(1);
+   return reinterpret_cast<T*>(block + COUNT_BYTES);
+}
+
+//---------------------------- freeArray ----------------------------------
+// Let go of coeffPtr's array
+// Preconditions:   coeffPtr is NULL, inlineCoeffs, or came from allocator
+//       with capacity ints
+// Postconditions:  coeffPtr is NULL and capacity is 0.  The count of an
+//       array from allocator is lowered, and the one Poly that takes it
+//       to 0 gives the array back; a count of 1 is only this Poly's, so
+//       it is given back without the atomic decrement
+template <class T>
+void BasicPoly<T>::freeArray() {
+   if (coeffPtr != NULL && coeffPtr != inlineCoeffs) {
+      atomic<int>& count = refCount();
+      if (count.load(memory_order_acquire) == 1 ||
+            count.fetch_sub(1, memory_order_acq_rel) == 1) {
+         POLY_STATS_ADD(FREES, 1);
+         allocator->deallocate(reinterpret_cast<char*>(coeffPtr) -
+                               COUNT_BYTES, capacity * sizeof(T) +
+                               COUNT_BYTES);
+      }
+   }
+   coeffPtr = NULL;
+   capacity = 0;
+}
+
+//----------------------------- refCount ----------------------------------
+// Number of Polys sharing coeffPtr's array
+// Preconditions:   coeffPtr came from allocator
+// Postconditions:  returns the count at the start of the array's block
+template <class T>
+atomic<int>& BasicPoly<T>::refCount() const {
+   return *reinterpret_cast<atomic<int>*>(
+         reinterpret_cast<char*>(coeffPtr) - COUNT_BYTES);
+}
+
+//----------------------------- isShared ----------------------------------
+// Determine if another Poly holds coeffPtr's array too
+// Preconditions:   none
+// Postconditions:  returns true if the array came from allocator and its
+//       count is above 1.  The load acquires, so writes after a false
+//       result follow every read by the Polys that let go of the array
+template <class T>
+bool BasicPoly<T>::isShared() const {
+   return coeffPtr != NULL && coeffPtr != inlineCoeffs &&
+          refCount().load(memory_order_acquire) > 1;
+}
+
+//---------------------------- shareArray ---------------------------------
+// Make this Poly use the DENSE array of another Poly
+// Preconditions:   none
+// Postconditions:  returns false, doing nothing, unless source is DENSE
+//       with an array from this Poly's allocator; otherwise this Poly's
+//       old array is let go of, coeffPtr and capacity are source's, and
+//       the count is raised.  Terms and highestExp are left to the caller
+template <class T>
+bool BasicPoly<T>::shareArray(const BasicPoly& source) {
+   if (source.sparse || source.coeffPtr == source.inlineCoeffs ||
+         source.allocator != allocator)
+      return false;
+   POLY_STATS_ADD(SHARES, 1);
+   if (coeffPtr != source.coeffPtr) {
+      source.refCount().fetch_add(1, memory_order_relaxed);
+      freeArray();
+      coeffPtr = source.coeffPtr;
+      capacity = source.capacity;
+   }
+   return true;
+}
+
+//------------------------------ unshare ----------------------------------
+// Make coeffPtr's array this Poly's own before writing to it
+// Preconditions:   the DENSE layout is in use
+// Postconditions:  a shared array is copied into a new array of the same
+//       capacity, and the shared one let go of; otherwise nothing is done
+template <class T>
+void BasicPoly<T>::unshare() {
+   if (!isShared())
+      return;
+   POLY_STATS_ADD(UNSHARES, 1);
+   int size = capacity;
+   T* tmp = allocArray(size);
+   for (int i = highestExp; i >= 0; i--)
+      tmp[i] = coeffPtr[i];
+   for (int i = highestExp + 1; i < size; i++)
+      tmp[i] = 0;
+   freeArray();
+   coeffPtr = tmp;
+   capacity = size;
+}
+
+//---------------------------- scaleBy ------------------------------------
+// Multiply every coefficient by a T, in place
+// Preconditions:   none
+// Postconditions:  each coefficient is multiplied by factor; terms that
+//       become zero, as products of zero divisors can, are dropped and
+//       highestExp is normalized
+template <class T>
+void BasicPoly<T>::scaleBy(T factor) {
+   changed();
+   if (sparse) {
+      if (factor == 0)
+         terms.clear();
+      for (int i = (int)terms.size() - 1; i >= 0; i--)
+         terms[i].coeff *= factor;
+      terms.erase(remove_if(terms.begin(), terms.end(),
+                            [](const Term& t) { return t.coeff == 0; }),
+                  terms.end());
+      chooseRepresentation();
+   } else {
+      unshare();
+      T* out = coeffPtr;
+      forRange(highestExp + 1, [out, factor](int lo, int hi) {
+         for (int i = lo; i < hi; i++)
+            out[i] *= factor;
+      });
+      normalize();
+   }
+}
+
+//---------------------------- growDense ----------------------------------
+// Raise highestExp of a DENSE Poly, growing the array geometrically
+// Preconditions:   the DENSE layout is in use, newHighestExp > highestExp
+// Postconditions:  highestExp = newHighestExp; the new terms are zero.
+//       If the array is too small its size is at least doubled, so a
+//       run of growing setCoeff() calls reallocates O(log n) times
+template <class T>
+void BasicPoly<T>::growDense(int newHighestExp) {
+   if (newHighestExp >= capacity)
+      resizeArray(max(newHighestExp + 1, 2 * capacity));
+   highestExp = newHighestExp;
+}
+
+//--------------------------- resetDense ----------------------------------
+// Discard all terms and make this a DENSE Poly of all zero coefficients
+// Preconditions:   newHighestExp >= 0
+// Postconditions:  coeffPtr points to a zeroed array of size at least
+//       newHighestExp + 1, and highestExp = newHighestExp.  The old array
+//       is reused if it is large enough and not shared.  The cached term
+//       count and hash are left to the caller, which fills in the array
+template <class T>
+void BasicPoly<T>::resetDense(int newHighestExp) {
+   if (!sparse && capacity >= newHighestExp + 1 && !isShared()) {
+      for (int i = highestExp; i >= 0; i--)
+         coeffPtr[i] = 0;
+   } else {
+      freeArray();
+      int size = newHighestExp + 1;
+      coeffPtr = allocArray(size);
+      capacity = size;
+      for (int i = capacity - 1; i >= 0; i--)
+         coeffPtr[i] = 0;
+   }
+   terms.clear();
+   sparse = false;
+   highestExp = newHighestExp;
+}
+
+//----------------------------- toDense -----------------------------------
+// Convert the SPARSE terms into the DENSE array layout
+// Preconditions:   none
+// Postconditions:  coeffPtr holds every term, terms is emptied; the
+//       term count is known from the SPARSE terms
+template <class T>
+void BasicPoly<T>::toDense() {
+   if (!sparse)
+      return;
+   vector<Term> old;
+   old.swap(terms);
+   resetDense(highestExp);
+   for (int i = (int)old.size() - 1; i >= 0; i--)
+      coeffPtr[old[i].exp] = old[i].coeff;
+   knownTerms.store((int)old.size(), memory_order_relaxed);
+}
+
+//----------------------------- toSparse ----------------------------------
+// Convert the DENSE array into the SPARSE term layout
+// Preconditions:   none
+// Postconditions:  terms holds every nonzero term, coeffPtr is NULL
+template <class T>
+void BasicPoly<T>::toSparse() {
+   if (sparse)
+      return;
+   getTerms(terms);
+   freeArray();
+   sparse = true;
+   knownTerms.store((int)terms.size(), memory_order_relaxed);
+}
+
+//----------------------- chooseRepresentation ----------------------------
+// Put the terms into the layout asked for by storage
+// Preconditions:   none
+// Postconditions:  highestExp is normalized, then under AUTO the layout
+//       is picked with wantsSparse()
+template <class T>
+void BasicPoly<T>::chooseRepresentation() {
+   normalize();
+   bool useSparse = (storage == SPARSE) || (storage == AUTO && 
+         wantsSparse(highestExp + 1, termCount(), sparse));
+   if (useSparse)
+      toSparse();
+   else
+      toDense();
+}
+
+//--------------------------- wantsSparse ---------------------------------
+// Determine if AUTO should use the SPARSE layout
+// Preconditions:   none
+// Postconditions:  params are the number of array positions, the number
+//       of nonzero terms, and whether the layout is currently SPARSE;
+//       returns true if SPARSE should be used.  A SPARSE Poly stays SPARSE
+//       until it is much denser than a DENSE Poly switching over, so a
+//       Poly near the boundary doesn't convert back and forth
+template <class T>
+bool BasicPoly<T>::wantsSparse(int size, int nonzero, bool isSparseNow) {
+   if (size < SPARSE_MIN_SIZE)
+      return false;
+   if (isSparseNow)
+      return (double)nonzero * DENSE_RATIO < size;
+   return (double)nonzero * SPARSE_RATIO < size;
+}
+
+//---------------------------- findTerm -----------------------------------
+// Binary search the SPARSE terms for an exponent
+// Preconditions:   the SPARSE layout is in use
+// Postconditions:  returns the index of the first term with an exponent
+//       not less than the parameter
+template <class T>
+int BasicPoly<T>::findTerm(int exponent) const {
+   int low = 0;
+   int high = (int)terms.size();
+   while (low < high) {
+      int mid = low + (high - low) / 2;
+      if (terms[mid].exp < exponent)
+         low = mid + 1;
+      else
+         high = mid;
+   }
+   return low;
+}
+
+//---------------------------- getTerms -----------------------------------
+// Copy the nonzero terms of Poly into a vector, in increasing exponent
+// order, whichever layout is in use
+// Preconditions:   none
+// Postconditions:  the vector holds exactly the nonzero terms
+template <class T>
+void BasicPoly<T>::getTerms(vector<Term>& out) const {
+   if (sparse) {
+      out = terms;
+      return;
+   }
+   out.clear();
+   for (int i = 0; i <= highestExp; i++) {
+      if (coeffPtr[i] != 0) {
+         Term t = { coeffPtr[i], i };
+         out.push_back(t);
+      }
+   }
+}
+
+//---------------------------- setTerms -----------------------------------
+// Overwrite Poly with nonzero terms sorted by increasing exponent
+// Preconditions:   every exponent in the vector is <= newHighestExp
+// Postconditions:  this Poly holds exactly the terms, with highestExp ==
+//       newHighestExp, in the layout picked by chooseRepresentation()
+template <class T>
+void BasicPoly<T>::setTerms(vector<Term>& newTerms, int newHighestExp) {
+   freeArray();
+   terms.swap(newTerms);
+   highestExp = newHighestExp;
+   sparse = true;
+   changed();
+   chooseRepresentation();
+}
+
+//---------------------------- putTerms -----------------------------------
+// Set or add terms in any exponent order, sizing the Poly once
+// Preconditions:   every exponent in the vector is >= 0
+// Postconditions:  each term is set as by setCoeff(), the later of two
+//       with one exponent winning, or added as by addCoeff() if add is
+//       true.  The layout is picked once, from the highest exponent and
+//       an upper bound on the term count: a DENSE array grows at most
+//       once, SPARSE terms are sorted and merged in one pass
+template <class T>
+void BasicPoly<T>::putTerms(vector<Term>& list, bool add) {
+   if (list.empty())
+      return;
+   int top = highestExp;
+   for (size_t k = 0; k < list.size(); k++)
+      top = max(top, list[k].exp);
+   int bound = (int)list.size() +
+               (sparse ? (int)terms.size() : highestExp + 1);
+
+   if (storage == SPARSE ||
+         (storage == AUTO && wantsSparse(top + 1, bound, sparse))) {
+      toSparse();
+      stable_sort(list.begin(), list.end(), termExpLess<Term>);
+      vector<Term> merged;
+      merged.reserve(terms.size() + list.size());
+      size_t i = 0;
+      for (size_t k = 0; k < list.size(); ) {
+         int exponent = list[k].exp;
+         while (i < terms.size() && terms[i].exp < exponent)
+            merged.push_back(terms[i++]);
+         T coeff = 0;
+         if (i < terms.size() && terms[i].exp == exponent)
+            coeff = terms[i++].coeff;
+         for (; k < list.size() && list[k].exp == exponent; k++)
+            coeff = add ? coeff + list[k].coeff : list[k].coeff;
+         if (coeff != 0) {
+            Term t = { coeff, exponent };
+            merged.push_back(t);
+         }
+      }
+      merged.insert(merged.end(), terms.begin() + i, terms.end());
+      setTerms(merged, top);
+      return;
+   }
+
+   toDense();
+   if (top > highestExp)
+      growDense(top);
+   unshare();
+   changed();
+   for (size_t k = 0; k < list.size(); k++) {
+      if (add)
+         coeffPtr[list[k].exp] += list[k].coeff;
+      else
+         coeffPtr[list[k].exp] = list[k].coeff;
+   }
+   chooseRepresentation();
+}
+
+//--------------------------- mergeTerms ----------------------------------
+// Add or subtract rhs by merging the nonzero terms of both Polys in
+// exponent order
+// Preconditions:   sign is 1 or -1
+// Postconditions:  this Poly holds this + sign * rhs
+template <class T>
+void BasicPoly<T>::mergeTerms(const BasicPoly& rhs, int sign) {
+   vector<Term> aCopy, bCopy, merged;
+   const vector<Term>* a = &terms;
+   const vector<Term>* b = &rhs.terms;
+   if (!sparse) {
+      getTerms(aCopy);
+      a = &aCopy;
+   }
+   if (!rhs.sparse) {
+      rhs.getTerms(bCopy);
+      b = &bCopy;
+   }
+
+   merged.reserve(a->size() + b->size());
+   size_t i = 0, j = 0;
+   while (i < a->size() || j < b->size()) {
+      if (j == b->size() || (i < a->size() && (*a)[i].exp < (*b)[j].exp)) {
+         merged.push_back((*a)[i++]);
+      } else if (i == a->size() || (*b)[j].exp < (*a)[i].exp) {
+         Term t = { sign * (*b)[j].coeff, (*b)[j].exp };
+         merged.push_back(t);
+         j++;
+      } else {
+         Term t = { (*a)[i].coeff + sign * (*b)[j].coeff, (*a)[i].exp };
+         if (t.coeff != 0)
+            merged.push_back(t);
+         i++;
+         j++;
+      }
+   }
+   setTerms(merged, max(highestExp, rhs.highestExp));
+}
+
+//---------------------------- mulWide ------------------------------------
+// Toom-3 product of two arrays, computed on copies widened to the
+// traits' Wide word, since Toom-3 interpolation is only exact modulo
+// 2^(bits-1); only int and int64_t coefficients have a Wide word
+// Preconditions:   na >= 1, nb >= 1, out has room for na + nb - 1
+// Postconditions:  out holds the product, wrapping like the schoolbook loop
+template <class T>
+static void mulWide(const T* a, int na, const T* b, int nb, T* out) {
+   typedef typename PolyCoeffTraits<T>::Word W;
+   typedef typename PolyCoeffTraits<T>::Wide X;
+   vector<X> wideA(a, a + na);
+   vector<X> wideB(b, b + nb);
+   vector<X> wideOut(na + nb - 1);
+   polymul::multiply(&wideA[0], na, &wideB[0], nb, &wideOut[0], true);
+   for (int i = na + nb - 2; i >= 0; i--)
+      out[i] = (T)(W)wideOut[i];
+}
+
+//----------------------------- mulNtt ------------------------------------
+// NTT product of two arrays; only int and ModInt coefficients have an NTT
+// kernel, the template is there so mulDense() compiles for every type
+// Preconditions:   na >= 1, nb >= 1, transformSize(na + nb - 1) != 0
+// Postconditions:  out holds the product, wrapping like the schoolbook loop
+template <class T>
+static void mulNtt(const T*, int, const T*, int, T*) {
+}
+
+static void mulNtt(const int* a, int na, const int* b, int nb, int* out) {
+   polyntt::multiply(a, na, b, nb, out);
+}
+
+//the scratch vectors are taken from buffers, and sb, if not NULL, holds
+//the transforms of b (see polycache.h)
+template <class T>
+static void mulNtt(const T*, int, const T*, int, T*, polyntt::Buffers&,
+                   const polyntt::Spectrum*) {
+}
+
+static void mulNtt(const int* a, int na, const int* b, int nb, int* out,
+                   polyntt::Buffers& buffers, const polyntt::Spectrum* sb) {
+   polyntt::multiply(a, na, b, nb, out, buffers, sb);
+}
+
+template <uint32_t P>
+static void mulNtt(const ModInt<P>* a, int na, const ModInt<P>* b, int nb,
+                   ModInt<P>* out, polyntt::Buffers& buffers,
+                   const polyntt::Spectrum* sb = NULL) {
+   static const uint32_t root = polyntt::primitiveRoot(P);
+   vector<int>& va = buffers.va;
+   vector<int>& vb = buffers.vb;
+   vector<uint32_t>& product = buffers.result;
+   va.resize(na);
+   vb.resize(nb);
+   product.resize(na + nb - 1);
+   for (int i = 0; i < na; i++)
+      va[i] = (int)a[i].value();
+   for (int i = 0; i < nb; i++)
+      vb[i] = (int)b[i].value();
+   polyntt::multiplyMod(&va[0], na, &vb[0], nb, P, root, &product[0],
+                        buffers, sb);
+   for (int i = na + nb - 2; i >= 0; i--)
+      out[i] = ModInt<P>(product[i]);
+}
+
+template <uint32_t P>
+static void mulNtt(const ModInt<P>* a, int na, const ModInt<P>* b, int nb,
+                   ModInt<P>* out) {
+   polyntt::Buffers buffers;
+   mulNtt(a, na, b, nb, out, buffers);
+}
+
+//---------------------------- nttSpectrum --------------------------------
+// The transforms mulNtt() makes of b for transform length n, to be kept;
+// the template is there so mulCached() compiles for every type
+// Preconditions:   1 <= nb <= n, n = transformSize() of the products
+// Postconditions:  s holds b's Spectrum (see polyntt.h)
+template <class T>
+static void nttSpectrum(const T*, int, int, polyntt::Spectrum&) {
+}
+
+static void nttSpectrum(const int* b, int nb, int n, polyntt::Spectrum& s) {
+   polyntt::Buffers buffers;
+   polyntt::makeSpectrum(b, nb, n, 0, 0, s, buffers);
+}
+
+template <uint32_t P>
+static void nttSpectrum(const ModInt<P>* b, int nb, int n,
+                        polyntt::Spectrum& s) {
+   static const uint32_t root = polyntt::primitiveRoot(P);
+   polyntt::Buffers buffers;
+   vector<int>& vb = buffers.vb;
+   vb.resize(nb);
+   for (int i = 0; i < nb; i++)
+      vb[i] = (int)b[i].value();
+   polyntt::makeSpectrum(&vb[0], nb, n, P, root, s, buffers);
+}
+
+//---------------------------- nttThreshold -------------------------------
+// Operand length from which MUL_AUTO uses NTT for a coefficient type
+template <class T>
+static int nttThreshold(const T*) {
+   return polyntt::NTT_THRESHOLD;
+}
+
+//P = c*2^16 + 1 or better allows one transform modulo P itself
+template <uint32_t P>
+static int nttThreshold(const ModInt<P>*) {
+   return ((P - 1) % (1u << 16) == 0) ? polyntt::MOD_NTT_THRESHOLD
+                                      : polyntt::MOD_CRT_THRESHOLD;
+}
+
+//---------------------------- mulDense -----------------------------------
+// Multiply two DENSE coefficient arrays into a preallocated array
+// Preconditions:   na >= 1, nb >= 1, out has room for na + nb - 1
+// Postconditions:  out holds the product, wrapping on overflow exactly
+//       like the schoolbook loop on T.
+//       -- kernels run on the traits' Word type, e.g. unsigned for int,
+//          so wrapping is well defined; a kernel that is not exact for
+//          T is replaced by the next simpler one (see polycoeff.h)
+//       -- once Toom-3 pays off the operands are widened, since its
+//          interpolation is only exact modulo 2^(bits-1)
+//       -- NTT products are exact before the low 32 bits are kept, or
+//          are reduced modulo P for ModInt<P>
+template <class T>
+static void mulDense(const T* a, int na, const T* b, int nb, T* out,
+                     PolyBase::MulAlgorithm algorithm) {
+   typedef PolyCoeffTraits<T> Traits;
+   typedef typename Traits::Word W;
+   int shorter = min(na, nb);
+   bool nttFits = Traits::NTT && 
+         polyntt::transformSize((long long)na + nb - 1) != 0;
+   if (algorithm == PolyBase::MUL_AUTO)
+      algorithm = (shorter >= nttThreshold(a) && nttFits) ? 
+            PolyBase::MUL_NTT : PolyBase::MUL_TOOM3;
+   if (algorithm == PolyBase::MUL_NTT && !nttFits)
+      algorithm = PolyBase::MUL_TOOM3;
+   if (algorithm == PolyBase::MUL_TOOM3 && !Traits::TOOM3)
+      algorithm = PolyBase::MUL_KARATSUBA;
+   if (algorithm == PolyBase::MUL_KARATSUBA && !Traits::KARATSUBA)
+      algorithm = PolyBase::MUL_SCHOOLBOOK;
+
+   const W* wa = reinterpret_cast<const W*>(a);
+   const W* wb = reinterpret_cast<const W*>(b);
+   W* wout = reinterpret_cast<W*>(out);
+   if (algorithm == PolyBase::MUL_SCHOOLBOOK) {
+      polymul::schoolbook(wa, na, wb, nb, wout);
+   } else if (algorithm == PolyBase::MUL_KARATSUBA || 
+         (algorithm == PolyBase::MUL_TOOM3 && 
+          shorter < polymul::TOOM3_THRESHOLD)) {
+      polymul::multiply(wa, na, wb, nb, wout, false);
+   } else if (algorithm == PolyBase::MUL_TOOM3) {
+      mulWide(a, na, b, nb, out);
+   } else {
+      mulNtt(a, na, b, nb, out);
+   }
+}
+
+//--------------------------- mulParallel ---------------------------------
+// Multiply two DENSE arrays with the subproducts run on the thread pool
+// Preconditions:   na >= 1, nb >= 1, out has room for na + nb - 1, and T
+//       has a Karatsuba kernel
+// Postconditions:  out holds the product, the same as mulDense() gives,
+//       since every kernel is exact.  Operands of very different length
+//       are cut into blocks of the shorter one's length, whose products
+//       run in parallel and are then added in order.  Otherwise one
+//       Karatsuba step runs a0*b0, a1*b1 and (a0 + a1)*(b0 + b1) in
+//       parallel, each split again while depth > 0
+template <class T>
+static void mulParallel(const T* a, int na, const T* b, int nb, T* out,
+                        PolyBase::MulAlgorithm algorithm, int depth) {
+   typedef typename PolyCoeffTraits<T>::Word W;
+   if (na < nb) {
+      swap(a, b);
+      swap(na, nb);
+   }
+   if (depth == 0 || nb < PolyBase::PARALLEL_MIN_MUL) {
+      mulDense(a, na, b, nb, out, algorithm);
+      return;
+   }
+   const W* wa = reinterpret_cast<const W*>(a);
+   const W* wb = reinterpret_cast<const W*>(b);
+   W* wout = reinterpret_cast<W*>(out);
+   PolyThreadPool& pool = PolyThreadPool::shared();
+
+   if (nb <= (na + 1) / 2) {
+      int blocks = (na + nb - 1) / nb;
+      vector<vector<W> > parts(blocks);
+      pool.parallelFor(0, blocks, 1, [&](int lo, int hi) {
+         for (int k = lo; k < hi; k++) {
+            int len = min(nb, na - k * nb);
+            parts[k].resize(len + nb - 1);
+            mulParallel(a + k * nb, len, b, nb,
+                        reinterpret_cast<T*>(&parts[k][0]), algorithm,
+                        depth - 1);
+         }
+      });
+      for (int i = na + nb - 2; i >= 0; i--)
+         wout[i] = W(0);
+      for (int k = 0; k < blocks; k++) {
+         W* row = wout + k * nb;
+         for (size_t i = 0; i < parts[k].size(); i++)
+            row[i] += parts[k][i];
+      }
+      return;
+   }
+
+   //a = a0 + x^h a1, b = b0 + x^h b1, with nb > h
+   int h = (na + 1) / 2;
+   vector<W> sumA(h), sumB(h), z0(2 * h - 1), z1(2 * h - 1);
+   vector<W> z2(na + nb - 2 * h - 1);
+   for (int i = 0; i < h; i++) {
+      sumA[i] = (i + h < na) ? wa[i] + wa[i + h] : wa[i];
+      sumB[i] = (i + h < nb) ? wb[i] + wb[i + h] : wb[i];
+   }
+   pool.parallelFor(0, 3, 1, [&](int lo, int hi) {
+      for (int k = lo; k < hi; k++) {
+         if (k == 0)
+            mulParallel(a, h, b, h, reinterpret_cast<T*>(&z0[0]),
+                        algorithm, depth - 1);
+         else if (k == 1)
+            mulParallel(a + h, na - h, b + h, nb - h,
+                        reinterpret_cast<T*>(&z2[0]), algorithm, depth - 1);
+         else
+            mulParallel(reinterpret_cast<const T*>(&sumA[0]), h,
+                        reinterpret_cast<const T*>(&sumB[0]), h,
+                        reinterpret_cast<T*>(&z1[0]), algorithm, depth - 1);
+      }
+   });
+   for (int i = na + nb - 2; i >= 0; i--)
+      wout[i] = W(0);
+   for (int i = 0; i < 2 * h - 1; i++) {
+      W middle = z1[i] - z0[i];
+      if (i < (int)z2.size())
+         middle -= z2[i];
+      wout[i] += z0[i];
+      wout[i + h] += middle;
+   }
+   for (size_t i = 0; i < z2.size(); i++)
+      wout[2 * h + i] += z2[i];
+}
+
+//--------------------------- mulDenseExec --------------------------------
+// mulDense() under an Execution
+// Preconditions:   as for mulDense()
+// Postconditions:  out holds the product; under EXEC_PARALLEL, with more
+//       than one thread, a large enough product by any algorithm but
+//       MUL_SCHOOLBOOK is computed by mulParallel(), split deep enough to
+//       give each thread about two subproducts
+template <class T>
+static void mulDenseExec(const T* a, int na, const T* b, int nb, T* out,
+                         PolyBase::MulAlgorithm algorithm,
+                         PolyBase::Execution execution) {
+   //the shared pool is only asked for, and so started, once a product
+   //could run on it
+   if (!PolyCoeffTraits<T>::KARATSUBA ||
+         algorithm == PolyBase::MUL_SCHOOLBOOK ||
+         min(na, nb) < PolyBase::PARALLEL_MIN_MUL ||
+         PolyBase::resolve(execution) != PolyBase::EXEC_PARALLEL ||
+         PolyThreadPool::shared().size() == 1) {
+      mulDense(a, na, b, nb, out, algorithm);
+      return;
+   }
+   int threads = PolyThreadPool::shared().size();
+   int depth = 1;
+   for (int tasks = 3; tasks < 2 * threads && depth < 4; tasks *= 3)
+      depth++;
+   mulParallel(a, na, b, nb, out, algorithm, depth);
+}
+
+//----------------------------- DenseMul ----------------------------------
+// mulDenseExec() with MUL_AUTO and EXEC_DEFAULT on arrays of the traits'
+// Word type, as the kernels of polytree.h call it
+template <class T>
+struct DenseMul {
+   typedef typename PolyCoeffTraits<T>::Word W;
+
+   void operator()(const W* a, int na, const W* b, int nb, W* out) const {
+      mulDenseExec(reinterpret_cast<const T*>(a), na,
+                   reinterpret_cast<const T*>(b), nb,
+                   reinterpret_cast<T*>(out), PolyBase::MUL_AUTO,
+                   PolyBase::EXEC_DEFAULT);
+   }
+};
+
+//----------------------------- SeriesMul ---------------------------------
+// DenseMul for the power series kernels of ModInt, whose scratch space
+// is kept across products: Karatsuba's in karatsuba, the NTT's in
+// buffers, both reserved for the longest product of a chain of Newton
+// steps, so that the chain allocates them once.  Products run serially
+template <uint32_t P>
+struct SeriesMul {
+   typedef ModInt<P> W;
+   vector<W>* karatsuba;
+   polyntt::Buffers* buffers;
+
+   void operator()(const W* a, int na, const W* b, int nb, W* out) const {
+      if (min(na, nb) < nttThreshold(a) ||
+            polyntt::transformSize((long long)na + nb - 1) == 0)
+         polymul::multiply(a, na, b, nb, out, false, *karatsuba);
+      else
+         mulNtt(a, na, b, nb, out, *buffers);
+   }
+};
+
+//------------------------- interpolateField ------------------------------
+// Interpolation kernel; only ModInt coefficients can be divided, the
+// template is there so interpolate() compiles for every type
+// Preconditions:   n >= 1, out has room for n coefficients
+// Postconditions:  returns false for a type that is not a field, else
+//       out holds the coefficients of the Poly through the points
+template <class T>
+static bool interpolateField(const T*, const T*, int, T*) {
+   return false;
+}
+
+template <uint32_t P>
+static bool interpolateField(const ModInt<P>* xs, const ModInt<P>* ys,
+                             int n, ModInt<P>* out) {
+   polytree::interpolate(xs, ys, n, out, DenseMul<ModInt<P> >());
+   return true;
+}
+
+//------------------------------ gcdField ---------------------------------
+// gcd kernel; only ModInt coefficients form a field, the template is
+// there so gcd() compiles for every type
+// Preconditions:   a and b have no leading zeros; s, t and res are NULL
+//       or to be set
+// Postconditions:  returns false for a type that is not a field.  Else g
+//       is the monic gcd, s and t its cofactors, and res the resultant
+template <class T>
+static bool gcdField(const vector<T>&, const vector<T>&, vector<T>&,
+                     vector<T>*, vector<T>*, T*) {
+   return false;
+}
+
+template <uint32_t P>
+static bool gcdField(const vector<ModInt<P> >& a,
+                     const vector<ModInt<P> >& b, vector<ModInt<P> >& g,
+                     vector<ModInt<P> >* s, vector<ModInt<P> >* t,
+                     ModInt<P>* res) {
+   typedef ModInt<P> W;
+   bool nonzero = !a.empty() && !b.empty();
+   polygcd::Matrix<W> cofactors;
+   polygcd::Resultant<W> steps(nonzero ? a : vector<W>(1, W(1)),
+                               nonzero ? b : vector<W>(1, W(1)));
+   g = polygcd::gcd(a, b, (s != NULL) ? &cofactors : NULL,
+                    (res != NULL && nonzero) ? &steps : NULL,
+                    DenseMul<W>());
+   if (res != NULL)
+      *res = (nonzero && g.size() == 1) ? steps.value : W(0);
+   W inverse = g.empty() ? W(1) : g.back().inverse();
+   for (size_t i = 0; i < g.size(); i++)
+      g[i] *= inverse;
+   if (s != NULL) {
+      s->swap(cofactors.m[0][0]);
+      t->swap(cofactors.m[0][1]);
+      for (size_t i = 0; i < s->size(); i++)
+         (*s)[i] *= inverse;
+      for (size_t i = 0; i < t->size(); i++)
+         (*t)[i] *= inverse;
+   }
+   return true;
+}
+
+//---------------------------- shiftCoeffs --------------------------------
+// Taylor shift kernel; over ModInt by one product, the template splits
+// at powers of 2 over any ring (see polycompose.h)
+// Preconditions:   d >= 1, out has room for d coefficients
+// Postconditions:  out holds the coefficients of a(x + c), in the traits'
+//       Word so that they wrap like + and * do
+template <class T>
+static void shiftCoeffs(const T* a, int d, T c, T* out) {
+   typedef typename PolyCoeffTraits<T>::Word W;
+   polycompose::shift(reinterpret_cast<const W*>(a), d, (W)c,
+                      reinterpret_cast<W*>(out), DenseMul<T>());
+}
+
+template <uint32_t P>
+static void shiftCoeffs(const ModInt<P>* a, int d, ModInt<P> c,
+                        ModInt<P>* out) {
+   if ((long long)d < P)
+      polycompose::shiftField(a, d, c, out, DenseMul<ModInt<P> >());
+   else
+      polycompose::shift(a, d, c, out, DenseMul<ModInt<P> >());
+}
+
+//---------------------------- SeriesFunction -----------------------------
+// Power series function computed by seriesField()
+enum SeriesFunction { SERIES_INVERSE, SERIES_LOG, SERIES_EXP, SERIES_SQRT };
+
+//the member function computing each, for error messages
+static string seriesName(SeriesFunction function) {
+   static const char* const names[] = { "seriesInverse", "seriesLog",
+                                        "seriesExp", "seriesSqrt" };
+   return names[function];
+}
+
+//----------------------------- seriesField -------------------------------
+// Power series kernel; only ModInt coefficients can be divided, the
+// template is there so the series functions compile for every type
+// Preconditions:   n >= 1, out has room for n coefficients
+// Postconditions:  returns false for a type that is not a field.  Else
+//       out holds the function of a[0..na) to n terms (see polyseries.h);
+//       throws domain_error if the constant term does not suit it
+template <class T>
+static bool seriesField(SeriesFunction, const T*, int, int, T*) {
+   return false;
+}
+
+template <uint32_t P>
+static bool seriesField(SeriesFunction function, const ModInt<P>* a,
+                        int na, int n, ModInt<P>* out) {
+   typedef ModInt<P> W;
+   string name = seriesName(function);
+   W zero(0);
+   if (na == 0) {
+      a = &zero;
+      na = 1;
+   }
+   if ((function == SERIES_LOG || function == SERIES_EXP) &&
+         (long long)n > P)
+      throw domain_error(name + " needs at most P terms");
+   polyseries::Workspace<W> work(n);
+   vector<W> karatsuba;
+   polyntt::Buffers buffers;
+   int threshold = nttThreshold(a);
+   int shortest = min(n, threshold);  //longest Karatsuba operand
+   karatsuba.reserve(polymul::scratchSize(shortest, false) + 2 * shortest);
+   if (n >= threshold)
+      buffers.reserve(2LL * n);
+   SeriesMul<P> mul = { &karatsuba, &buffers };
+   if (function == SERIES_INVERSE) {
+      if (a[0] == W(0))
+         throw domain_error(name + " needs a nonzero constant term");
+      polyseries::inverse(a, na, n, out, work, mul);
+   } else if (function == SERIES_LOG) {
+      if (a[0] != W(1))
+         throw domain_error(name + " needs a constant term of 1");
+      polyseries::log(a, na, n, out, work, mul);
+   } else if (function == SERIES_EXP) {
+      if (a[0] != W(0))
+         throw domain_error(name + " needs a constant term of 0");
+      polyseries::exp(a, na, n, out, work, mul);
+   } else if (!polyseries::sqrt(a, na, n, out, work, mul)) {
+      throw domain_error(name + " needs a constant term that is a "
+                         "nonzero square");
+   }
+   return true;
+}
+
+//---------------------------- treeMinSize --------------------------------
+// Degree and number of points from which evaluate() uses the subproduct
+// tree for a coefficient type
+template <class T>
+static int treeMinSize(const T*) {
+   return polytree::TREE_MIN_SIZE;
+}
+
+template <uint32_t P>
+static int treeMinSize(const ModInt<P>*) {
+   return polytree::MOD_TREE_MIN_SIZE;
+}
+
+//--------------------------- evaluateTree --------------------------------
+// Evaluate Poly at many points with a subproduct tree
+// Preconditions:   xs and out hold n points each
+// Postconditions:  returns false if the tree would not beat Horner's
+//       rule: for SPARSE Polys, low degrees, few points, or coefficient
+//       types without fast multiplication.  Otherwise out[i] is the value
+//       at xs[i], computed in the traits' Word so that it wraps like
+//       Horner's rule does
+template <class T>
+bool BasicPoly<T>::evaluateTree(const T* xs, T* out, size_t n) const {
+   typedef typename PolyCoeffTraits<T>::Word W;
+   int minSize = treeMinSize(xs);
+   if (!PolyCoeffTraits<T>::KARATSUBA || sparse || highestExp < minSize ||
+         n < (size_t)minSize || n > (size_t)INT_MAX)
+      return false;
+   polytree::evaluate(reinterpret_cast<const W*>(coeffPtr), highestExp + 1,
+                      reinterpret_cast<const W*>(xs), (int)n,
+                      reinterpret_cast<W*>(out), DenseMul<T>());
+   return true;
+}
+
+//--------------------------- interpolate ---------------------------------
+// Build the Poly through n points
+// Preconditions:   T is a field (ModInt); the xs are distinct
+// Postconditions:  returns the Poly of degree < n through the points, in
+//       the layout picked by chooseRepresentation(); throws domain_error
+//       for other coefficient types or equal points
+template <class T>
+BasicPoly<T> BasicPoly<T>::interpolate(const T* xs, const T* ys, int n) {
+   BasicPoly result;
+   if (n <= 0)
+      return result;
+   result.resetDense(n - 1);
+   if (!interpolateField(xs, ys, n, result.coeffPtr))
+      throw domain_error("interpolate needs a field coefficient type, "
+                         "such as ModInt");
+   result.chooseRepresentation();
+   return result;
+}
+
+//------------------------------- gcd -------------------------------------
+// Greatest common divisor of two Polys
+// Preconditions:   T is a field (ModInt)
+// Postconditions:  returns the monic gcd from gcdField(), in the layout
+//       picked by chooseRepresentation(); throws domain_error for other
+//       coefficient types
+template <class T>
+BasicPoly<T> BasicPoly<T>::gcd(const BasicPoly& a, const BasicPoly& b) {
+   vector<T> scratchA, scratchB, g;
+   int na, nb;
+   const T* pa = a.denseCoeffs(scratchA, na);
+   const T* pb = b.denseCoeffs(scratchB, nb);
+   if (!gcdField(vector<T>(pa, pa + na), vector<T>(pb, pb + nb), g,
+                 (vector<T>*)NULL, (vector<T>*)NULL, (T*)NULL))
+      throw domain_error("gcd needs a field coefficient type, "
+                         "such as ModInt");
+   return fromDense(g.data(), (int)g.size());
+}
+
+//------------------------------- xgcd ------------------------------------
+// Extended gcd of two Polys
+// Preconditions:   as for gcd()
+// Postconditions:  returns the monic gcd, and s and t with
+//       s * a + t * b == gcd; a and b are read before s and t are written
+template <class T>
+BasicPoly<T> BasicPoly<T>::xgcd(const BasicPoly& a, const BasicPoly& b,
+                                BasicPoly& s, BasicPoly& t) {
+   vector<T> scratchA, scratchB, g, cs, ct;
+   int na, nb;
+   const T* pa = a.denseCoeffs(scratchA, na);
+   const T* pb = b.denseCoeffs(scratchB, nb);
+   if (!gcdField(vector<T>(pa, pa + na), vector<T>(pb, pb + nb), g, &cs,
+                 &ct, (T*)NULL))
+      throw domain_error("gcd needs a field coefficient type, "
+                         "such as ModInt");
+   s = fromDense(cs.data(), (int)cs.size());
+   t = fromDense(ct.data(), (int)ct.size());
+   return fromDense(g.data(), (int)g.size());
+}
+
+//---------------------------- resultant ----------------------------------
+// Resultant of two Polys
+// Preconditions:   as for gcd()
+// Postconditions:  returns the resultant, from the steps of gcdField()
+template <class T>
+T BasicPoly<T>::resultant(const BasicPoly& a, const BasicPoly& b) {
+   vector<T> scratchA, scratchB, g;
+   int na, nb;
+   const T* pa = a.denseCoeffs(scratchA, na);
+   const T* pb = b.denseCoeffs(scratchB, nb);
+   T res = T(0);
+   if (!gcdField(vector<T>(pa, pa + na), vector<T>(pb, pb + nb), g,
+                 (vector<T>*)NULL, (vector<T>*)NULL, &res))
+      throw domain_error("resultant needs a field coefficient type, "
+                         "such as ModInt");
+   return res;
+}
+
+//----------------------------- seriesOf ----------------------------------
+// A power series function of the coefficients a[0..na), to n terms
+// Preconditions:   na <= n
+// Postconditions:  out holds the n coefficients from seriesField(), or
+//       none for n <= 0; throws domain_error for a type that is not a
+//       field
+template <class T>
+static void seriesOf(SeriesFunction function, const T* a, int na, int n,
+                     vector<T>& out) {
+   out.clear();
+   if (n <= 0)
+      return;
+   out.resize(n);
+   if (!seriesField(function, a, na, n, out.data()))
+      throw domain_error(seriesName(function) +
+                         " needs a field coefficient type, such as ModInt");
+}
+
+//--------------------------- seriesInverse -------------------------------
+// Power series inverse to n terms
+// Preconditions:   as for seriesOf()
+// Postconditions:  returns the inverse from the terms below x^n
+template <class T>
+BasicPoly<T> BasicPoly<T>::seriesInverse(int n) const {
+   vector<T> scratch, out;
+   int na;
+   const T* a = lowCoeffs(scratch, n, na);
+   seriesOf(SERIES_INVERSE, a, na, n, out);
+   return fromDense(out.data(), (int)out.size());
+}
+
+//----------------------------- seriesLog ---------------------------------
+// Power series logarithm to n terms
+// Preconditions:   as for seriesOf()
+// Postconditions:  returns the logarithm from the terms below x^n
+template <class T>
+BasicPoly<T> BasicPoly<T>::seriesLog(int n) const {
+   vector<T> scratch, out;
+   int na;
+   const T* a = lowCoeffs(scratch, n, na);
+   seriesOf(SERIES_LOG, a, na, n, out);
+   return fromDense(out.data(), (int)out.size());
+}
+
+//----------------------------- seriesExp ---------------------------------
+// Power series exponential to n terms
+// Preconditions:   as for seriesOf()
+// Postconditions:  returns the exponential from the terms below x^n
+template <class T>
+BasicPoly<T> BasicPoly<T>::seriesExp(int n) const {
+   vector<T> scratch, out;
+   int na;
+   const T* a = lowCoeffs(scratch, n, na);
+   seriesOf(SERIES_EXP, a, na, n, out);
+   return fromDense(out.data(), (int)out.size());
+}
+
+//---------------------------- seriesSqrt ---------------------------------
+// Power series square root to n terms
+// Preconditions:   as for seriesOf()
+// Postconditions:  returns the square root from the terms below x^n
+template <class T>
+BasicPoly<T> BasicPoly<T>::seriesSqrt(int n) const {
+   vector<T> scratch, out;
+   int na;
+   const T* a = lowCoeffs(scratch, n, na);
+   seriesOf(SERIES_SQRT, a, na, n, out);
+   return fromDense(out.data(), (int)out.size());
+}
+
+//------------------------------  *  --------------------------------------
+// Overloaded multiplication operator; multiply 2 Polys
+// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
+//       least 1, or the SPARSE layout is in use
+// Postconditions:  a Poly is returned, which is the product of this object
+//       and rhs, computed by multiply() with MUL_AUTO
+template <class T>
+BasicPoly<T> BasicPoly<T>::operator*(const BasicPoly& rhs) const {
+   return multiply(rhs, MUL_AUTO);
+}
+
+//----------------------------- multiply ----------------------------------
+// Multiply 2 Polys with a chosen algorithm
+// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
+//       least 1, or the SPARSE layout is in use
+// Postconditions:  a Poly is returned, which is the product of this object
+//       and rhs.  DENSE products are written by mulDense() straight into
+//       an array of size highestExp + rhs.highestExp + 1.  Under MUL_AUTO,
+//       when polysparse::useHeap() finds it cheaper from the term counts,
+//       as for most SPARSE operands, only pairs of nonzero terms are
+//       multiplied, merged in exponent order by polysparse::multiply()
+//       straight into the product's terms; other SPARSE operands are
+//       multiplied as DENSE copies.  Throws overflow_error, before
+//       anything is sized, if the degree would pass INT_MAX
+template <class T>
+BasicPoly<T> BasicPoly<T>::multiply(const BasicPoly& rhs,
+                                    MulAlgorithm algorithm,
+                                    Execution execution) const {
+   POLY_STATS_OP(OP_MUL, storedSize() + rhs.storedSize());
+   if ((long long)highestExp + rhs.highestExp > INT_MAX)
+      throw overflow_error("Poly *: degree above INT_MAX");
+   PolyCache<T>* cache = PolyCache<T>::getCurrent();
+   if (cache == NULL || algorithm != MUL_AUTO || !cache->accepts(*this, rhs))
+      return multiplyBy(rhs, algorithm, execution, NULL);
+   const BasicPoly* hit = cache->findProduct(*this, rhs);
+   if (hit != NULL)
+      return *hit;
+   BasicPoly product = multiplyBy(rhs, algorithm, execution, cache);
+   cache->addProduct(*this, rhs, product);
+   return product;
+}
+
+//---------------------------- multiplyBy ---------------------------------
+// multiply() past the product cache
+// Preconditions:   cache is NULL or the current PolyCache
+// Postconditions:  returns the product as multiply() computes it; DENSE
+//       products are tried with mulCached() first if cache is not NULL
+template <class T>
+BasicPoly<T> BasicPoly<T>::multiplyBy(const BasicPoly& rhs,
+                                      MulAlgorithm algorithm,
+                                      Execution execution,
+                                      PolyCache<T>* cache) const {
+   BasicPoly product(0, highestExp + rhs.highestExp);
+   bool heap = algorithm == MUL_AUTO && (sparse || rhs.sparse ||
+         min(highestExp, rhs.highestExp) >= SPARSE_MIN_SIZE);
+   if (heap)
+      heap = polysparse::useHeap(termCount(), rhs.termCount(),
+                                 highestExp + 1, rhs.highestExp + 1);
+   if (heap) {
+      typedef typename PolyCoeffTraits<T>::Word W;
+      vector<Term> scratchA, scratchB, combined;
+      int na, nb;
+      const Term* a = sparseTerms(scratchA, na);
+      const Term* b = rhs.sparseTerms(scratchB, nb);
+      if (na > 0 && nb > 0)
+         polysparse::multiply<W>(a, na, b, nb, combined);
+      product.setTerms(combined, highestExp + rhs.highestExp);
+      return product;
+   }
+   if (sparse || rhs.sparse) {
+      BasicPoly denseLhs(*this), denseRhs(rhs);
+      denseLhs.toDense();
+      denseRhs.toDense();
+      product.resetDense(highestExp + rhs.highestExp);
+      mulDenseExec(denseLhs.coeffPtr, highestExp + 1, denseRhs.coeffPtr,
+                   rhs.highestExp + 1, product.coeffPtr, algorithm,
+                   execution);
+      product.chooseRepresentation();
+      return product;
+   }
+   product.resetDense(highestExp + rhs.highestExp);
+   if (cache == NULL ||
+         !mulCached(rhs, product.coeffPtr, execution, *cache))
+      mulDenseExec(coeffPtr, highestExp + 1, rhs.coeffPtr,
+                   rhs.highestExp + 1, product.coeffPtr, algorithm,
+                   execution);
+   product.chooseRepresentation();
+   return product;
+}
+
+//----------------------------- mulCached ---------------------------------
+// NTT product with the transforms of an operand kept in a PolyCache
+// Preconditions:   both Polys are DENSE; out has room for their product
+// Postconditions:  returns false, doing nothing, unless MUL_AUTO would
+//       pick a serial NTT product.  Else out holds the product: an
+//       operand whose spectrum the cache holds is not transformed, and
+//       one the cache wants a spectrum of has it made and stored first;
+//       rhs is looked up first, the product being the same either way
+template <class T>
+bool BasicPoly<T>::mulCached(const BasicPoly& rhs, T* out,
+                             Execution execution,
+                             PolyCache<T>& cache) const {
+   int na = highestExp + 1, nb = rhs.highestExp + 1;
+   int n = polyntt::transformSize((long long)na + nb - 1);
+   bool parallel = min(na, nb) >= PARALLEL_MIN_MUL &&
+         resolve(execution) == EXEC_PARALLEL &&
+         PolyThreadPool::shared().size() > 1;
+   if (!PolyCoeffTraits<T>::NTT || n == 0 ||
+         min(na, nb) < nttThreshold(coeffPtr) || parallel)
+      return false;
+
+   const BasicPoly* a = this;
+   const BasicPoly* b = &rhs;
+   const polyntt::Spectrum* sb = cache.findSpectrum(rhs, n);
+   if (sb == NULL) {
+      sb = cache.findSpectrum(*this, n);
+      if (sb != NULL)
+         swap(a, b);
+   }
+   polyntt::Spectrum made;
+   if (sb == NULL && (cache.wantsSpectrum(rhs) ||
+                      cache.wantsSpectrum(*this))) {
+      if (!cache.wantsSpectrum(rhs))
+         swap(a, b);
+      nttSpectrum(b->coeffPtr, b->highestExp + 1, n, made);
+      sb = cache.addSpectrum(*b, made);
+      if (sb == NULL)
+         sb = &made;
+   }
+   polyntt::Buffers buffers;
+   mulNtt(a->coeffPtr, a->highestExp + 1, b->coeffPtr, b->highestExp + 1,
+          out, buffers, sb);
+   return true;
+}
+
+//------------------------------ mullow -----------------------------------
+// Truncated product: the terms of this object * rhs below x^n
+// Preconditions:   none
+// Postconditions:  returns (this * rhs) mod x^n from the terms of each
+//       below x^n, by polyseries::mullow() in the traits' Word, so it
+//       wraps like * does.  Throws overflow_error if the product of
+//       those terms, which is formed whole, has a degree above INT_MAX
+template <class T>
+BasicPoly<T> BasicPoly<T>::mullow(const BasicPoly& rhs, int n) const {
+   typedef typename PolyCoeffTraits<T>::Word W;
+   if (n <= 0)
+      return BasicPoly();
+   if ((long long)min(highestExp, n - 1) + min(rhs.highestExp, n - 1) >
+         INT_MAX)
+      throw overflow_error("Poly mullow: degree above INT_MAX");
+   vector<T> scratchA, scratchB;
+   int na, nb;
+   const T* a = lowCoeffs(scratchA, n, na);
+   const T* b = rhs.lowCoeffs(scratchB, n, nb);
+   vector<W> out(n), product;
+   polyseries::mullow(reinterpret_cast<const W*>(a), na,
+                      reinterpret_cast<const W*>(b), nb, n, &out[0],
+                      product, DenseMul<T>());
+   return fromDense(reinterpret_cast<const T*>(out.data()), n);
+}
+
+//------------------------------ mulhigh ----------------------------------
+// High part of a product: the terms of this object * rhs from x^k up
+// Preconditions:   k >= 0
+// Postconditions:  returns (this * rhs) div x^k.  SPARSE operands that
+//       polysparse::useHeap() favors go to polysparse::multiplyHigh(),
+//       which forms only the pairs from x^k up; others go to
+//       polyseries::mulhigh().  Throws overflow_error if the degree of the
+//       whole product would pass INT_MAX
+template <class T>
+BasicPoly<T> BasicPoly<T>::mulhigh(const BasicPoly& rhs, int k) const {
+   typedef typename PolyCoeffTraits<T>::Word W;
+   if ((long long)highestExp + rhs.highestExp > INT_MAX)
+      throw overflow_error("Poly mulhigh: degree above INT_MAX");
+   if ((sparse || rhs.sparse) &&
+         polysparse::useHeap(termCount(), rhs.termCount(), highestExp + 1,
+                             rhs.highestExp + 1)) {
+      vector<Term> scratchA, scratchB, high;
+      int na, nb;
+      const Term* a = sparseTerms(scratchA, na);
+      const Term* b = rhs.sparseTerms(scratchB, nb);
+      if (na > 0 && nb > 0)
+         polysparse::multiplyHigh<W>(a, na, b, nb, k, high);
+      for (size_t i = 0; i < high.size(); i++)
+         high[i].exp -= k;
+      BasicPoly result;
+      result.setTerms(high, high.empty() ? 0 : high.back().exp);
+      return result;
+   }
+   vector<T> scratchA, scratchB;
+   int na, nb;
+   const T* a = denseCoeffs(scratchA, na);
+   const T* b = rhs.denseCoeffs(scratchB, nb);
+   if (na == 0 || nb == 0 || na + nb - 1 <= k)
+      return BasicPoly();
+   vector<W> out(na + nb - 1 - k), product;
+   polyseries::mulhigh(reinterpret_cast<const W*>(a), na,
+                       reinterpret_cast<const W*>(b), nb, k, &out[0],
+                       product, DenseMul<T>());
+   return fromDense(reinterpret_cast<const T*>(out.data()),
+                    (int)out.size());
+}
+
+//-------------------------------- pow ------------------------------------
+// Power of Poly by repeated squaring
+// Preconditions:   k >= 0
+// Postconditions:  returns this^k from the products of *; throws
+//       domain_error for a negative k and overflow_error if the degree
+//       would pass INT_MAX
+template <class T>
+BasicPoly<T> BasicPoly<T>::pow(int k) const {
+   if (k < 0)
+      throw domain_error("Poly pow: negative exponent");
+   if ((long long)highestExp * k > INT_MAX)
+      throw overflow_error("Poly pow: degree above INT_MAX");
+   BasicPoly result(T(1), 0), base(*this);
+   for (; k > 0; k >>= 1) {
+      if (k & 1)
+         result *= base;
+      if (k > 1)
+         base = base * base;
+   }
+   return result;
+}
+
+//-------------------------------- pow ------------------------------------
+// Truncated power: this^k mod x^n
+// Preconditions:   k >= 0
+// Postconditions:  returns this^k mod x^n from polycompose::power(), in
+//       the traits' Word; throws domain_error for a negative k
+template <class T>
+BasicPoly<T> BasicPoly<T>::pow(int k, int n) const {
+   typedef typename PolyCoeffTraits<T>::Word W;
+   if (k < 0)
+      throw domain_error("Poly pow: negative exponent");
+   if (n <= 0)
+      return BasicPoly();
+   vector<T> scratch;
+   int na;
+   const T* a = lowCoeffs(scratch, n, na);
+   if (na == 0)
+      return (k == 0) ? BasicPoly(T(1), 0) : BasicPoly();
+   vector<W> out(n);
+   polycompose::power(reinterpret_cast<const W*>(a), na, k, n, &out[0],
+                      DenseMul<T>());
+   return fromDense(reinterpret_cast<const T*>(out.data()), n);
+}
+
+//---------------------------- taylorShift --------------------------------
+// Taylor shift: this Poly at x + c
+// Preconditions:   none
+// Postconditions:  returns A(x + c) from shiftCoeffs()
+template <class T>
+BasicPoly<T> BasicPoly<T>::taylorShift(T c) const {
+   vector<T> scratch, out;
+   int d;
+   const T* a = denseCoeffs(scratch, d);
+   if (d == 0)
+      return BasicPoly();
+   out.resize(d);
+   shiftCoeffs(a, d, c, &out[0]);
+   return fromDense(out.data(), d);
+}
+
+//------------------------------ compose ----------------------------------
+// Composition: this Poly at another Poly, modulo x^n
+// Preconditions:   none
+// Postconditions:  returns A(B) mod x^n from polycompose::compose(), in
+//       the traits' Word, reading only the terms of B below x^n
+template <class T>
+BasicPoly<T> BasicPoly<T>::compose(const BasicPoly& inner, int n) const {
+   typedef typename PolyCoeffTraits<T>::Word W;
+   if (n <= 0)
+      return BasicPoly();
+   vector<T> scratchA, scratchB;
+   int na, nb;
+   const T* a = denseCoeffs(scratchA, na);
+   const T* b = inner.lowCoeffs(scratchB, n, nb);
+   if (na == 0)
+      return BasicPoly();
+   T zero(0);
+   if (nb == 0) {
+      b = &zero;
+      nb = 1;
+   }
+   vector<W> out(n);
+   polycompose::compose(reinterpret_cast<const W*>(a), na,
+                        reinterpret_cast<const W*>(b), nb, n, &out[0],
+                        DenseMul<T>());
+   return fromDense(reinterpret_cast<const T*>(out.data()), n);
+}
+
+//------------------------------  =  --------------------------------------
+// Overloaded assignment operator; current object = parameter
+// Preconditions:
+//       -- rhs.coeffPtr points to an array of at least size 1, or the
+//          SPARSE layout is in use
+// Postconditions:
+//       -- this object's array is reused if it has room for rhs's terms,
+//          otherwise it is deleted, and a new one with size equal to
+//          rhs's array is created
+//       -- all the terms from rhs's array are deep copied to this object's
+//          array
+//       -- the layout of rhs is copied along with its terms
+template <class T>
+BasicPoly<T>& BasicPoly<T>::operator=(const BasicPoly& rhs) {  
+   if (this == &rhs)
+      return *this;
+
+   POLY_STATS_ADD(COPIES, 1);
+   POLY_STATS_OP(OP_ASSIGN, rhs.storedSize());
+   storage = rhs.storage;
+   if (shareArray(rhs)) {
+      terms.clear();
+      sparse = false;
+      highestExp = rhs.highestExp;
+      copyCache(rhs);
+      return *this;
+   }
+   if (rhs.sparse) {
+      freeArray();
+      terms = rhs.terms;
+      highestExp = rhs.highestExp;
+      sparse = true;
+      copyCache(rhs);
+      return *this;
+   }
+
+   if (sparse || capacity < rhs.highestExp + 1 || isShared()) {
+      freeArray();
+      int size = rhs.highestExp + 1;
+      coeffPtr = allocArray(size);
+      capacity = size;
+      for (int i = capacity - 1; i > rhs.highestExp; i--)
+         coeffPtr[i] = 0;
+   } else {
+      for (int i = highestExp; i > rhs.highestExp; i--)
+         coeffPtr[i] = 0;
+   }
+   terms.clear();
+   sparse = false;
+   highestExp = rhs.highestExp;
+   for (int i = highestExp; i >= 0; i--)
+      coeffPtr[i] = rhs.coeffPtr[i];
+   copyCache(rhs);
+   
+   return *this;
+}
+
+//------------------------------  =  --------------------------------------
+// Move assignment operator; current object = temporary parameter
+// Preconditions:   none
+// Postconditions:
+//       -- this object's array is deleted, and rhs's array is taken over
+//          without copying
+//       -- rhs is left as the Poly 0*x^0 with no array
+template <class T>
+BasicPoly<T>& BasicPoly<T>::operator=(BasicPoly&& rhs) noexcept {
+   if (this == &rhs)
+      return *this;
+
+   POLY_STATS_ADD(MOVES, 1);
+   freeArray();
+   allocator = rhs.allocator;
+   coeffPtr = rhs.coeffPtr;
+   if (coeffPtr == rhs.inlineCoeffs) {
+      for (int i = INLINE_SIZE - 1; i >= 0; i--)
+         inlineCoeffs[i] = rhs.inlineCoeffs[i];
+      coeffPtr = inlineCoeffs;
+   }
+   capacity = rhs.capacity;
+   highestExp = rhs.highestExp;
+   sparse = rhs.sparse;
+   storage = rhs.storage;
+   terms.swap(rhs.terms);
+   copyCache(rhs);
+
+   rhs.coeffPtr = NULL;
+   rhs.capacity = 0;
+   rhs.highestExp = 0;
+   rhs.sparse = true;
+   rhs.terms.clear();
+   rhs.changed();
+   return *this;
+}
+
+//-----------------------------  +=  --------------------------------------
+// current object += parameter
+// Preconditions:
+//       -- rhs.coeffPtr points to an array of at least size 1, or the
+//          SPARSE layout is in use
+// Postconditions:
+//       -- all the terms from rhs's array are added into this object's
+//          array, which grows geometrically if rhs is longer
+//       -- the nonzero terms are merged instead if either Poly is SPARSE
+//          or the sum should be SPARSE
+//       -- highestExp drops below any leading terms that cancel
+template <class T>
+BasicPoly<T>& BasicPoly<T>::operator+=(const BasicPoly& rhs) {
+   POLY_STATS_OP(OP_ADD_ASSIGN, rhs.storedSize());
+   if (sparse || rhs.sparse) {
+      mergeTerms(rhs, 1);
+      return *this;
+   }
+   if (rhs.highestExp > highestExp) {
+      if (storage == AUTO && wantsSparse(rhs.highestExp + 1, 
+            termCount() + rhs.termCount(), false)) {
+         mergeTerms(rhs, 1);
+         return *this;
+      }
+      growDense(rhs.highestExp);
+   }
+   unshare();
+   changed();
+   T* out = coeffPtr;
+   const T* in = rhs.coeffPtr;
+   forRange(rhs.highestExp + 1, [out, in](int lo, int hi) {
+      for (int i = lo; i < hi; i++)
+         out[i] += in[i];
+   });
+   normalize();
+   return *this;
+}
+
+//-----------------------------  -=  --------------------------------------
+// current object -= parameter
+// Preconditions:
+//       -- rhs.coeffPtr points to an array of at least size 1, or the
+//          SPARSE layout is in use
+// Postconditions:
+//       -- all the terms from rhs's array are subtracted from this
+//          object's array, which grows geometrically if rhs is longer
+//       -- the nonzero terms are merged instead if either Poly is SPARSE
+//          or the difference should be SPARSE
+//       -- highestExp drops below any leading terms that cancel
+template <class T>
+BasicPoly<T>& BasicPoly<T>::operator-=(const BasicPoly& rhs) {
+   POLY_STATS_OP(OP_SUB_ASSIGN, rhs.storedSize());
+   if (sparse || rhs.sparse) {
+      mergeTerms(rhs, -1);
+      return *this;
+   }
+   if (rhs.highestExp > highestExp) {
+      if (storage == AUTO && wantsSparse(rhs.highestExp + 1, 
+            termCount() + rhs.termCount(), false)) {
+         mergeTerms(rhs, -1);
+         return *this;
+      }
+      growDense(rhs.highestExp);
+   }
+   unshare();
+   changed();
+   T* out = coeffPtr;
+   const T* in = rhs.coeffPtr;
+   forRange(rhs.highestExp + 1, [out, in](int lo, int hi) {
+      for (int i = lo; i < hi; i++)
+         out[i] -= in[i];
+   });
+   normalize();
+   return *this;
+}
+
+//-----------------------------  *=  --------------------------------------
+// current object *= parameter
+// Preconditions:   rhs.coeffPtr points to an array of at least size 1, or
+//       the SPARSE layout is in use
+// Postconditions:  *this is assigned to be the product of this and rhs.
+//       When one DENSE operand is below the Karatsuba threshold, the
+//       product is formed in place, in the traits' Word type, in this
+//       object's array, from the highest exponent down: coefficient k
+//       of the product only needs this object's coefficients at or
+//       below k, which are still unchanged.  Otherwise the product of
+//       multiply() is moved in
+template <class T>
+BasicPoly<T>& BasicPoly<T>::operator*=(const BasicPoly& rhs) {
+   POLY_STATS_OP(OP_MUL_ASSIGN, storedSize() + rhs.storedSize());
+   int n = highestExp + 1;
+   int m = rhs.highestExp + 1;
+   if (sparse || rhs.sparse || this == &rhs ||
+         min(n, m) >= polymul::KARATSUBA_THRESHOLD)
+      return *this = multiply(rhs);
+
+   int newHighestExp = highestExp + rhs.highestExp;
+   if (newHighestExp > highestExp)
+      growDense(newHighestExp);
+   unshare();
+   changed();
+   typedef typename PolyCoeffTraits<T>::Word W;
+   const W* a = reinterpret_cast<const W*>(coeffPtr);
+   const W* b = reinterpret_cast<const W*>(rhs.coeffPtr);
+   for (int k = newHighestExp; k >= 0; k--) {
+      W sum = 0;
+      int last = min(k, m - 1);
+      for (int j = max(0, k - (n - 1)); j <= last; j++)
+         sum += a[k - j] * b[j];
+      coeffPtr[k] = (T)sum;
+   }
+   chooseRepresentation();
+   return *this;
+}
+
+//---------------------------- unitInverse --------------------------------
+// The inverse of a leading coefficient, which makes a divisor monic
+// Preconditions:   lead != 0
+// Postconditions:  returns false if lead has no inverse in T, i.e. for an
+//       integer type, unless it is 1 or -1
+template <class T>
+static bool unitInverse(T lead, T& inverse) {
+   inverse = lead;
+   return lead == T(1) || lead == T(-1);
+}
+
+template <uint32_t P>
+static bool unitInverse(ModInt<P> lead, ModInt<P>& inverse) {
+   inverse = lead.inverse();
+   return true;
+}
+
+//--------------------------- exactQuotient -------------------------------
+// c / lead, if it is a coefficient of type T
+// Preconditions:   lead != 0, and lead is not -1 for the wrapping types
+// Postconditions:  returns false if lead does not divide c
+template <class T>
+static bool exactQuotient(T c, T lead, T& quotient) {
+   if (c % lead != 0)
+      return false;
+   quotient = c / lead;
+   return true;
+}
+
+static bool exactQuotient(CheckedInt c, CheckedInt lead,
+                          CheckedInt& quotient) {
+   if (lead == CheckedInt(-1)) {
+      quotient = -c;                  //throws for INT_MIN
+      return true;
+   }
+   if (c.value() % lead.value() != 0)
+      return false;
+   quotient = CheckedInt(c.value() / lead.value());
+   return true;
+}
+
+template <uint32_t P>
+static bool exactQuotient(ModInt<P> c, ModInt<P> lead, ModInt<P>& quotient) {
+   quotient = c * lead.inverse();
+   return true;
+}
+
+//---------------------------- divideDense --------------------------------
+// Divide coefficient arrays with remainder
+// Preconditions:   na >= 1, nb >= 1, b[nb - 1] != 0
+// Postconditions:  quotient holds the max(na - nb + 1, 0) coefficients of
+//       a / b, and remainder the nb - 1 coefficients of a mod b, computed
+//       in the traits' Word so that they wrap like multiplication does.
+//       -- a divisor with an invertible leading coefficient is made
+//          monic and divided by polytree::divideMonic(), which uses
+//          Newton iteration for long divisions on types with fast
+//          multiplication
+//       -- otherwise, and always for CheckedInt, whose Newton steps could
+//          overflow when the quotient does not, each quotient coefficient
+//          is found by long division with exactQuotient(); throws
+//          domain_error if one is not exact
+template <class T>
+static void divideDense(const T* a, int na, const T* b, int nb,
+                        vector<T>& quotient, vector<T>& remainder) {
+   typedef typename PolyCoeffTraits<T>::Word W;
+   int d = nb - 1;
+   T inverse;
+   if (unitInverse(b[d], inverse) && PolyCoeffTraits<T>::KARATSUBA) {
+      vector<W> m(nb), q, r;
+      for (int i = 0; i < nb; i++)
+         m[i] = (W)b[i] * (W)inverse;
+      polytree::divideMonic(reinterpret_cast<const W*>(a), na, &m[0], nb,
+                            q, r, DenseMul<T>());
+      quotient.resize(q.size());
+      for (size_t i = 0; i < q.size(); i++)
+         quotient[i] = (T)(q[i] * (W)inverse);
+      remainder.resize(d);
+      for (int i = 0; i < d; i++)
+         remainder[i] = (T)r[i];
+      return;
+   }
+
+   vector<W> r(na);
+   for (int i = 0; i < na; i++)
+      r[i] = (W)a[i];
+   quotient.assign(max(na - d, 0), T(0));
+   for (int i = na - 1; i >= d; i--) {
+      T c;
+      if (!exactQuotient((T)r[i], b[d], c))
+         throw domain_error("Poly division: quotient is not integral");
+      quotient[i - d] = c;
+      W* row = &r[i - d];
+      for (int j = 0; j < d; j++)
+         row[j] -= (W)c * (W)b[j];
+   }
+   remainder.resize(d);
+   for (int i = 0; i < d && i < na; i++)
+      remainder[i] = (T)r[i];
+   for (int i = na; i < d; i++)
+      remainder[i] = T(0);
+}
+
+//------------------------------ divmod -----------------------------------
+// Divide Poly by a divisor, with remainder
+// Preconditions:   the divisor is not zero; quotient and remainder are
+//       different Polys
+// Postconditions:  *this == quotient * divisor + remainder, with the
+//       remainder of lower degree than the divisor, both in the layout
+//       picked by chooseRepresentation().  Both operands are read before
+//       either result is written, so a result may be an operand.  Throws
+//       domain_error for a zero divisor or a non-integral quotient
+template <class T>
+void BasicPoly<T>::divmod(const BasicPoly& divisor, BasicPoly& quotient,
+                          BasicPoly& remainder) const {
+   POLY_STATS_OP(OP_DIVMOD, storedSize() + divisor.storedSize());
+   vector<T> scratchA, scratchB, q, r;
+   int na, nb;
+   const T* a = denseCoeffs(scratchA, na);
+   const T* b = divisor.denseCoeffs(scratchB, nb);
+   if (nb == 0)
+      throw domain_error("Poly division by zero");
+   if (na == 0) {
+      quotient = BasicPoly();
+      remainder = BasicPoly();
+      return;
+   }
+   divideDense(a, na, b, nb, q, r);
+   quotient = fromDense(q.data(), (int)q.size());
+   remainder = fromDense(r.data(), (int)r.size());
+}
+
+//--------------------------  /  and  %  ----------------------------------
+// Overloaded division and remainder operators
+// Preconditions:   as for divmod()
+// Postconditions:  the quotient or the remainder of divmod() is returned
+template <class T>
+BasicPoly<T> BasicPoly<T>::operator/(const BasicPoly& rhs) const {
+   BasicPoly quotient, remainder;
+   divmod(rhs, quotient, remainder);
+   return quotient;
+}
+
+template <class T>
+BasicPoly<T> BasicPoly<T>::operator%(const BasicPoly& rhs) const {
+   BasicPoly quotient, remainder;
+   divmod(rhs, quotient, remainder);
+   return remainder;
+}
+
+//-------------------------  /=  and  %=  ---------------------------------
+// current object = current object / parameter, or % parameter
+// Preconditions:   as for divmod()
+// Postconditions:  *this is assigned the quotient or the remainder
+template <class T>
+BasicPoly<T>& BasicPoly<T>::operator/=(const BasicPoly& rhs) {
+   BasicPoly remainder;
+   divmod(rhs, *this, remainder);
+   return *this;
+}
+
+template <class T>
+BasicPoly<T>& BasicPoly<T>::operator%=(const BasicPoly& rhs) {
+   BasicPoly quotient;
+   divmod(rhs, quotient, *this);
+   return *this;
+}
+
+//-----------------------------  ==  --------------------------------------
+// Determine if two Polys are equal
+// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
+//       least 1, or the SPARSE layout is in use
+// Postconditions:  
+//       -- true is returned if all terms in this object and rhs are equal
+//       -- false is returned if otherwise.  Both degrees are normalized,
+//          so different ones, like different known term counts or
+//          hashes, settle it without reading a term
+//       -- copies sharing one array are equal without reading it
+template <class T>
+bool BasicPoly<T>::operator==(const BasicPoly& rhs) const {
+   POLY_STATS_OP(OP_EQUAL, storedSize());
+   if (this == &rhs)
+      return true;
+   if (highestExp != rhs.highestExp) 
+      return false;
+   if (!sparse && !rhs.sparse && coeffPtr == rhs.coeffPtr)
+      return true;
+   int count = sparse ? (int)terms.size()
+                      : knownTerms.load(memory_order_relaxed);
+   int rhsCount = rhs.sparse ? (int)rhs.terms.size()
+                             : rhs.knownTerms.load(memory_order_relaxed);
+   if (count >= 0 && rhsCount >= 0 && count != rhsCount)
+      return false;
+   if (hashKnown.load(memory_order_acquire) &&
+         rhs.hashKnown.load(memory_order_acquire) &&
+         knownHash.load(memory_order_relaxed) !=
+         rhs.knownHash.load(memory_order_relaxed))
+      return false;
+   if (sparse || rhs.sparse) {
+      vector<Term> a, b;
+      getTerms(a);
+      rhs.getTerms(b);
+      if (a.size() != b.size())
+         return false;
+      for (int i = (int)a.size() - 1; i >= 0; i--)
+         if (a[i].exp != b[i].exp || a[i].coeff != b[i].coeff)
+            return false;
+      return true;
+   }
+   for (int i = highestExp; i >= 0; i--)
+      if (coeffPtr[i] != rhs.coeffPtr[i]) 
+         return false;
+   return true;
+}
+
+//-----------------------------  !=  --------------------------------------
+// Determine if two Polys are not equal
+// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
+//       least 1, or the SPARSE layout is in use
+// Postconditions:  
+//       -- false is returned if all terms in this object and rhs are equal
+//       -- true is returned if otherwise
+template <class T>
+bool BasicPoly<T>::operator!=(const BasicPoly& rhs) const {
+   return !(*this == rhs);
+}
+
+//------------------------------- parse -----------------------------------
+// Build a Poly from text in either form of polytext.h
+// Preconditions:   none
+// Postconditions:  returns the Poly; throws PolyParseError
+template <class T>
+BasicPoly<T> BasicPoly<T>::parse(string_view text) {
+   POLY_STATS_OP(OP_PARSE, 0);
+   vector<Term> list;
+   bool pairs;
+   int top;
+   polytext::Parser<T, Term> parser(text.data(), text.data() + text.size());
+   parser.terms(list, pairs, top);
+   POLY_STATS_ELEMENTS(OP_PARSE, list.size());
+   BasicPoly result;
+   result.putTerms(list, !pairs);
+   return result;
+}
+
+//---------------------------- writeCoeffs --------------------------------
+// Write n coefficients, coeff(k) for k < n, in the file layout of T
+// Preconditions:   none
+// Postconditions:  the coefficients are encoded a block at a time
+template <class T, class Get>
+static void writeCoeffs(ostream& out, int n, Get coeff) {
+   typedef polyio::Codec<T> Codec;
+   const int BLOCK = 4096;
+   vector<unsigned char> buffer(BLOCK * Codec::WIDTH);
+   for (int start = 0; start < n; start += BLOCK) {
+      int count = min(BLOCK, n - start);
+      for (int k = 0; k < count; k++)
+         Codec::encode(coeff(start + k), &buffer[k * Codec::WIDTH]);
+      out.write((const char*)&buffer[0], (streamsize)count * Codec::WIDTH);
+   }
+}
+
+//------------------------------- save ------------------------------------
+// Write Poly in the binary format of polyio.h
+// Preconditions:   out is open in binary mode
+// Postconditions:  the header is written, then the DENSE array or the
+//       SPARSE exponents and coefficients; a DENSE array of T in the
+//       file layout is written as it is in memory.  Throws runtime_error
+//       if out fails
+template <class T>
+void BasicPoly<T>::save(ostream& out) const {
+   POLY_STATS_OP(OP_SAVE, storedSize());
+   typedef polyio::Codec<T> Codec;
+   polyio::Header header;
+   header.version = polyio::VERSION;
+   header.width = Codec::WIDTH;
+   header.kind = Codec::KIND;
+   header.sparse = sparse;
+   header.modulus = Codec::MODULUS;
+   header.highestExp = highestExp;
+   header.count = sparse ? terms.size() : highestExp + 1;
+   unsigned char bytes[polyio::HEADER_SIZE];
+   polyio::writeHeader(header, bytes);
+   out.write((const char*)bytes, polyio::HEADER_SIZE);
+
+   int n = (int)header.count;
+   if (sparse) {
+      vector<unsigned char> exps(polyio::coeffOffset(header), 0);
+      for (int k = 0; k < n; k++)
+         polyio::putLE(&exps[4 * k], terms[k].exp, 4);
+      out.write((const char*)exps.data(), exps.size());
+      const vector<Term>& list = terms;
+      writeCoeffs<T>(out, n, [&list](int k) { return list[k].coeff; });
+   } else if (Codec::IN_PLACE && Codec::WIDTH == sizeof(T)) {
+      out.write((const char*)coeffPtr, (streamsize)n * sizeof(T));
+   } else {
+      const T* array = coeffPtr;
+      writeCoeffs<T>(out, n, [array](int k) { return array[k]; });
+   }
+   if (!out)
+      throw runtime_error("Poly file: write failed");
+}
+
+template <class T>
+void BasicPoly<T>::save(const string& path) const {
+   ofstream out(path.c_str(), ios::binary);
+   if (!out)
+      throw runtime_error("cannot open " + path);
+   save(out);
+}
+
+//------------------------------- load ------------------------------------
+// Read a Poly written by save()
+// Preconditions:   in is open in binary mode
+// Postconditions:  returns the Poly, in the layout picked by
+//       chooseRepresentation(); throws runtime_error if the data is not a
+//       Poly file whose coefficients can be read as T.  The payload is
+//       read a block at a time, so a count in the header that the stream
+//       does not back up is reported as truncated before much memory is
+//       taken
+template <class T>
+BasicPoly<T> BasicPoly<T>::load(istream& in) {
+   const uint64_t BLOCK = 1 << 20;
+   vector<unsigned char> bytes(polyio::HEADER_SIZE);
+   polyio::Header header;
+   if (!in.read((char*)&bytes[0], polyio::HEADER_SIZE))
+      throw runtime_error("Poly file: truncated");
+   polyio::readHeader(&bytes[0], 0, header);
+   uint64_t payload = polyio::payloadSize(header);
+   while (payload > 0) {
+      size_t have = bytes.size();
+      size_t count = (size_t)min(payload, BLOCK);
+      bytes.resize(have + count);
+      if (!in.read((char*)&bytes[have], (streamsize)count))
+         throw runtime_error("Poly file: truncated");
+      payload -= count;
+   }
+   return load(&bytes[0], bytes.size());
+}
+
+template <class T>
+BasicPoly<T> BasicPoly<T>::load(const string& path) {
+   ifstream in(path.c_str(), ios::binary);
+   if (!in)
+      throw runtime_error("cannot open " + path);
+   return load(in);
+}
+
+template <class T>
+BasicPoly<T> BasicPoly<T>::load(const void* data, size_t size) {
+   typedef polyio::Codec<T> Codec;
+   const unsigned char* bytes = (const unsigned char*)data;
+   polyio::Header header;
+   polyio::readHeader(bytes, size, header);
+   if (!polyio::accepts<T>(header))
+      throw runtime_error("Poly file: coefficients of another type");
+   int n = (int)header.count;
+   int width = header.width;
+   POLY_STATS_OP(OP_LOAD, n);
+   const unsigned char* exps = bytes + polyio::HEADER_SIZE;
+   const unsigned char* coeffs = exps + polyio::coeffOffset(header);
+
+   BasicPoly result;
+   if (!header.sparse) {
+      result.resetDense((int)header.highestExp);
+      if (Codec::IN_PLACE && width == sizeof(T)) {
+         memcpy(result.coeffPtr, coeffs, (size_t)n * sizeof(T));
+      } else {
+         for (int k = 0; k < n; k++)
+            result.coeffPtr[k] = Codec::decode(coeffs + k * width, width);
+      }
+      result.chooseRepresentation();
+      return result;
+   }
+
+   vector<Term> list;
+   list.reserve(n);
+   int64_t previous = -1;
+   for (int k = 0; k < n; k++) {
+      int64_t exponent = (int64_t)polyio::getLE(exps + 4 * k, 4);
+      if (exponent <= previous || exponent > (int64_t)header.highestExp)
+         throw runtime_error("Poly file: exponents out of order");
+      previous = exponent;
+      Term t = { Codec::decode(coeffs + (size_t)k * width, width),
+                 (int)exponent };
+      if (t.coeff != 0)
+         list.push_back(t);
+   }
+   result.setTerms(list, (int)header.highestExp);
+   return result;
+}
+
+//------------------------------ format -----------------------------------
+// Print Poly as operator<< does
+// Preconditions:   none
+// Postconditions:  the nonzero terms, highest exponent first, are
+//       rendered into a buffer by polytext::writeTerm(), and the buffer is
+//       handed to sink each time it holds FORMAT_CHUNK characters or more,
+//       and at the end.  DENSE zero runs are skipped by
+//       polytext::lastNonzero()
+template <class T>
+void BasicPoly<T>::format(const function<void(const char*, size_t)>& sink)
+      const {
+   POLY_STATS_OP(OP_FORMAT, storedSize());
+   char buffer[polytext::FORMAT_CHUNK + polytext::TERM_MAX];
+   char* out = buffer;
+   char* full = buffer + polytext::FORMAT_CHUNK;
+   int k = sparse ? (int)terms.size() - 1
+                  : polytext::lastNonzero(coeffPtr, highestExp);
+   while (k >= 0) {
+      if (sparse) {
+         out = polytext::writeTerm(out, terms[k].coeff, terms[k].exp);
+         k--;
+      } else {
+         out = polytext::writeTerm(out, coeffPtr[k], k);
+         k = polytext::lastNonzero(coeffPtr, k - 1);
+      }
+      if (out >= full) {
+         sink(buffer, out - buffer);
+         out = buffer;
+      }
+   }
+   if (out > buffer)
+      sink(buffer, out - buffer);
+}
+
+template <class T>
+void BasicPoly<T>::format(string& text) const {
+   format([&text](const char* chunk, size_t length) {
+      text.append(chunk, length);
+   });
+}
+
+template <class T>
+size_t BasicPoly<T>::format(char* buffer, size_t size) const {
+   size_t total = 0;
+   format([buffer, size, &total](const char* chunk, size_t length) {
+      if (total < size)
+         memcpy(buffer + total, chunk, min(length, size - total));
+      total += length;
+   });
+   return total;
+}
+
+//-----------------------------  <<  --------------------------------------
+// Overloaded output operator for class Poly
+// Preconditions:   coeffPtr must point to an array, or the SPARSE layout
+//       is in use
+// Postconditions:  prints polynomial in this fashion, with no trailing endl
+//          +3x^5 +7x^3 -2x^2 +9x +1
+//          note: includes positive/negative sign for first coefficient
+template <class T>
+ostream& operator<<(ostream& out, const BasicPoly<T>& a) {
+   a.format([&out](const char* text, size_t length) {
+      out.write(text, (streamsize)length);
+   });
+   return out;
+}
+
+//-----------------------------  >>  --------------------------------------
+// Overloaded input operator for class Poly; overwrites terms into Poly
+// *WARNING**  must be inputted in the specified format:
+//       [newCoeff] [newExp]   [newCoeff] [newExp] ...etc... -1 -1
+//       -- input "-1 -1" to end the input stream
+// Preconditions:
+//       -- coeffPtr must point to an array
+// Postconditions:  reads the characters of each pair straight from the
+//    stream buffer and parses the pair with polytext::Parser; once "-1 -1"
+//    is read, every term is inserted/overwritten into Poly by putTerms().
+//    A malformed pair, or the end of input before "-1 -1", sets failbit
+//    and leaves Poly unchanged.  A pair with a negative exponent, other
+//    than "-1 -1", is malformed, although setCoeff() ignores one
+template <class T>
+istream& operator>>(istream& in, BasicPoly<T>& rhs) {
+   typedef typename BasicPoly<T>::Term Term;
+   istream::sentry ok(in);          //flushes cout before lab1's input
+   if (!ok)
+      return in;
+   POLY_STATS_OP(OP_PARSE, 0);
+   streambuf* buffer = in.rdbuf();
+   vector<Term> list, one;
+   string pair;
+   for (;;) {
+      pair.clear();
+      for (int token = 0; token < 2; token++) {
+         int c = buffer->sgetc();
+         while (c != EOF && isspace(c))
+            c = buffer->snextc();
+         if (c == EOF) {
+            in.setstate(ios::eofbit | ios::failbit);
+            return in;
+         }
+         while (c != EOF && !isspace(c)) {
+            pair += (char)c;
+            c = buffer->snextc();
+         }
+         pair += ' ';
+      }
+      bool pairs;
+      int top;
+      try {
+         polytext::Parser<T, Term> parser(pair.data(),
+                                          pair.data() + pair.size());
+         parser.terms(one, pairs, top);
+      } catch (PolyParseError&) {
+         pairs = false;
+      }
+      if (!pairs) {
+         in.setstate(ios::failbit);
+         return in;
+      }
+      if (one.empty())                //-1 -1
+         break;
+      list.push_back(one[0]);
+   }
+   POLY_STATS_ELEMENTS(OP_PARSE, list.size());
+   rhs.putTerms(list, false);
+   return in;
+}
+
+//-------------------------- Instantiations -------------------------------
+// Every coefficient type of polycoeff.h; a ModInt<P> for another prime P
+// needs its own line here
+template class BasicPoly<int>;
+template class BasicPoly<int64_t>;
+template class BasicPoly<__int128>;
+template class BasicPoly<CheckedInt>;
+template class BasicPoly<ModInt<998244353> >;
+template class BasicPoly<ModInt<1000000007> >;
+
+template ostream& operator<<(ostream&, const BasicPoly<int>&);
+template ostream& operator<<(ostream&, const BasicPoly<int64_t>&);
+template ostream& operator<<(ostream&, const BasicPoly<__int128>&);
+template ostream& operator<<(ostream&, const BasicPoly<CheckedInt>&);
+template ostream& operator<<(ostream&,
+                             const BasicPoly<ModInt<998244353> >&);
+template ostream& operator<<(ostream&,
+                             const BasicPoly<ModInt<1000000007> >&);
+
+template istream& operator>>(istream&, BasicPoly<int>&);
+template istream& operator>>(istream&, BasicPoly<int64_t>&);
+template istream& operator>>(istream&, BasicPoly<__int128>&);
+template istream& operator>>(istream&, BasicPoly<CheckedInt>&);
+template istream& operator>>(istream&, BasicPoly<ModInt<998244353> >&);
+template istream& operator>>(istream&, BasicPoly<ModInt<1000000007> >&);
@@ -1,267 +1,1082 @@
-//-----------------------------------------------------------------------//
-// POLY.H                                                                //
-// Author: Luke Selbeck                                                  //
-// Date: April 9th, 2014                                                 //
-// Class: CSS 343                                                        //
-//                                                                       //
-// Poly holds a polynomial with non-negative exponents                   //
-//-----------------------------------------------------------------------//
-// Polynomial:  defined as a sum of coefficient and exponent pairs,      //
-//     called terms.                                                     //
-//                                                                       //
-//     Term example:       Coefficient  Exponent                         //
-//                               \         /                             //
-//                               +3  *  x^5                              //
-//                                                                       //
-//     Polynomial example: +3*x^5 +7*x^3 -2*x^2 +9*x +1                  //
-//                                                                       //
-// Implementation and assumptions:                                       //
-//   -- terms are stored in an array                                     //
-//         > array position denotates exponent value                     //
-//         > array values denotate coefficient values                    //
-//   -- does not accept non-int coefficient/exponent values              //
-//   -- does not accept non-positive exponent values                     //
-//-----------------------------------------------------------------------//
-
-#ifndef POLY_H
-#define POLY_H
-
-#include <iostream>
-using namespace std;
-
-
-class Poly {
-//-----------------------------  <<  --------------------------------------
-// Overloaded output operator for class Poly
-// Preconditions:   coeffPtr must point to an array
-// Postconditions:  prints exponent in this fashion, with no trailing endl
-//          +3*x^5 +7*x^3 -2*x^2 +9*x +1
-//          note: includes positive/negative sign for first coefficient
-friend ostream& operator<<(ostream&, const Poly&);
-
-//-----------------------------  >>  --------------------------------------
-// Overloaded input operator for class Poly; overwrites terms into Poly
-// *WARNING**  must be inputted in the specified format:
-//       [newCoeff] [newExp]   [newCoeff] [newExp] ...etc... -1 -1
-//       -- input "-1 -1" to end the input stream
-// Preconditions:
-//       -- coeffPtr must point to an array
-// Postconditions:  takes two ints as coefficient and exponent, does no
-//    error checking, inserts/overwrites term into Poly
-friend istream& operator>>(istream&, Poly&);
-
-public:
-//-------------------------- Constructor ----------------------------------
-// Default constructor for class Poly
-// Preconditions:   none
-// Postconditions:  
-//       -- an array of size 1 is created  
-//       -- one term is inserted into the array
-//             -- coefficient=0, and exponent=0
-//             -- i.e. 0*x^0
-Poly();
-
-//-------------------------- Constructor ----------------------------------
-// Constructor accepting one int as the coefficient of the 0th term
-// Preconditions:  none
-// Postconditions: 
-//       -- an array of size 1 is created  
-//       -- one term is inserted into the array
-//             -- coefficient=[int], and exponent=0
-//             -- i.e. [int]*x^0
-Poly(int);  
-
-//-------------------------- Constructor ----------------------------------
-// Constructor accepting two ints as coefficient and exponent, respectively
-//    of the term to be inserted 
-// Preconditions:  none
-// Postconditions:
-//       -- an array of size 1 is created  
-//       -- one term is inserted into the array
-//             -- coefficient=[int], and exponent=[int]
-//             -- i.e. [coefficient]*x^[exponent]
-Poly(int, int);
-
-//------------------------- Copy Constructor ------------------------------
-// Constructor accepting a Poly to be deep copied 
-// Preconditions:  none
-// Postconditions:
-//       -- a Poly an exact copy of the parameter is made
-Poly(const Poly&);
-
-//--------------------------- Destructor ----------------------------------
-// Destructor for class Poly
-// Preconditions:   coeffPtr points to memory on the heap
-// Postconditions:
-//       -- array for coeffPtr is deallocated
-//       -- highestExp = 0
-~Poly();
-
-//---------------------------- getCoeff -----------------------------------
-// Get the coefficient of an int exponent
-// Preconditions:   coeffPtr points to an array
-// Postconditions:  Returns the coefficient value for the exponent
-int getCoeff(int) const;
-
-//---------------------------- setCoeff -----------------------------------
-// Overwrite a term in Poly
-// Preconditions:   coeffPtr points to an array
-// Postconditions:  
-//       -- params are coefficient and exponent respectively
-//       -- if the exponent already exists within the Poly, that term is
-//          replaced with the new coefficient and exponent pair
-//       -- if the exponent is not already in the Poly, a new term is added
-//          to the Poly, consisting of the new coefficient and new exponent
-void setCoeff(int, int);
-
-//---------------------------- addCoeff -----------------------------------
-// Add a term to Poly
-// Preconditions:   coeffPtr points to an array
-// Postconditions:  
-//       -- params are coefficient and exponent respectively
-//       -- if the exponent already exists within the Poly, that term is
-//          added with the new coefficient and exponent pair
-//       -- if the exponent is not already in the Poly, a new term is added
-//          to the Poly, consisting of the new coefficient and new exponent
-void addCoeff(int, int);
-
-//---------------------------- subCoeff -----------------------------------
-// Subtract a term from Poly
-// Preconditions:   coeffPtr points to an array
-// Postconditions:  
-//       -- params are coefficient and exponent respectively
-//       -- if the exponent already exists within the Poly, the new
-//          coefficient and exponent pair is subtracted from the existing
-//          term          
-//       -- if the exponent is not already in the Poly, a new term is added
-//          to the Poly, consisting of the new coefficient's inverse
-//          and new exponent
-void subCoeff(int, int);
-
-//------------------------------  +  --------------------------------------
-// Overloaded addition operator; add 2 Polys
-// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
-//       least 1
-// Postconditions:  a Poly is returned, which is the sum of this object and
-//       rhs
-const Poly operator+(const Poly&) const;
-
-//------------------------------  +  --------------------------------------
-// Overloaded addition operator; add a Poly and an int
-// Preconditions:   coeffPtr point to array with size at least 1
-// Postconditions:  a Poly is returned, which is the sum of this object and
-//       the int
-const Poly operator+(int) const;
-
-//------------------------------  -  --------------------------------------
-// Overloaded subtraction operator; subtract 2 Polys
-// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
-//       least 1
-// Postconditions:  a Poly is returned, which is the negation of this
-//       object and rhs  
-const Poly operator-(const Poly&) const;
-
-//------------------------------  -  --------------------------------------
-// Overloaded subtraction operator; subtract an int from a Poly
-// Preconditions:   coeffPtr points to array with size at least 1
-// Postconditions:  a Poly is returned, which is the negation of this
-//       object and the int
-const Poly operator-(int) const;
-
-//------------------------------  *  --------------------------------------
-// Overloaded multiplication operator; multiply 2 Polys
-// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
-//       least 1
-// Postconditions:  a Poly is returned, which is the product of this object
-//       and rhs  
-const Poly operator*(const Poly&) const;
-
-//------------------------------  *  --------------------------------------
-// Overloaded multiplication operator; multiply a Poly and an int
-// Preconditions:   coeffPtr points to array with size at least 1
-// Postconditions:  a Poly is returned, which is the product of this object
-//       and the int
-const Poly operator*(int) const;
-
-//------------------------------  =  --------------------------------------
-// Overloaded assignment operator; current object = parameter
-// Preconditions:   rhs.coeffPtr points to an array of at least size 1
-// Postconditions:
-//       -- this object's array is deleted, and a new one with size equal
-//          to rhs's array is created
-//       -- all the terms from rhs's array are deep copied to this object's
-//          array
-Poly& operator=(const Poly&);
-
-//-----------------------------  +=  --------------------------------------
-// current object += parameter
-// Preconditions:   rhs.coeffPtr points to an array of at least size 1
-// Postconditions:
-//       -- all the terms from rhs's array are passed into this object's
-//          array using addCoeff()
-Poly& operator+=(const Poly&);
-
-//-----------------------------  -=  --------------------------------------
-// current object -= parameter
-// Preconditions:   rhs.coeffPtr points to an array of at least size 1
-// Postconditions:
-//       -- all the terms from rhs's array are passed into this object's
-//          array using subCoeff()
-Poly& operator-=(const Poly&);
-
-//-----------------------------  *=  --------------------------------------
-// current object *= parameter
-// Preconditions:   rhs.coeffPtr points to an array of at least size 1
-// Postconditions:  *this is assigned to be the product of this and rhs
-Poly& operator*=(const Poly&);
-
-//-----------------------------  ==  --------------------------------------
-// Determine if two Polys are equal
-// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
-//       least 1
-// Postconditions:  
-//       -- true is returned if all terms in this object and rhs are equal
-//       -- false is returned if otherwise
-bool operator==(const Poly&) const;
-
-//-----------------------------  !=  --------------------------------------
-// Determine if two Polys are not equal
-// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
-//       least 1
-// Postconditions:  
-//       -- false is returned if all terms in this object and rhs are equal
-//       -- true is returned if otherwise
-bool operator!=(const Poly&) const;
-
-//--------------------------- expIsValid ----------------------------------
-// Determines if the int passed is a valid exponent value in Poly
-// Preconditions:  none
-// Postconditions:
-//       -- returns true if exponent >= 0
-//       -- returns false if otherwise, and throws a cerr message
-bool expIsValid(int) const;
-
-private:
-   
-//--------------------------- resizeArray ---------------------------------
-// Copies coeffPtr's array into a new array of newSize
-// **NOTE** -- newSize should be greater than highestExp+1, otherwise, loss
-//             of data
-// Preconditions:
-//       -- coeffPtr points to an array
-// Postconditions:
-//       -- coeffPtr points to a new array of size newSize, with all the
-//          old array elements copied over
-//       -- the old array is deallocated
-void resizeArray(int);
-
-//pointer to an array storing the coefficients of the Poly
-int *coeffPtr;
-   
-//array size == highestExp + 1, because the array position is the 
-//exponent value
-int highestExp; 
-
-};
-
-#endif
+//-----------------------------------------------------------------------//
+// POLY.H                                                                //
+// Author: Luke Selbeck                                                  //
+// Date: April 9th, 2014                                                 //
+// Class: CSS 343                                                        //
+//                                                                       //
+// Poly holds a polynomial with non-negative exponents                   //
+// and int coefficients; BasicPoly<T> holds one with T coefficients      //
+//-----------------------------------------------------------------------//
+// Polynomial:  defined as a sum of coefficient and exponent pairs,      //
+//     called terms.                                                     //
+//                                                                       //
+//     Term example:       Coefficient  Exponent                         //
+//                               \         /                             //
+//                               +3  *  x^5                              //
+//                                                                       //
+//     Polynomial example: +3*x^5 +7*x^3 -2*x^2 +9*x +1                  //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- terms are stored in one of two layouts                           //
+//      DENSE:  terms are stored in an array                             //
+//         > array position denotates exponent value                     //
+//         > array values denotate coefficient values                    //
+//      SPARSE: only nonzero terms are stored                            //
+//         > (coefficient, exponent) pairs sorted by exponent            //
+//   -- the layout is picked from the term density unless one is         //
+//      requested with setRepresentation()                               //
+//   -- highestExp is always the true degree: every operation that can   //
+//      zero the leading term lowers it again.  The nonzero term count   //
+//      and a 64-bit hash are cached, and == compares them first         //
+//   -- the DENSE array comes from a PolyAllocator (see polyalloc.h),    //
+//      except that arrays of up to INLINE_SIZE terms are stored inside  //
+//      the Poly itself, with no allocation.  INLINE_SIZE is             //
+//      POLY_INLINE_SIZE, 8 unless set when compiling; 0 turns inline    //
+//      storage off, e.g. to compare timings (see bench.cpp)             //
+//   -- copies share an allocated array, which is reference counted      //
+//      with an atomic count in front of it, and copied only when a      //
+//      Poly sharing it is about to write to it (copy on write)          //
+//   -- coefficients are of type T: int for Poly, or any type of         //
+//      polycoeff.h.  Member functions are defined in poly.cpp and       //
+//      instantiated there for each of those types                       //
+//   -- compiled with POLY_STATS, allocations, copies and operator calls //
+//      are counted per thread (see polystats.h)                         //
+//   -- does not accept non-int exponent values                          //
+//   -- does not accept non-positive exponent values                     //
+//-----------------------------------------------------------------------//
+
+#ifndef POLY_H
+#define POLY_H
+
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "polyalloc.h"
+#include "polycoeff.h"
+#include "polystats.h"
+#include "polytext.h"
+#include "polythread.h"
+using namespace std;
+
+#ifndef POLY_INLINE_SIZE
+#define POLY_INLINE_SIZE 8
+#endif
+
+//-------------------------------- PolyExpr -------------------------------
+// Base of every Poly arithmetic expression, including Poly itself; the
+// expression layer built on it is in polyexpr.h
+template <class E>
+struct PolyExpr {
+   const E& self() const { return static_cast<const E&>(*this); }
+};
+
+//-------------------------------- PolyBase -------------------------------
+// Options shared by every coefficient type, so Poly::DENSE and
+// BasicPoly<int64_t>::DENSE are the same value
+struct PolyBase {
+//------------------------- Representation --------------------------------
+// Storage layout of the terms of a Poly
+//       -- AUTO:   DENSE or SPARSE, picked from the term density
+//       -- DENSE:  array where array position == exponent value
+//       -- SPARSE: nonzero terms only, sorted by increasing exponent
+enum Representation { AUTO, DENSE, SPARSE };
+
+//-------------------------- MulAlgorithm ---------------------------------
+// Multiplication algorithm used for DENSE operands by multiply()
+//       -- MUL_AUTO:       picked from the operand sizes
+//       -- MUL_SCHOOLBOOK: O(n*m) double loop
+//       -- MUL_KARATSUBA:  Karatsuba above the schoolbook threshold
+//       -- MUL_TOOM3:      Karatsuba, then Toom-3 for larger operands
+//       -- MUL_NTT:        number theoretic transform modulo three primes,
+//                          recombined exactly with the Chinese remainder
+//                          theorem
+// An algorithm that is not exact for the coefficient type falls back to
+// the next simpler one (see polycoeff.h)
+enum MulAlgorithm { MUL_AUTO, MUL_SCHOOLBOOK, MUL_KARATSUBA, MUL_TOOM3,
+                    MUL_NTT };
+
+//---------------------------- Execution ----------------------------------
+// Where large operations run
+//       -- EXEC_DEFAULT:  as chosen by a PolyExecutionScope of the calling
+//                         thread, else by setExecution()
+//       -- EXEC_SERIAL:   on the calling thread only
+//       -- EXEC_PARALLEL: on PolyThreadPool::shared() (see polythread.h),
+//                         for products of at least PARALLEL_MIN_MUL terms
+//                         and +, -, scalar * of at least
+//                         PARALLEL_MIN_TERMS terms; smaller ones stay
+//                         serial
+// Results are the same either way
+enum Execution { EXEC_DEFAULT, EXEC_SERIAL, EXEC_PARALLEL };
+
+//---------------------------- getExecution -------------------------------
+// Get the Execution EXEC_DEFAULT stands for on the calling thread
+// Preconditions:   none
+// Postconditions:  returns EXEC_SERIAL or EXEC_PARALLEL
+static Execution getExecution();
+
+//---------------------------- setExecution -------------------------------
+// Change the Execution EXEC_DEFAULT stands for, on every thread
+// Preconditions:   the parameter is EXEC_SERIAL or EXEC_PARALLEL
+// Postconditions:  returns the previous setting; initially EXEC_SERIAL
+static Execution setExecution(Execution);
+
+//products run in parallel once the shorter operand has this many terms
+static const int PARALLEL_MIN_MUL = 4096;
+//+, -, and scalar * run in parallel from this many terms, in pieces of
+//PARALLEL_GRAIN terms
+static const int PARALLEL_MIN_TERMS = 1 << 16;
+static const int PARALLEL_GRAIN = 1 << 14;
+
+//---------------------------- forRange -----------------------------------
+// Run fn(lo, hi) over pieces of [0, n) covering every index once: in
+// parallel under EXEC_PARALLEL when n >= PARALLEL_MIN_TERMS, otherwise
+// in one call fn(0, n) on the calling thread
+template <class F> static void forRange(int n, F fn);
+
+//resolve EXEC_DEFAULT to EXEC_SERIAL or EXEC_PARALLEL
+static Execution resolve(Execution);
+
+private:
+friend class PolyExecutionScope;
+static atomic<int>& globalExecution() {
+   static atomic<int> execution(EXEC_SERIAL);
+   return execution;
+}
+static Execution& scopeExecution() {
+   static thread_local Execution execution = EXEC_DEFAULT;
+   return execution;
+}
+};
+
+//-------------------------- PolyExecutionScope ---------------------------
+// Makes an Execution the default of this thread until the end of a scope
+class PolyExecutionScope {
+public:
+explicit PolyExecutionScope(PolyBase::Execution execution) {
+   previous = PolyBase::scopeExecution();
+   PolyBase::scopeExecution() = execution;
+}
+~PolyExecutionScope() {
+   PolyBase::scopeExecution() = previous;
+}
+
+private:
+PolyExecutionScope(const PolyExecutionScope&);
+PolyExecutionScope& operator=(const PolyExecutionScope&);
+
+PolyBase::Execution previous;
+};
+
+inline PolyBase::Execution PolyBase::getExecution() {
+   Execution scoped = scopeExecution();
+   return (scoped != EXEC_DEFAULT) ? scoped
+                                   : (Execution)globalExecution().load();
+}
+
+inline PolyBase::Execution PolyBase::setExecution(Execution execution) {
+   return (Execution)globalExecution().exchange(execution);
+}
+
+inline PolyBase::Execution PolyBase::resolve(Execution execution) {
+   return (execution == EXEC_DEFAULT) ? getExecution() : execution;
+}
+
+template <class F>
+void PolyBase::forRange(int n, F fn) {
+   if (n >= PARALLEL_MIN_TERMS && getExecution() == EXEC_PARALLEL)
+      PolyThreadPool::shared().parallelFor(0, n, PARALLEL_GRAIN, fn);
+   else
+      fn(0, n);
+}
+
+template <class T> class BasicPoly;
+template <class T> class PolyCache;
+template <class T> ostream& operator<<(ostream&, const BasicPoly<T>&);
+template <class T> istream& operator>>(istream&, BasicPoly<T>&);
+
+template <class T>
+class BasicPoly : public PolyExpr<BasicPoly<T> >, public PolyBase {
+static_assert(is_trivially_copyable<T>::value,
+              "coefficients are copied as bytes");
+
+//-----------------------------  <<  --------------------------------------
+// Overloaded output operator for class Poly
+// Preconditions:   coeffPtr must point to an array
+// Postconditions:  prints exponent in this fashion, with no trailing endl,
+//    through format()
+//          +3*x^5 +7*x^3 -2*x^2 +9*x +1
+//          note: includes positive/negative sign for first coefficient
+friend ostream& operator<< <>(ostream&, const BasicPoly&);
+
+//-----------------------------  >>  --------------------------------------
+// Overloaded input operator for class Poly; overwrites terms into Poly
+// *WARNING**  must be inputted in the specified format:
+//       [newCoeff] [newExp]   [newCoeff] [newExp] ...etc... -1 -1
+//       -- input "-1 -1" to end the input stream
+// Preconditions:
+//       -- coeffPtr must point to an array
+// Postconditions:  reads pairs up to "-1 -1" and inserts/overwrites them
+//    into Poly all at once (see polytext.h); a malformed pair sets
+//    failbit and leaves Poly unchanged
+friend istream& operator>> <>(istream&, BasicPoly&);
+
+//the leaves and nodes of the expression layer read the array directly
+template <class> friend struct PolyRef;
+template <class> friend struct PolyTemp;
+template <class> friend struct PolyScaled;
+
+//MultiPoly hands its Kronecker images to BasicPoly as sorted terms
+template <class> friend class BasicMultiPoly;
+
+public:
+//coefficient type
+typedef T Coeff;
+
+//------------------------------ Term -------------------------------------
+// One coefficient and exponent pair, as stored by the SPARSE layout
+struct Term {
+   T coeff;
+   int exp;
+};
+
+//-------------------------- Constructor ----------------------------------
+// Default constructor for class Poly
+// Preconditions:   none
+// Postconditions:  
+//       -- an array of size 1 is created  
+//       -- one term is inserted into the array
+//             -- coefficient=0, and exponent=0
+//             -- i.e. 0*x^0
+BasicPoly();
+
+//-------------------------- Constructor ----------------------------------
+// Constructor accepting one T as the coefficient of the 0th term
+// Preconditions:  none
+// Postconditions: 
+//       -- an array of size 1 is created  
+//       -- one term is inserted into the array
+//             -- coefficient=[T], and exponent=0
+//             -- i.e. [T]*x^0
+BasicPoly(T);  
+
+//-------------------------- Constructor ----------------------------------
+// Constructor accepting a T coefficient and an int exponent, respectively
+//    of the term to be inserted 
+// Preconditions:  none
+// Postconditions:
+//       -- an array of size 1 is created  
+//       -- one term is inserted into the array
+//             -- coefficient=[T], and exponent=[int]
+//             -- i.e. [coefficient]*x^[exponent]
+BasicPoly(T, int);
+
+//------------------------- Copy Constructor ------------------------------
+// Constructor accepting a Poly to be copied
+// Preconditions:  none
+// Postconditions:
+//       -- a Poly an exact copy of the parameter is made; an allocated
+//          DENSE array is shared, in O(1), until either Poly changes
+BasicPoly(const BasicPoly&);
+
+//------------------------- Move Constructor ------------------------------
+// Constructor taking over the terms of a Poly that is about to go away
+// Preconditions:  none
+// Postconditions:
+//       -- this Poly holds the parameter's terms and array, nothing is
+//          allocated; only an inline array is copied
+//       -- the parameter is left as the Poly 0*x^0 with no array
+BasicPoly(BasicPoly&&) noexcept;
+
+//------------------------- Expression Constructor ------------------------
+// Constructor evaluating a Poly expression of +, - and scalar *, such as
+// A + B - C * 2 (see polyexpr.h)
+// Preconditions:  none
+// Postconditions:
+//       -- the whole expression is evaluated in one pass over the
+//          coefficients into one newly allocated array
+//       -- for a temporary expression, the array of a temporary Poly
+//          inside it is reused if it is large enough
+template <class E> BasicPoly(const PolyExpr<E>&);
+template <class E> BasicPoly(PolyExpr<E>&&);
+
+//--------------------------- Destructor ----------------------------------
+// Destructor for class Poly
+// Preconditions:   coeffPtr points to memory on the heap
+// Postconditions:
+//       -- array for coeffPtr is given back to its allocator
+//       -- highestExp = 0
+~BasicPoly();
+
+//---------------------------- getCoeff -----------------------------------
+// Get the coefficient of an int exponent
+// Preconditions:   coeffPtr points to an array
+// Postconditions:  Returns the coefficient value for the exponent
+T getCoeff(int) const;
+
+//---------------------------- setCoeff -----------------------------------
+// Overwrite a term in Poly
+// Preconditions:   coeffPtr points to an array
+// Postconditions:  
+//       -- params are coefficient and exponent respectively
+//       -- if the exponent already exists within the Poly, that term is
+//          replaced with the new coefficient and exponent pair
+//       -- if the exponent is not already in the Poly, a new term is added
+//          to the Poly, consisting of the new coefficient and new exponent
+void setCoeff(T, int);
+
+//---------------------------- addCoeff -----------------------------------
+// Add a term to Poly
+// Preconditions:   coeffPtr points to an array
+// Postconditions:  
+//       -- params are coefficient and exponent respectively
+//       -- if the exponent already exists within the Poly, that term is
+//          added with the new coefficient and exponent pair
+//       -- if the exponent is not already in the Poly, a new term is added
+//          to the Poly, consisting of the new coefficient and new exponent
+void addCoeff(T, int);
+
+//---------------------------- subCoeff -----------------------------------
+// Subtract a term from Poly
+// Preconditions:   coeffPtr points to an array
+// Postconditions:  
+//       -- params are coefficient and exponent respectively
+//       -- if the exponent already exists within the Poly, the new
+//          coefficient and exponent pair is subtracted from the existing
+//          term          
+//       -- if the exponent is not already in the Poly, a new term is added
+//          to the Poly, consisting of the new coefficient's inverse
+//          and new exponent
+void subCoeff(T, int);
+
+//------------------------ setRepresentation ------------------------------
+// Choose the storage layout of this Poly
+// Preconditions:   none
+// Postconditions:
+//       -- the terms are converted to the requested layout; AUTO picks
+//          the layout from the term density, now and whenever the Poly
+//          grows
+//       -- the terms themselves are unchanged
+void setRepresentation(Representation);
+
+//------------------------ getRepresentation ------------------------------
+// Get the storage layout requested for this Poly
+// Preconditions:   none
+// Postconditions:  returns AUTO, DENSE or SPARSE as last requested
+Representation getRepresentation() const;
+
+//----------------------------- isSparse ----------------------------------
+// Determine which layout currently holds the terms
+// Preconditions:   none
+// Postconditions:  returns true if the SPARSE layout is in use
+bool isSparse() const;
+
+//----------------------------- reserve -----------------------------------
+// Make room in the DENSE array for a number of exponents
+// Preconditions:   none
+// Postconditions:  the array has room for at least the parameter's number
+//       of exponents, so setCoeff() below it does not reallocate.  Does
+//       nothing for the SPARSE layout
+void reserve(int);
+
+//--------------------------- getCapacity ---------------------------------
+// Get the number of exponents the DENSE array has room for
+// Preconditions:   none
+// Postconditions:  returns the array size, >= highestExp + 1, or 0 for the
+//       SPARSE layout
+int getCapacity() const;
+
+//---------------------------- termCount ----------------------------------
+// Count the nonzero terms of Poly
+// Preconditions:   none
+// Postconditions:  returns the number of terms with a nonzero coefficient;
+//       counted once and cached until the terms change
+int termCount() const;
+
+//------------------------------- hash ------------------------------------
+// 64-bit hash of the value of Poly
+// Preconditions:   none
+// Postconditions:  returns the sum of a hash of each nonzero term, so
+//       equal Polys hash alike whatever their layout.  Computed once and
+//       cached until the terms change; setCoeff() and addCoeff() update
+//       it in O(1)
+uint64_t hash() const;
+
+//---------------------------- evaluate -----------------------------------
+// Evaluate Poly at one point, of an integer, floating point or
+// coefficient type X (see polyeval.h)
+// Preconditions:   X can be made from T
+// Postconditions:  returns the sum of coefficient * x^exponent over all
+//       terms; integer points wrap on overflow like int products do
+template <class X> X evaluate(X) const;
+
+//---------------------------- evaluate -----------------------------------
+// Evaluate Poly at many points, several at a time with SIMD
+// Preconditions:   xs and out hold n points each; out is either xs or
+//       does not overlap it
+// Postconditions:  out[i] = evaluate(xs[i]) for i < n, up to floating
+//       point rounding
+template <class X> void evaluate(const X*, X*, size_t) const;
+
+//--------------------------- interpolate ---------------------------------
+// Build the Poly through n points (xs[i], ys[i]) with a subproduct tree
+// (see polytree.h), in O(M(n) log n) time
+// Preconditions:   T is a field, i.e. ModInt; the xs are distinct
+// Postconditions:  returns the Poly of degree < n whose value at xs[i] is
+//       ys[i]; throws domain_error for other coefficient types or equal
+//       points
+static BasicPoly interpolate(const T*, const T*, int);
+
+//------------------------------- gcd -------------------------------------
+// Greatest common divisor of two Polys, by the Euclidean algorithm, with
+// half-GCD steps for high degrees (see polygcd.h)
+// Preconditions:   T is a field, i.e. ModInt
+// Postconditions:  returns the monic gcd, or the zero Poly if both are
+//       zero; throws domain_error for other coefficient types
+static BasicPoly gcd(const BasicPoly&, const BasicPoly&);
+
+//------------------------------- xgcd ------------------------------------
+// Extended gcd of two Polys
+// Preconditions:   as for gcd()
+// Postconditions:  returns gcd(a, b) and sets s and t (the last two
+//       parameters) with s * a + t * b == gcd(a, b), deg s < deg b and
+//       deg t < deg a
+static BasicPoly xgcd(const BasicPoly&, const BasicPoly&, BasicPoly&,
+                      BasicPoly&);
+
+//---------------------------- resultant ----------------------------------
+// Resultant of two Polys: the determinant of their Sylvester matrix
+// Preconditions:   as for gcd()
+// Postconditions:  returns the resultant, which is 0 exactly when they
+//       have a common factor, or one is zero, and 1 for two nonzero
+//       constants
+static T resultant(const BasicPoly&, const BasicPoly&);
+
+//--------------------------- seriesInverse -------------------------------
+// Power series inverse to n terms, by Newton iteration (see polyseries.h)
+// Preconditions:   T is a field, i.e. ModInt; the constant term is not 0
+// Postconditions:  returns B of degree < n with this * B == 1 mod x^n;
+//       only the terms below x^n are read, and n <= 0 gives the zero
+//       Poly.  Throws domain_error for other coefficient types or a zero
+//       constant term
+BasicPoly seriesInverse(int) const;
+
+//----------------------------- seriesLog ---------------------------------
+// Power series logarithm to n terms
+// Preconditions:   T is a field; the constant term is 1; n is at most the
+//       modulus P
+// Postconditions:  returns log(this) mod x^n, with a constant term of 0;
+//       throws domain_error otherwise
+BasicPoly seriesLog(int) const;
+
+//----------------------------- seriesExp ---------------------------------
+// Power series exponential to n terms
+// Preconditions:   T is a field; the constant term is 0; n is at most the
+//       modulus P
+// Postconditions:  returns exp(this) mod x^n, with a constant term of 1;
+//       throws domain_error otherwise
+BasicPoly seriesExp(int) const;
+
+//---------------------------- seriesSqrt ---------------------------------
+// Power series square root to n terms
+// Preconditions:   T is a field; the constant term is a nonzero square
+// Postconditions:  returns B of degree < n with B * B == this mod x^n,
+//       whose constant term is one of the two square roots; throws
+//       domain_error otherwise
+BasicPoly seriesSqrt(int) const;
+
+//------------------------------- parse -----------------------------------
+// Build a Poly from text: "coeff exp" pairs as read by >>, or the form
+// printed by <<, e.g. " +5x^7 -4x^3 +10x -2" (see polytext.h)
+// Preconditions:   none
+// Postconditions:  returns the Poly, allocated once for its highest
+//       exponent; throws PolyParseError, with the offset of the first
+//       malformed character
+static BasicPoly parse(string_view);
+
+//------------------------------ format -----------------------------------
+// Print Poly as operator<< does, with to_chars() (see polytext.h)
+//       -- to a sink, called with each chunk of at most about
+//          FORMAT_CHUNK characters, so a huge Poly streams out in pieces
+//       -- appended to a string, whose capacity can be reused
+//       -- into a char buffer of a given size
+// Preconditions:   none
+// Postconditions:  the text is exactly what operator<< prints.  The char
+//       buffer version writes at most size characters, adds no '\0', and
+//       returns the full length, which exceeds size if it was too small
+void format(const function<void(const char*, size_t)>&) const;
+void format(string&) const;
+size_t format(char*, size_t) const;
+
+//------------------------------- save ------------------------------------
+// Write Poly in the binary format of polyio.h, to a stream or a file
+// Preconditions:   a stream is open in binary mode
+// Postconditions:  the terms are written in the current layout; throws
+//       runtime_error if writing fails
+void save(ostream&) const;
+void save(const string&) const;
+
+//------------------------------- load ------------------------------------
+// Read a Poly written by save(), from a stream, a file, or its bytes in
+// memory
+// Preconditions:   a stream is open in binary mode
+// Postconditions:  returns the Poly, in the layout picked from its term
+//       density; throws runtime_error if the data is not a Poly file
+//       whose coefficients can be read as T (see polyio.h)
+static BasicPoly load(istream&);
+static BasicPoly load(const string&);
+static BasicPoly load(const void*, size_t);
+
+//--------------------------- getAllocator --------------------------------
+// Get the allocator the DENSE array comes from
+// Preconditions:   none
+// Postconditions:  returns the allocator, the thread's default when this
+//       Poly was made unless it was moved from another Poly or changed
+//       with setAllocator()
+PolyAllocator* getAllocator() const;
+
+//--------------------------- setAllocator --------------------------------
+// Change the allocator the DENSE array comes from
+// Preconditions:   the allocator outlives this Poly; NULL means the
+//       thread's default allocator
+// Postconditions:  the DENSE array is copied into an array from the new
+//       allocator and the old one is given back; the terms are unchanged
+void setAllocator(PolyAllocator*);
+
+//------------------------------  *  --------------------------------------
+// Overloaded multiplication operator; multiply 2 Polys
+// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
+//       least 1
+// Postconditions:  a Poly is returned, which is the product of this object
+//       and rhs, computed by multiply() with MUL_AUTO
+BasicPoly operator*(const BasicPoly&) const;
+
+//----------------------------- multiply ----------------------------------
+// Multiply 2 Polys with a chosen algorithm and Execution
+// Preconditions:   none
+// Postconditions:  
+//       -- a Poly is returned, which is the product of this object and
+//          rhs; every algorithm gives exactly the same terms
+//       -- MUL_AUTO multiplies term by term, merging in a heap (see
+//          polysparse.h), when the term counts make that cheaper than a
+//          dense product, as for most SPARSE operands; otherwise it
+//          picks schoolbook, Karatsuba, Toom-3 or NTT by size
+//       -- any other algorithm works on DENSE copies of SPARSE operands
+//       -- under EXEC_PARALLEL, large DENSE products by any algorithm
+//          but MUL_SCHOOLBOOK are split into subproducts that run on
+//          the thread pool
+//       -- under MUL_AUTO, a PolyCache current in this thread (see
+//          polycache.h) is asked for the product first, and keeps it
+//       -- throws overflow_error if the degree would pass INT_MAX, as
+//          for SPARSE operands of high degree
+BasicPoly multiply(const BasicPoly&, MulAlgorithm = MUL_AUTO,
+                   Execution = EXEC_DEFAULT) const;
+
+//------------------------------ mullow -----------------------------------
+// Truncated product: the terms of this object * rhs below x^n
+// Preconditions:   none
+// Postconditions:  returns (this * rhs) mod x^n, for which only the terms
+//       of each operand below x^n are read and only the needed pairs
+//       multiplied (see polyseries.h); the zero Poly for n <= 0.  Throws
+//       overflow_error if the product of those terms would have a degree
+//       above INT_MAX
+BasicPoly mullow(const BasicPoly&, int) const;
+
+//------------------------------ mulhigh ----------------------------------
+// High part of a product: the terms of this object * rhs from x^k up
+// Preconditions:   k >= 0
+// Postconditions:  returns (this * rhs) div x^k, i.e. those terms with k
+//       taken off their exponents; products with a short operand skip
+//       the pairs below x^k.  Throws overflow_error if the degree of
+//       this * rhs would pass INT_MAX
+BasicPoly mulhigh(const BasicPoly&, int) const;
+
+//-------------------------------- pow ------------------------------------
+// Power of Poly by repeated squaring
+// Preconditions:   k >= 0
+// Postconditions:  returns this^k, with this^0 == 1, in about log2(k)
+//       products; throws domain_error for a negative k and overflow_error
+//       if the degree would pass INT_MAX
+BasicPoly pow(int) const;
+
+//-------------------------------- pow ------------------------------------
+// Truncated power: this^k mod x^n
+// Preconditions:   k >= 0
+// Postconditions:  returns this^k mod x^n, squaring with mullow() so that
+//       no product is longer than n terms (see polycompose.h); the zero
+//       Poly for n <= 0.  Throws domain_error for a negative k
+BasicPoly pow(int, int) const;
+
+//---------------------------- taylorShift --------------------------------
+// Taylor shift: this Poly at x + c
+// Preconditions:   none
+// Postconditions:  returns A(x + c) for A this Poly, in O(M(n) log n) time
+//       or better rather than O(n^2) (see polycompose.h); over ModInt by
+//       one product
+BasicPoly taylorShift(T) const;
+
+//------------------------------ compose ----------------------------------
+// Composition: this Poly at another Poly, modulo x^n
+// Preconditions:   none
+// Postconditions:  returns A(B) mod x^n for A this Poly and B the
+//       parameter, by Brent and Kung's baby steps and giant steps (see
+//       polycompose.h); the whole of A(B) when n > deg A * deg B, and the
+//       zero Poly for n <= 0
+BasicPoly compose(const BasicPoly&, int) const;
+
+//------------------------------  =  --------------------------------------
+// Overloaded assignment operator; current object = parameter
+// Preconditions:   rhs.coeffPtr points to an array of at least size 1
+// Postconditions:
+//       -- an allocated DENSE array of rhs from this object's allocator
+//          is shared, in O(1), until either Poly changes
+//       -- otherwise this object's array is reused if it has room for
+//          rhs's terms and is not shared, else it is released, and a new
+//          one with size equal to rhs's array is created, and all the
+//          terms from rhs's array are copied to it
+BasicPoly& operator=(const BasicPoly&);
+
+//------------------------------  =  --------------------------------------
+// Move assignment operator; current object = temporary parameter
+// Preconditions:   none
+// Postconditions:
+//       -- this object's array is deleted, and rhs's array is taken over
+//          without copying, unless it is inline
+//       -- rhs is left as the Poly 0*x^0 with no array
+BasicPoly& operator=(BasicPoly&&) noexcept;
+
+//------------------------------  =  --------------------------------------
+// Assignment from a Poly expression of +, - and scalar *; e.g. in
+// D = A * B - 15 the product is formed first, then the subtraction is
+// evaluated lazily (see polyexpr.h)
+// Preconditions:   none
+// Postconditions:
+//       -- the whole expression is evaluated in one pass over the
+//          coefficients, into this object's array if it has room,
+//          otherwise into the array of a temporary Poly inside a
+//          temporary expression, otherwise into one new array
+//       -- this object may appear in the expression, e.g. A = A + B
+//       -- the layout requested for this object is kept
+template <class E> BasicPoly& operator=(const PolyExpr<E>&);
+template <class E> BasicPoly& operator=(PolyExpr<E>&&);
+
+//-----------------------------  +=  --------------------------------------
+// current object += parameter
+// Preconditions:   rhs.coeffPtr points to an array of at least size 1
+// Postconditions:
+//       -- all the terms from rhs's array are passed into this object's
+//          array using addCoeff()
+BasicPoly& operator+=(const BasicPoly&);
+
+//-----------------------------  -=  --------------------------------------
+// current object -= parameter
+// Preconditions:   rhs.coeffPtr points to an array of at least size 1
+// Postconditions:
+//       -- all the terms from rhs's array are passed into this object's
+//          array using subCoeff()
+BasicPoly& operator-=(const BasicPoly&);
+
+//-----------------------------  *=  --------------------------------------
+// current object *= parameter
+// Preconditions:   rhs.coeffPtr points to an array of at least size 1
+// Postconditions:  *this is assigned to be the product of this and rhs.
+//       Small products are computed in place in this object's array
+BasicPoly& operator*=(const BasicPoly&);
+
+//------------------------------ divmod -----------------------------------
+// Divide Poly by a divisor, with remainder
+// Preconditions:   the divisor is not zero, and the quotient and the
+//       remainder are different Polys (either may be this Poly or the
+//       divisor).  T is a field (ModInt), or the leading coefficient of
+//       the divisor is 1 or -1, or it divides every coefficient of the
+//       quotient exactly
+// Postconditions:  *this == quotient * divisor + remainder, with the
+//       remainder of lower degree than the divisor.  Long divisions take
+//       a few multiplications, by Newton iteration (see polytree.h).
+//       Throws domain_error for a zero divisor, or if the quotient does
+//       not have coefficients of type T
+void divmod(const BasicPoly&, BasicPoly&, BasicPoly&) const;
+
+//--------------------------  /  and  %  ----------------------------------
+// Overloaded division and remainder operators
+// Preconditions:   as for divmod()
+// Postconditions:  the quotient or the remainder of divmod() is returned
+BasicPoly operator/(const BasicPoly&) const;
+BasicPoly operator%(const BasicPoly&) const;
+
+//-------------------------  /=  and  %=  ---------------------------------
+// current object = current object / parameter, or % parameter
+// Preconditions:   as for divmod()
+// Postconditions:  *this is assigned the quotient or the remainder
+BasicPoly& operator/=(const BasicPoly&);
+BasicPoly& operator%=(const BasicPoly&);
+
+//-----------------------------  ==  --------------------------------------
+// Determine if two Polys are equal
+// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
+//       least 1
+// Postconditions:  
+//       -- true is returned if all terms in this object and rhs are equal
+//       -- false is returned if otherwise, in O(1) when the degrees, or
+//          the cached term counts or hashes, differ; true in O(1) for
+//          copies sharing one array
+bool operator==(const BasicPoly&) const;
+
+//-----------------------------  !=  --------------------------------------
+// Determine if two Polys are not equal
+// Preconditions:   coeffPtr and rhs.coeffPtr point to arrays with size at
+//       least 1
+// Postconditions:  
+//       -- false is returned if all terms in this object and rhs are equal
+//       -- true is returned if otherwise
+bool operator!=(const BasicPoly&) const;
+
+//--------------------------- expIsValid ----------------------------------
+// Determines if the int passed is a valid exponent value in Poly
+// Preconditions:  none
+// Postconditions:
+//       -- returns true if exponent >= 0
+//       -- returns false if otherwise, and throws a cerr message
+bool expIsValid(int) const;
+
+private:
+
+//a DENSE array of at least this size switches to SPARSE under AUTO ...
+static const int SPARSE_MIN_SIZE = 64;
+//... when fewer than 1 in SPARSE_RATIO of its positions hold a term
+static const int SPARSE_RATIO = 8;
+//a SPARSE Poly switches back to DENSE when at least 1 in DENSE_RATIO
+//positions hold a term
+static const int DENSE_RATIO = 2;
+
+//DENSE arrays of up to this many terms are stored in inlineCoeffs
+static const int INLINE_SIZE = POLY_INLINE_SIZE;
+
+//an array from allocator starts this far into its block, after the count
+//of Polys sharing it; ALIGNMENT keeps the array itself aligned
+static const size_t COUNT_BYTES = PolyAllocator::ALIGNMENT;
+   
+//---------------------------- denseCoeffs --------------------------------
+// The coefficients of Poly up to its highest nonzero one, as an array
+// Preconditions:   none
+// Postconditions:  returns coeffPtr when DENSE, else the vector filled
+//       with the SPARSE terms; the int is set to the number of
+//       coefficients, 0 for the zero Poly
+const T* denseCoeffs(vector<T>&, int&) const;
+
+//----------------------------- lowCoeffs ---------------------------------
+// The coefficients of Poly below x^limit, up to its highest nonzero one
+// there, as an array
+// Preconditions:   none
+// Postconditions:  as for denseCoeffs(), but only terms with exponents
+//       below the limit (the second parameter) are read
+const T* lowCoeffs(vector<T>&, int, int&) const;
+
+//---------------------------- sparseTerms --------------------------------
+// The nonzero terms of Poly, sorted by increasing exponent, as an array
+// Preconditions:   none
+// Postconditions:  returns the SPARSE terms, or the vector filled from
+//       the DENSE array; the int is set to the number of terms
+const Term* sparseTerms(vector<Term>&, int&) const;
+
+//----------------------------- fromDense ---------------------------------
+// Build a Poly from an array of n coefficients
+// Preconditions:   none
+// Postconditions:  returns the Poly, in the layout picked by
+//       chooseRepresentation(), without leading zeros; n == 0 or all
+//       zero coefficients give the zero Poly
+static BasicPoly fromDense(const T*, int);
+
+//---------------------------- storedSize ---------------------------------
+// Number of coefficients or terms Poly stores, as counted by PolyStats
+// Preconditions:   none
+// Postconditions:  returns highestExp + 1 for DENSE, the term count for
+//       SPARSE
+int storedSize() const;
+
+//--------------------------- resizeArray ---------------------------------
+// Copies coeffPtr's array into a new array of newSize
+// **NOTE** -- newSize should be greater than highestExp+1, otherwise, loss
+//             of data
+// Preconditions:
+//       -- coeffPtr points to an array
+// Postconditions:
+//       -- coeffPtr points to a new array of size newSize, with all the
+//          old array elements copied over
+//       -- the old array is deallocated
+void resizeArray(int);
+
+//---------------------------- allocArray ---------------------------------
+// Get an uninitialized array of a number of coefficients
+// Preconditions:   size >= 1
+// Postconditions:  returns inlineCoeffs if it is large enough and not in
+//       use, and raises size to INLINE_SIZE; otherwise returns an array
+//       from allocator, with a count of 1.  coeffPtr and capacity are
+//       unchanged
+T* allocArray(int&);
+
+//---------------------------- freeArray ----------------------------------
+// Let go of coeffPtr's array
+// Preconditions:   coeffPtr is NULL, inlineCoeffs, or came from allocator
+//       with capacity coefficients
+// Postconditions:  coeffPtr is NULL and capacity is 0; an array from
+//       allocator is given back once no other Poly shares it
+void freeArray();
+
+//----------------------------- refCount ----------------------------------
+// Number of Polys sharing coeffPtr's array
+// Preconditions:   coeffPtr came from allocator
+// Postconditions:  returns the count stored in front of the array
+atomic<int>& refCount() const;
+
+//----------------------------- isShared ----------------------------------
+// Determine if another Poly holds coeffPtr's array too
+// Preconditions:   none
+// Postconditions:  returns true if the array came from allocator and its
+//       count is above 1
+bool isShared() const;
+
+//---------------------------- shareArray ---------------------------------
+// Make this Poly use the DENSE array of another Poly
+// Preconditions:   none
+// Postconditions:  returns false, doing nothing, unless source is DENSE
+//       with an array from this Poly's allocator; otherwise this Poly's
+//       old array is let go of, coeffPtr and capacity are source's, and
+//       the count is raised.  Terms and highestExp are left to the caller
+bool shareArray(const BasicPoly&);
+
+//------------------------------ unshare ----------------------------------
+// Make coeffPtr's array this Poly's own before writing to it
+// Preconditions:   the DENSE layout is in use
+// Postconditions:  a shared array is copied into a new array of the same
+//       capacity, and the shared one let go of; otherwise nothing is done
+void unshare();
+
+//--------------------------- evaluateTree --------------------------------
+// Evaluate Poly at many points of type T with a subproduct tree, when
+// that beats Horner's rule (see polytree.h)
+// Preconditions:   xs and out hold n points each
+// Postconditions:  returns true with out[i] = evaluate(xs[i]) for i < n,
+//       or false, with out unchanged, if the tree is not used.  For points
+//       of another type X it is never used
+bool evaluateTree(const T*, T*, size_t) const;
+template <class X> bool evaluateTree(const X*, X*, size_t) const;
+
+//---------------------------- scaleBy ------------------------------------
+// Multiply every coefficient by a T, in place
+// Preconditions:   none
+// Postconditions:  each coefficient is multiplied by the parameter;
+//       highestExp is unchanged
+void scaleBy(T);
+
+//--------------------------- assignExpr ----------------------------------
+// Evaluate a Poly expression into this Poly
+// Preconditions:   none
+// Postconditions:  this Poly holds the value of the expression.  DENSE
+//       operands are fused into one pass; if any operand is SPARSE, the
+//       expression is evaluated one operator at a time.  The bool
+//       allows reusing the array of a temporary Poly in the expression
+template <class E> void assignExpr(const E&, bool);
+
+//----------------------------- fillExpr ----------------------------------
+// Write coefficients 0..degree of a DENSE Poly expression into an array
+// Preconditions:   the array has room for degree + 1 coefficients
+// Postconditions:  the coefficients are written, in parallel pieces by
+//       forRange(), and the nonzero ones are added to the count
+template <class E> static void fillExpr(T*, const E&, atomic<int>&);
+
+//---------------------------- growDense ----------------------------------
+// Raise highestExp of a DENSE Poly, growing the array geometrically
+// Preconditions:   the DENSE layout is in use, newHighestExp > highestExp
+// Postconditions:  highestExp = newHighestExp; the new terms are zero.
+//       If the array is too small its size is at least doubled, so a
+//       run of growing setCoeff() calls reallocates O(log n) times
+void growDense(int);
+
+//--------------------------- resetDense ----------------------------------
+// Discard all terms and make this a DENSE Poly of all zero coefficients
+// Preconditions:   newHighestExp >= 0
+// Postconditions:  coeffPtr points to a zeroed array of size at least
+//       newHighestExp + 1, and highestExp = newHighestExp.  The old array
+//       is reused if it is large enough
+void resetDense(int);
+
+//--------------------------- mergeTerms ----------------------------------
+// Add or subtract rhs by merging the nonzero terms of both Polys in
+// exponent order
+// Preconditions:   sign is 1 or -1
+// Postconditions:  this Poly holds this + sign * rhs
+void mergeTerms(const BasicPoly&, int);
+
+//----------------------------- toDense -----------------------------------
+// Convert the SPARSE terms into the DENSE array layout
+// Preconditions:   none
+// Postconditions:  coeffPtr holds every term, terms is emptied
+void toDense();
+
+//----------------------------- toSparse ----------------------------------
+// Convert the DENSE array into the SPARSE term layout
+// Preconditions:   none
+// Postconditions:  terms holds every nonzero term, coeffPtr is NULL
+void toSparse();
+
+//----------------------- chooseRepresentation ----------------------------
+// Put the terms into the layout asked for by storage
+// Preconditions:   none
+// Postconditions:  under AUTO, the layout is picked with wantsSparse()
+void chooseRepresentation();
+
+//--------------------------- wantsSparse ---------------------------------
+// Determine if AUTO should use the SPARSE layout
+// Preconditions:   none
+// Postconditions:  params are the number of array positions, the number
+//       of nonzero terms, and whether the layout is currently SPARSE;
+//       returns true if SPARSE should be used
+static bool wantsSparse(int, int, bool);
+
+//---------------------------- findTerm -----------------------------------
+// Binary search the SPARSE terms for an exponent
+// Preconditions:   the SPARSE layout is in use
+// Postconditions:  returns the index of the first term with an exponent
+//       not less than the parameter
+int findTerm(int) const;
+
+//---------------------------- getTerms -----------------------------------
+// Copy the nonzero terms of Poly into a vector, in increasing exponent
+// order, whichever layout is in use
+// Preconditions:   none
+// Postconditions:  the vector holds exactly the nonzero terms
+void getTerms(vector<Term>&) const;
+
+//---------------------------- putTerms -----------------------------------
+// Set or add terms in any exponent order, sizing the Poly once
+// Preconditions:   every exponent in the vector is >= 0
+// Postconditions:  each term is set as by setCoeff(), the later of two
+//       with one exponent winning, or added as by addCoeff() if the bool
+//       is true.  The vector may be reordered
+void putTerms(vector<Term>&, bool);
+
+//---------------------------- setTerms -----------------------------------
+// Overwrite Poly with nonzero terms sorted by increasing exponent
+// Preconditions:   every exponent in the vector is <= newHighestExp
+// Postconditions:  this Poly holds exactly the terms, with highestExp ==
+//       newHighestExp, in the layout picked by chooseRepresentation()
+void setTerms(vector<Term>&, int);
+
+//---------------------------- multiplyBy ---------------------------------
+// multiply() past the product cache
+// Preconditions:   cache is NULL or the current PolyCache
+// Postconditions:  returns the product as multiply() computes it; DENSE
+//       products are tried with mulCached() first if cache is not NULL
+BasicPoly multiplyBy(const BasicPoly&, MulAlgorithm, Execution,
+                     PolyCache<T>*) const;
+
+//----------------------------- mulCached ---------------------------------
+// NTT product with the transforms of an operand kept in a PolyCache
+// Preconditions:   both Polys are DENSE; out has room for their product
+// Postconditions:  returns false, doing nothing, unless MUL_AUTO would
+//       pick a serial NTT product.  Else out holds the product: an
+//       operand whose spectrum the cache holds is not transformed, and
+//       one the cache wants a spectrum of has it made and stored first
+bool mulCached(const BasicPoly&, T*, Execution, PolyCache<T>&) const;
+
+//---------------------------- normalize ----------------------------------
+// Lower highestExp to the true degree of Poly
+// Preconditions:   none
+// Postconditions:  highestExp is the highest exponent with a nonzero
+//       coefficient, 0 for the zero Poly; the DENSE array keeps its size
+void normalize();
+
+//----------------------------- changed -----------------------------------
+// Forget the cached term count and hash
+// Preconditions:   none
+// Postconditions:  termCount() and hash() count the terms again
+void changed();
+
+//---------------------------- copyCache ----------------------------------
+// Take the cached term count and hash of a Poly with the same terms
+// Preconditions:   the parameter holds the terms this Poly now holds
+// Postconditions:  the caches are those of the parameter
+void copyCache(const BasicPoly&);
+
+//---------------------------- recordTerm ---------------------------------
+// Update the cached term count and hash for one coefficient changing
+// Preconditions:   called with the exponent and the old and new
+//       coefficients, before or after the change
+// Postconditions:  a known count or hash is adjusted in O(1)
+void recordTerm(int, T, T);
+
+//----------------------------- termHash ----------------------------------
+// Hash of one term for hash()
+// Preconditions:   none
+// Postconditions:  returns a hash of the exponent and of the bytes
+//       polyio.h writes for the coefficient, so equal values hash alike
+static uint64_t termHash(int, T);
+
+//pointer to an array storing the coefficients of the Poly; either
+//inlineCoeffs or an array from allocator, which other Polys may share
+//and which is preceded by their count (see refCount())
+T *coeffPtr;
+   
+//highest exponent of the Poly; array position is the exponent value,
+//so the array holds at least highestExp + 1 terms
+int highestExp; 
+
+//number of coefficients in the array, >= highestExp + 1; positions above
+//highestExp are always zero.  0 when the SPARSE layout is in use
+int capacity;
+
+//nonzero terms sorted by increasing exponent, used by the SPARSE layout
+//in place of coeffPtr (which is then NULL)
+vector<Term> terms;
+
+//true while the SPARSE layout holds the terms
+bool sparse;
+
+//layout requested with setRepresentation()
+Representation storage;
+
+//where coeffPtr's array comes from and is given back to
+PolyAllocator* allocator;
+
+//termCount() once counted, or -1; hash() once computed, if hashKnown.
+//Filled in by const functions, so they are mutable, and atomic so
+//threads sharing a const Poly may fill them at once
+mutable atomic<int> knownTerms{-1};
+mutable atomic<uint64_t> knownHash{0};
+mutable atomic<bool> hashKnown{false};
+
+//storage for a DENSE array of up to INLINE_SIZE terms, so low degree
+//Polys need no allocation
+T inlineCoeffs[(INLINE_SIZE > 0) ? INLINE_SIZE : 1];
+
+};
+
+//----------------------------- Poly types --------------------------------
+// Poly keeps int coefficients; the other coefficient types instantiated
+// in poly.cpp are
+typedef BasicPoly<int> Poly;
+typedef BasicPoly<int64_t> Poly64;
+typedef BasicPoly<__int128> Poly128;
+typedef BasicPoly<CheckedInt> CheckedPoly;
+template <uint32_t P> using ModPoly = BasicPoly<ModInt<P> >;
+
+//------------------------------ std::hash --------------------------------
+// Hash for Polys as keys of unordered containers, by hash()
+namespace std {
+template <class T>
+struct hash<BasicPoly<T> > {
+   size_t operator()(const BasicPoly<T>& p) const {
+      return (size_t)p.hash();
+   }
+};
+}
+
+#include "polyexpr.h"
+#include "polyeval.h"
+#include "polyio.h"
+
+#endif
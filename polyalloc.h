@@ -0,0 +1,356 @@
+//-----------------------------------------------------------------------//
+// POLYALLOC.H                                                           //
+//                                                                       //
+// Allocators for the coefficient arrays of Poly                         //
+//-----------------------------------------------------------------------//
+// Every DENSE Poly larger than its inline storage gets its array from   //
+// a PolyAllocator and gives it back to the same one.  Three are         //
+// provided:                                                             //
+//                                                                       //
+//   -- HeapAllocator:  new[] and delete[]; the default                  //
+//   -- ArenaAllocator: bump allocation out of large chunks; arrays are  //
+//                      never given back one at a time, the whole arena  //
+//                      is released at the end of a batch of work and    //
+//                      its chunks are reused by the next batch          //
+//   -- PoolAllocator:  arrays are rounded up to a power of 2 size class //
+//                      and given back to a free list for that class,    //
+//                      so arrays that are freed and made again over and //
+//                      over are recycled                                //
+//                                                                       //
+// A new Poly uses the default allocator of its thread, which is         //
+// HeapAllocator unless changed with PolyAllocator::setDefault() or a    //
+// PolyAllocatorScope:                                                   //
+//                                                                       //
+//     ArenaAllocator arena;                                             //
+//     {                                                                 //
+//        PolyAllocatorScope scope(&arena);                              //
+//        ... create and combine short-lived Polys ...                   //
+//     }                                                                 //
+//     arena.release();        // every array of the batch at once       //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- the allocator travels with the array: a moved Poly keeps the     //
+//      allocator of the array it took over, and a copy or assignment    //
+//      allocates from the allocator of the Poly receiving the terms,    //
+//      or shares the array if it came from that allocator; the last     //
+//      Poly sharing an array gives it back                              //
+//   -- every Poly using an allocator must be destroyed before the       //
+//      allocator is, and before an ArenaAllocator is released           //
+//   -- allocators hand out raw bytes aligned for any coefficient type,  //
+//      i.e. to 16 bytes                                                 //
+//   -- allocators are not thread safe; the default is per thread.  The  //
+//      shared HeapAllocator, every thread's default until changed, is   //
+//      the exception: it is new[] underneath and its counters are       //
+//      atomic, so threads may use it at once                            //
+//   -- an array goes back to the allocator it came from, even when the  //
+//      last Poly sharing it is freed on another thread; Polys sharing   //
+//      an array of an Arena or Pool allocator must stay on its thread   //
+//   -- Stats count the arrays asked for and the blocks taken from the   //
+//      system heap; their difference is the heap allocations avoided    //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYALLOC_H
+#define POLYALLOC_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+using namespace std;
+
+class PolyAllocator {
+public:
+//------------------------------- Stats -----------------------------------
+// Counters kept by every allocator
+struct Stats {
+   long long requests;           //arrays handed out
+   long long releases;           //arrays given back
+   long long bytesRequested;     //bytes in the arrays handed out
+   long long heapAllocations;    //blocks taken from the system heap
+
+   //heap allocations saved compared to one new[] per array
+   long long avoided() const { return requests - heapAllocations; }
+};
+
+PolyAllocator() { resetStats(); }
+virtual ~PolyAllocator() {}
+
+//alignment of every array handed out
+static const size_t ALIGNMENT = 16;
+
+//----------------------------- allocate ----------------------------------
+// Get an uninitialized array of bytes
+// Preconditions:   bytes >= 1
+// Postconditions:  returns an array with room for bytes bytes, aligned to
+//       ALIGNMENT
+virtual void* allocate(size_t bytes) = 0;
+
+//---------------------------- deallocate ---------------------------------
+// Give back an array made by allocate() of this allocator
+// Preconditions:   bytes is the size it was allocated with
+// Postconditions:  the array may be reused or freed
+virtual void deallocate(void* array, size_t bytes) = 0;
+
+//------------------------------ getStats ---------------------------------
+// Get the counters since construction or the last resetStats()
+Stats getStats() const {
+   Stats s;
+   s.requests = requests.load(memory_order_relaxed);
+   s.releases = releases.load(memory_order_relaxed);
+   s.bytesRequested = bytesRequested.load(memory_order_relaxed);
+   s.heapAllocations = heapAllocations.load(memory_order_relaxed);
+   return s;
+}
+
+//----------------------------- resetStats --------------------------------
+// Set every counter to 0
+void resetStats() {
+   requests.store(0, memory_order_relaxed);
+   releases.store(0, memory_order_relaxed);
+   bytesRequested.store(0, memory_order_relaxed);
+   heapAllocations.store(0, memory_order_relaxed);
+}
+
+//----------------------------- getDefault --------------------------------
+// Get the allocator new Polys of this thread use
+// Preconditions:   none
+// Postconditions:  returns the allocator set by setDefault(), or the
+//       shared HeapAllocator
+static PolyAllocator* getDefault();
+
+//----------------------------- setDefault --------------------------------
+// Change the allocator new Polys of this thread use
+// Preconditions:   none
+// Postconditions:  returns the previous default; NULL restores the shared
+//       HeapAllocator
+static PolyAllocator* setDefault(PolyAllocator*);
+
+protected:
+//count one array handed out, one given back, and one block taken from
+//the heap
+void countRequest(size_t bytes) {
+   requests.fetch_add(1, memory_order_relaxed);
+   bytesRequested.fetch_add((long long)bytes, memory_order_relaxed);
+}
+void countRelease() { releases.fetch_add(1, memory_order_relaxed); }
+void countHeapAllocation() {
+   heapAllocations.fetch_add(1, memory_order_relaxed);
+}
+
+//the counters of Stats; atomic, with relaxed order, so the shared
+//HeapAllocator can count for every thread at once
+atomic<long long> requests;
+atomic<long long> releases;
+atomic<long long> bytesRequested;
+atomic<long long> heapAllocations;
+
+private:
+static PolyAllocator*& currentDefault() {
+   static thread_local PolyAllocator* current = NULL;
+   return current;
+}
+};
+
+//----------------------------- HeapAllocator -----------------------------
+// Every array is its own new[] and delete[]
+class HeapAllocator : public PolyAllocator {
+public:
+void* allocate(size_t bytes) {
+   countRequest(bytes);
+   countHeapAllocation();
+   return ::operator new(bytes);
+}
+
+void deallocate(void* array, size_t) {
+   countRelease();
+   ::operator delete(array);
+}
+
+//the shared instance used when no other default is set
+static HeapAllocator& shared() {
+   static HeapAllocator instance;
+   return instance;
+}
+};
+
+//----------------------------- ArenaAllocator ----------------------------
+// Bump allocation out of chunks that are only released all together
+class ArenaAllocator : public PolyAllocator {
+public:
+//------------------------------ Constructor ------------------------------
+// Preconditions:   chunkBytes >= 1
+// Postconditions:  chunks of chunkBytes bytes are taken from the heap as
+//       needed; a larger array gets a chunk of its own
+explicit ArenaAllocator(size_t chunkBytes = 65536) {
+   chunkSize = chunkBytes;
+   current = 0;
+   used = 0;
+}
+
+~ArenaAllocator() {
+   for (size_t i = 0; i < chunks.size(); i++)
+      free(chunks[i].memory);
+}
+
+void* allocate(size_t bytes) {
+   countRequest(bytes);
+   size_t rounded = (bytes + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+   while (current < chunks.size() &&
+          used + rounded > chunks[current].size) {
+      current++;
+      used = 0;
+   }
+   if (current == chunks.size())
+      addChunk(max(rounded, chunkSize));
+   char* array = chunks[current].memory + used;
+   used += rounded;
+   return array;
+}
+
+void deallocate(void*, size_t) {
+   countRelease();
+}
+
+//------------------------------ release ----------------------------------
+// Release every array of the arena at once
+// Preconditions:   no Poly still uses an array from this arena
+// Postconditions:  the chunks are kept and handed out again from the start
+void release() {
+   current = 0;
+   used = 0;
+}
+
+//---------------------------- bytesReserved ------------------------------
+// Total size of the chunks taken from the heap
+long long bytesReserved() const {
+   long long total = 0;
+   for (size_t i = 0; i < chunks.size(); i++)
+      total += (long long)chunks[i].size;
+   return total;
+}
+
+private:
+struct Chunk {
+   char* memory;
+   size_t size;
+};
+
+void addChunk(size_t size) {
+   Chunk chunk;
+   chunk.memory = static_cast<char*>(malloc(size));
+   if (chunk.memory == NULL)
+      throw bad_alloc();
+   chunk.size = size;
+   chunks.push_back(chunk);
+   countHeapAllocation();
+}
+
+vector<Chunk> chunks;
+size_t chunkSize;
+size_t current;      //chunk being handed out
+size_t used;         //bytes handed out of the current chunk
+};
+
+//------------------------------ PoolAllocator ----------------------------
+// Arrays rounded up to a power of 2 and recycled through free lists
+class PoolAllocator : public PolyAllocator {
+public:
+//pooled arrays are 2^c bytes for MIN_CLASS <= c <= MAX_CLASS; larger
+//ones use operator new
+static const int MIN_CLASS = 4;
+static const int MAX_CLASS = 22;
+
+PoolAllocator() {
+   for (int c = 0; c <= MAX_CLASS; c++)
+      freeLists[c] = NULL;
+}
+
+~PoolAllocator() {
+   for (int c = 0; c <= MAX_CLASS; c++) {
+      while (freeLists[c] != NULL) {
+         Block* next = freeLists[c]->next;
+         free(freeLists[c]);
+         freeLists[c] = next;
+      }
+   }
+}
+
+void* allocate(size_t bytes) {
+   countRequest(bytes);
+   int c = sizeClass(bytes);
+   if (c > MAX_CLASS) {
+      countHeapAllocation();
+      return ::operator new(bytes);
+   }
+   Block* block = freeLists[c];
+   if (block != NULL) {
+      freeLists[c] = block->next;
+      return block;
+   }
+   countHeapAllocation();
+   void* memory = malloc((size_t)1 << c);
+   if (memory == NULL)
+      throw bad_alloc();
+   return memory;
+}
+
+void deallocate(void* array, size_t bytes) {
+   countRelease();
+   int c = sizeClass(bytes);
+   if (c > MAX_CLASS) {
+      ::operator delete(array);
+      return;
+   }
+   Block* block = static_cast<Block*>(array);
+   block->next = freeLists[c];
+   freeLists[c] = block;
+}
+
+private:
+//a free array holds the link to the next free array of its class
+struct Block {
+   Block* next;
+};
+
+//smallest c >= MIN_CLASS with 2^c >= bytes
+static int sizeClass(size_t bytes) {
+   int c = MIN_CLASS;
+   while (c <= MAX_CLASS && ((size_t)1 << c) < bytes)
+      c++;
+   return c;
+}
+
+Block* freeLists[MAX_CLASS + 1];
+};
+
+//--------------------------- PolyAllocatorScope --------------------------
+// Makes an allocator the default of this thread until the end of a scope
+class PolyAllocatorScope {
+public:
+explicit PolyAllocatorScope(PolyAllocator* allocator) {
+   previous = PolyAllocator::setDefault(allocator);
+}
+~PolyAllocatorScope() {
+   PolyAllocator::setDefault(previous);
+}
+
+private:
+PolyAllocatorScope(const PolyAllocatorScope&);
+PolyAllocatorScope& operator=(const PolyAllocatorScope&);
+
+PolyAllocator* previous;
+};
+
+inline PolyAllocator* PolyAllocator::getDefault() {
+   PolyAllocator* current = currentDefault();
+   return (current != NULL) ? current : &HeapAllocator::shared();
+}
+
+inline PolyAllocator* PolyAllocator::setDefault(PolyAllocator* allocator) {
+   PolyAllocator* previous = getDefault();
+   currentDefault() = allocator;
+   return previous;
+}
+
+#endif
@@ -0,0 +1,358 @@
+//-----------------------------------------------------------------------//
+// POLYCACHE.H                                                           //
+//                                                                       //
+// Memoization of Poly products and of their operands' NTT transforms    //
+//-----------------------------------------------------------------------//
+// A PolyCache<T> made current for a thread, e.g. with a scope           //
+//                                                                       //
+//     PolyCache<int> cache(16 << 20);        // at most 16 MB           //
+//     {                                                                 //
+//        PolyCacheScope<int> scope(&cache);                             //
+//        for (...)                                                      //
+//           out[i] = basis[i % k] * inputs[i];                          //
+//     }                                                                 //
+//                                                                       //
+// is consulted by BasicPoly::multiply() under MUL_AUTO, and so by * and //
+// *=, before any product is computed.  It keeps two kinds of entries    //
+// in one least recently used list:                                      //
+//                                                                       //
+//   -- products: found by a key made from the operands' hash(), in      //
+//      either order, and returned only if both operands compare == to   //
+//      the ones stored with it, so a collision can never give a wrong   //
+//      product.  The product comes back as a copy sharing its array     //
+//   -- spectra: the forward transforms of one operand for one NTT       //
+//      length (see polyntt.h), kept once an operand has been met in     //
+//      SPECTRUM_USES products.  A product by it, with any other         //
+//      operand, then transforms only that other operand: two forward    //
+//      transforms instead of three per prime                            //
+//                                                                       //
+// Every entry counts the bytes of the Polys and transforms it holds;    //
+// when the total goes over getMaxBytes() the least recently used        //
+// entries are evicted.  getStats() counts hits, misses, spectra kept    //
+// and reused, and evictions.                                            //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- products of operands with fewer than MIN_TERMS nonzero terms,    //
+//      which are cheaper to redo than to look up, bypass the cache      //
+//   -- stored operands are copies, which share the caller's arrays      //
+//      (see poly.h): a caller that then writes to an operand copies     //
+//      its array once.  Shared arrays are counted in full               //
+//   -- spectra are used by serial products only; a product split over   //
+//      the thread pool transforms its pieces as before                  //
+//   -- entries hold arrays of the allocators their Polys came from;     //
+//      clear() the cache before releasing an ArenaAllocator it saw      //
+//   -- a cache is not thread safe; the current cache is per thread,     //
+//      and the cache must outlive every scope that makes it current     //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYCACHE_H
+#define POLYCACHE_H
+
+#include <list>
+#include <stdint.h>
+#include <unordered_map>
+#include "poly.h"
+#include "polyntt.h"
+using namespace std;
+
+template <class T>
+class PolyCache {
+public:
+//------------------------------- Stats -----------------------------------
+// Counters kept by a cache, and its size
+struct Stats {
+   long long hits;               //products found
+   long long misses;             //products looked up and not found
+   long long spectrumHits;       //products that reused a spectrum
+   long long spectraKept;        //spectra made and stored
+   long long evictions;          //entries dropped for room
+   size_t bytes;                 //bytes held now
+   int entries;                  //entries held now
+};
+
+//products of operands with fewer nonzero terms than this are not cached
+static const int MIN_TERMS = 64;
+
+//an operand's spectrum is kept from its SPECTRUM_USES-th NTT product on
+static const int SPECTRUM_USES = 2;
+
+//default memory cap
+static const size_t DEFAULT_BYTES = (size_t)64 << 20;
+
+//------------------------------ Constructor ------------------------------
+// Preconditions:   none
+// Postconditions:  an empty cache holding at most maxBytes
+explicit PolyCache(size_t maxBytes = DEFAULT_BYTES) : maxBytes(maxBytes) {
+   bytes = 0;
+   resetStats();
+}
+
+//----------------------------- Destructor --------------------------------
+// Preconditions:   the cache is not current in any thread
+// Postconditions:  every entry is freed
+~PolyCache() {}
+
+//------------------------------ getStats ---------------------------------
+// Get the counters since construction or the last resetStats()
+Stats getStats() const {
+   Stats s = stats;
+   s.bytes = bytes;
+   s.entries = (int)entries.size();
+   return s;
+}
+
+//----------------------------- resetStats --------------------------------
+// Set every counter to 0; the entries stay
+void resetStats() {
+   stats.hits = 0;
+   stats.misses = 0;
+   stats.spectrumHits = 0;
+   stats.spectraKept = 0;
+   stats.evictions = 0;
+}
+
+//----------------------------- getMaxBytes -------------------------------
+size_t getMaxBytes() const { return maxBytes; }
+
+//----------------------------- setMaxBytes -------------------------------
+// Change the memory cap
+// Preconditions:   none
+// Postconditions:  least recently used entries are evicted until the
+//       cache holds at most cap bytes
+void setMaxBytes(size_t cap) {
+   maxBytes = cap;
+   evict(0);
+}
+
+//-------------------------------- clear ----------------------------------
+// Drop every entry and forget how often operands were met
+void clear() {
+   entries.clear();
+   index.clear();
+   uses.clear();
+   bytes = 0;
+}
+
+//------------------------------ getCurrent -------------------------------
+// Get the cache multiply() of this thread consults, or NULL
+static PolyCache* getCurrent() { return currentCache(); }
+
+//------------------------------ setCurrent -------------------------------
+// Change the cache multiply() of this thread consults
+// Preconditions:   none
+// Postconditions:  returns the previous one; NULL turns caching off
+static PolyCache* setCurrent(PolyCache* cache) {
+   PolyCache* previous = currentCache();
+   currentCache() = cache;
+   return previous;
+}
+
+//------------------------------- accepts ---------------------------------
+// Determine if a product of a and b is worth caching
+bool accepts(const BasicPoly<T>& a, const BasicPoly<T>& b) const {
+   return min(a.termCount(), b.termCount()) >= MIN_TERMS;
+}
+
+//----------------------------- findProduct -------------------------------
+// Look up a * b
+// Preconditions:   none
+// Postconditions:  returns the stored product of operands == to a and b,
+//       in either order, made most recently used; NULL if there is none
+const BasicPoly<T>* findProduct(const BasicPoly<T>& a,
+                                const BasicPoly<T>& b) {
+   uint64_t key = productKey(a.hash(), b.hash());
+   typedef typename Index::iterator It;
+   pair<It, It> range = index.equal_range(key);
+   for (It it = range.first; it != range.second; ++it) {
+      Entry& e = *it->second;
+      if (!e.spectrum.transforms.empty())
+         continue;
+      if ((e.a == a && e.b == b) || (e.a == b && e.b == a)) {
+         entries.splice(entries.begin(), entries, it->second);
+         stats.hits++;
+         return &e.product;
+      }
+   }
+   stats.misses++;
+   return NULL;
+}
+
+//----------------------------- addProduct --------------------------------
+// Store a * b
+// Preconditions:   findProduct(a, b) just returned NULL
+// Postconditions:  the product is stored, most recently used, unless it
+//       alone is over the cap; older entries are evicted for room
+void addProduct(const BasicPoly<T>& a, const BasicPoly<T>& b,
+                const BasicPoly<T>& product) {
+   size_t size = sizeof(Entry) + polyBytes(a) + polyBytes(b) +
+                 polyBytes(product);
+   if (size > maxBytes)
+      return;
+   evict(size);
+   entries.push_front(Entry(productKey(a.hash(), b.hash()), a, b, size));
+   entries.front().product = product;
+   insert();
+}
+
+//---------------------------- findSpectrum -------------------------------
+// Look up the spectrum of p for transform length n
+// Preconditions:   none
+// Postconditions:  returns the stored spectrum of a Poly == to p, made
+//       most recently used; NULL if there is none, in which case p is
+//       counted as met once more for wantsSpectrum()
+const polyntt::Spectrum* findSpectrum(const BasicPoly<T>& p, int n) {
+   uint64_t key = spectrumKey(p.hash(), n);
+   typedef typename Index::iterator It;
+   pair<It, It> range = index.equal_range(key);
+   for (It it = range.first; it != range.second; ++it) {
+      Entry& e = *it->second;
+      if (e.spectrum.n == n && e.a == p) {
+         entries.splice(entries.begin(), entries, it->second);
+         stats.spectrumHits++;
+         return &e.spectrum;
+      }
+   }
+   if (uses.size() >= USES_LIMIT)
+      uses.clear();
+   uses[p.hash()]++;
+   return NULL;
+}
+
+//---------------------------- wantsSpectrum ------------------------------
+// Determine if p has been met often enough to keep its spectrum
+bool wantsSpectrum(const BasicPoly<T>& p) const {
+   typename unordered_map<uint64_t, int>::const_iterator it =
+         uses.find(p.hash());
+   return it != uses.end() && it->second >= SPECTRUM_USES;
+}
+
+//----------------------------- addSpectrum -------------------------------
+// Store the spectrum of p
+// Preconditions:   s holds p's transforms for length s.n, and
+//       findSpectrum(p, s.n) just returned NULL
+// Postconditions:  returns the stored spectrum, taken from s, which is
+//       left empty; NULL, with s untouched, if it alone is over the cap
+const polyntt::Spectrum* addSpectrum(const BasicPoly<T>& p,
+                                     polyntt::Spectrum& s) {
+   size_t size = sizeof(Entry) + polyBytes(p) + s.bytes();
+   if (size > maxBytes)
+      return NULL;
+   evict(size);
+   entries.push_front(Entry(spectrumKey(p.hash(), s.n), p, BasicPoly<T>(),
+                            size));
+   entries.front().spectrum.n = s.n;
+   entries.front().spectrum.length = s.length;
+   entries.front().spectrum.transforms.swap(s.transforms);
+   insert();
+   uses.erase(p.hash());
+   stats.spectraKept++;
+   return &entries.front().spectrum;
+}
+
+private:
+PolyCache(const PolyCache&);
+PolyCache& operator=(const PolyCache&);
+
+//at most this many operand hashes are counted for wantsSpectrum(); the
+//counts start over past it
+static const size_t USES_LIMIT = 4096;
+
+//------------------------------- Entry -----------------------------------
+// A product of a and b, or the spectrum of a (spectrum.transforms not
+// empty), with the bytes it is counted for
+struct Entry {
+   uint64_t key;
+   BasicPoly<T> a, b, product;
+   polyntt::Spectrum spectrum;
+   size_t size;
+
+   Entry(uint64_t key, const BasicPoly<T>& a, const BasicPoly<T>& b,
+         size_t size) : key(key), a(a), b(b), size(size) {}
+};
+
+typedef list<Entry> Entries;
+typedef unordered_multimap<uint64_t, typename Entries::iterator> Index;
+
+//------------------------------- mix -------------------------------------
+// SplitMix64 finalizer
+static uint64_t mix(uint64_t x) {
+   x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+   return x ^ (x >> 31);
+}
+
+//keys of a product, the same in either order, and of a spectrum
+static uint64_t productKey(uint64_t ha, uint64_t hb) {
+   return mix(min(ha, hb) ^ mix(max(ha, hb)));
+}
+static uint64_t spectrumKey(uint64_t h, int n) {
+   return mix(h ^ mix((uint64_t)n + 0x9e3779b97f4a7c15ULL));
+}
+
+//bytes of a Poly and of its array
+static size_t polyBytes(const BasicPoly<T>& p) {
+   typedef typename BasicPoly<T>::Term Term;
+   if (p.isSparse())
+      return sizeof(p) + p.termCount() * sizeof(Term);
+   return sizeof(p) + p.getCapacity() * sizeof(T);
+}
+
+//index the entry just put in front
+void insert() {
+   bytes += entries.front().size;
+   index.insert(make_pair(entries.front().key, entries.begin()));
+}
+
+//------------------------------- evict -----------------------------------
+// Drop least recently used entries until size more bytes fit
+void evict(size_t size) {
+   while (!entries.empty() && bytes + size > maxBytes) {
+      typename Entries::iterator last = --entries.end();
+      typedef typename Index::iterator It;
+      pair<It, It> range = index.equal_range(last->key);
+      for (It it = range.first; it != range.second; ++it) {
+         if (it->second == last) {
+            index.erase(it);
+            break;
+         }
+      }
+      bytes -= last->size;
+      entries.erase(last);
+      stats.evictions++;
+   }
+}
+
+//the cache of this thread
+static PolyCache*& currentCache() {
+   static thread_local PolyCache* current = NULL;
+   return current;
+}
+
+size_t maxBytes;
+size_t bytes;                          //sizes of the entries
+Entries entries;                       //most recently used first
+Index index;                           //entries by key
+unordered_map<uint64_t, int> uses;     //products met, by operand hash
+Stats stats;
+};
+
+//---------------------------- PolyCacheScope -----------------------------
+// Makes a cache the current one of this thread until the end of a scope
+template <class T>
+class PolyCacheScope {
+public:
+explicit PolyCacheScope(PolyCache<T>* cache) {
+   previous = PolyCache<T>::setCurrent(cache);
+}
+~PolyCacheScope() {
+   PolyCache<T>::setCurrent(previous);
+}
+
+private:
+PolyCacheScope(const PolyCacheScope&);
+PolyCacheScope& operator=(const PolyCacheScope&);
+
+PolyCache<T>* previous;
+};
+
+#endif
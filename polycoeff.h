@@ -0,0 +1,273 @@
+//-----------------------------------------------------------------------//
+// POLYCOEFF.H                                                           //
+//                                                                       //
+// Coefficient types for BasicPoly, and what each one supports           //
+//-----------------------------------------------------------------------//
+// BasicPoly<T> (see poly.h) stores coefficients of type T.  Poly is     //
+// BasicPoly<int>, whose products wrap around on overflow.  The other    //
+// coefficient types are:                                                //
+//                                                                       //
+//   -- int64_t, __int128: wider integers, wrapping at 64 or 128 bits    //
+//   -- ModInt<P>:   integers modulo an odd prime P < 2^31, stored in    //
+//                   Montgomery form; every operation is branch free     //
+//   -- CheckedInt:  an int that throws overflow_error instead of        //
+//                   wrapping                                            //
+//                                                                       //
+// PolyCoeffTraits<T> tells the multiplication code which kernels are    //
+// exact for T and which word type they run on:                          //
+//                                                                       //
+//     T            Word                Karatsuba  Toom-3  NTT           //
+//     int          unsigned            yes        yes     yes           //
+//     int64_t      uint64_t            yes        yes     no            //
+//     __int128     unsigned __int128   yes        no      no            //
+//     ModInt<P>    ModInt<P>           yes        no      yes           //
+//     CheckedInt   CheckedInt          no         no      no            //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- Word has the same size and layout as T, and T arithmetic done in //
+//      Word gives the same result, so kernels read T arrays as Word     //
+//   -- Toom-3 runs on Wide, a word at least twice as wide as T          //
+//   -- CheckedInt only uses the schoolbook loop, since Karatsuba's      //
+//      intermediate sums can overflow when the product does not; an     //
+//      overflow in any partial sum of the schoolbook loop is reported   //
+//   -- every type is trivially copyable, so arrays are copied as bytes  //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYCOEFF_H
+#define POLYCOEFF_H
+
+#include <iostream>
+#include <stdexcept>
+#include <stdint.h>
+using namespace std;
+
+//----------------------------- ModInt ------------------------------------
+// An integer modulo the odd prime P < 2^31.  The value x is stored as
+// x * 2^32 mod P (Montgomery form), so a product is two integer
+// multiplies and a shift, and each result is brought into [0, P) by an
+// unsigned min() instead of a branch
+template <uint32_t P>
+struct ModInt {
+   static_assert(P % 2 == 1 && P < (1u << 31), "P must be an odd prime < 2^31");
+
+   uint32_t v;       //Montgomery form, in [0, P)
+
+   ModInt() : v(0) {}
+   ModInt(long long x) : v(toMont(residue(x))) {}
+
+   //---------------------------- value ----------------------------------
+   // The integer in [0, P) this ModInt stands for
+   uint32_t value() const { return reduce(v); }
+
+   ModInt& operator+=(ModInt rhs) { v = minus(v + rhs.v); return *this; }
+   ModInt& operator-=(ModInt rhs) { v = plus(v - rhs.v); return *this; }
+   ModInt& operator*=(ModInt rhs) {
+      v = reduce((uint64_t)v * rhs.v);
+      return *this;
+   }
+
+   //---------------------------- inverse --------------------------------
+   // The y with x * y == 1, as x^(P-2) (Fermat); 0 for x == 0
+   ModInt inverse() const {
+      ModInt result(1), base = *this;
+      for (uint32_t e = P - 2; e > 0; e >>= 1) {
+         if (e & 1)
+            result *= base;
+         base *= base;
+      }
+      return result;
+   }
+
+   friend ModInt operator+(ModInt a, ModInt b) { return a += b; }
+   friend ModInt operator-(ModInt a, ModInt b) { return a -= b; }
+   friend ModInt operator*(ModInt a, ModInt b) { return a *= b; }
+   friend ModInt operator-(ModInt a) { return ModInt() - a; }
+
+   friend bool operator==(ModInt a, ModInt b) { return a.v == b.v; }
+   friend bool operator!=(ModInt a, ModInt b) { return a.v != b.v; }
+   //ordered by value, so the output operator prints every nonzero term
+   //with a + sign
+   friend bool operator<(ModInt a, ModInt b) { return a.value() < b.value(); }
+   friend bool operator>(ModInt a, ModInt b) { return b < a; }
+
+   friend ostream& operator<<(ostream& out, ModInt a) {
+      return out << a.value();
+   }
+   friend istream& operator>>(istream& in, ModInt& a) {
+      long long x = 0;
+      in >> x;
+      a = ModInt(x);
+      return in;
+   }
+
+private:
+   //-P^-1 mod 2^32, by Newton iteration, and 2^64 mod P
+   static constexpr uint32_t inverse(uint32_t inv, int steps) {
+      return (steps == 0) ? inv : inverse(inv * (2u - P * inv), steps - 1);
+   }
+   static const uint32_t NEG_INV = 0u - inverse(P, 4);
+   static const uint32_t R2 = (uint32_t)((0xFFFFFFFFFFFFFFFFull % P + 1) % P);
+
+   //x - P if x >= P, else x, for x < 2P
+   static uint32_t minus(uint32_t x) {
+      uint32_t y = x - P;
+      return (y < x) ? y : x;
+   }
+   //x + P if x wrapped below 0, else x, for -P <= x < P
+   static uint32_t plus(uint32_t x) {
+      uint32_t y = x + P;
+      return (y < x) ? y : x;
+   }
+   static uint32_t reduce(uint64_t t) {
+      uint32_t m = (uint32_t)t * NEG_INV;
+      return minus((uint32_t)((t + (uint64_t)m * P) >> 32));
+   }
+   static uint32_t toMont(uint32_t x) { return reduce((uint64_t)x * R2); }
+   static uint32_t residue(long long x) {
+      long long r = x % (long long)P;
+      return (uint32_t)((r < 0) ? r + P : r);
+   }
+};
+
+//---------------------------- CheckedInt ---------------------------------
+// An int whose +, - and * throw overflow_error instead of wrapping
+struct CheckedInt {
+   int v;
+
+   CheckedInt() : v(0) {}
+   CheckedInt(int x) : v(x) {}
+
+   //---------------------------- value ----------------------------------
+   int value() const { return v; }
+
+   CheckedInt& operator+=(CheckedInt rhs) {
+      if (__builtin_add_overflow(v, rhs.v, &v))
+         overflow("+");
+      return *this;
+   }
+   CheckedInt& operator-=(CheckedInt rhs) {
+      if (__builtin_sub_overflow(v, rhs.v, &v))
+         overflow("-");
+      return *this;
+   }
+   CheckedInt& operator*=(CheckedInt rhs) {
+      if (__builtin_mul_overflow(v, rhs.v, &v))
+         overflow("*");
+      return *this;
+   }
+
+   friend CheckedInt operator+(CheckedInt a, CheckedInt b) { return a += b; }
+   friend CheckedInt operator-(CheckedInt a, CheckedInt b) { return a -= b; }
+   friend CheckedInt operator*(CheckedInt a, CheckedInt b) { return a *= b; }
+   friend CheckedInt operator-(CheckedInt a) { return CheckedInt() - a; }
+
+   friend bool operator==(CheckedInt a, CheckedInt b) { return a.v == b.v; }
+   friend bool operator!=(CheckedInt a, CheckedInt b) { return a.v != b.v; }
+   friend bool operator<(CheckedInt a, CheckedInt b) { return a.v < b.v; }
+   friend bool operator>(CheckedInt a, CheckedInt b) { return a.v > b.v; }
+
+   friend ostream& operator<<(ostream& out, CheckedInt a) {
+      return out << a.v;
+   }
+   friend istream& operator>>(istream& in, CheckedInt& a) {
+      return in >> a.v;
+   }
+
+private:
+   static void overflow(const char* op) {
+      throw overflow_error(string("CheckedInt overflow in ") + op);
+   }
+};
+
+//------------------------------  <<  -------------------------------------
+// Output operator for __int128, which the standard streams lack
+inline ostream& operator<<(ostream& out, __int128 x) {
+   unsigned __int128 u = (x < 0) ? -(unsigned __int128)x : x;
+   char digits[48];
+   int pos = sizeof(digits);
+   digits[--pos] = '\0';
+   do {
+      digits[--pos] = (char)('0' + (int)(u % 10));
+      u /= 10;
+   } while (u != 0);
+   if (x < 0)
+      digits[--pos] = '-';
+   return out << (digits + pos);
+}
+
+//------------------------------  >>  -------------------------------------
+// Input operator for __int128: an optional sign, then decimal digits
+inline istream& operator>>(istream& in, __int128& x) {
+   char c = 0;
+   if (!(in >> c))
+      return in;
+   bool negative = (c == '-');
+   if (c == '-' || c == '+')
+      in.get(c);
+   if (c < '0' || c > '9') {
+      in.setstate(ios::failbit);
+      return in;
+   }
+   unsigned __int128 u = 0;
+   while (c >= '0' && c <= '9') {
+      u = u * 10 + (unsigned)(c - '0');
+      if (!in.get(c))
+         break;
+   }
+   if (in)
+      in.unget();
+   else
+      in.clear(in.rdstate() & ~ios::failbit);
+   x = negative ? -(__int128)u : (__int128)u;
+   return in;
+}
+
+//------------------------- PolyCoeffTraits -------------------------------
+// The multiplication kernels that are exact for T (see table at top);
+// the default is the schoolbook loop on T itself
+template <class T>
+struct PolyCoeffTraits {
+   typedef T Word;
+   typedef T Wide;
+   static const bool KARATSUBA = false;
+   static const bool TOOM3 = false;
+   static const bool NTT = false;
+};
+
+template <>
+struct PolyCoeffTraits<int> {
+   typedef unsigned Word;
+   typedef unsigned long long Wide;
+   static const bool KARATSUBA = true;
+   static const bool TOOM3 = true;
+   static const bool NTT = true;
+};
+
+template <>
+struct PolyCoeffTraits<int64_t> {
+   typedef uint64_t Word;
+   typedef unsigned __int128 Wide;
+   static const bool KARATSUBA = true;
+   static const bool TOOM3 = true;
+   static const bool NTT = false;
+};
+
+template <>
+struct PolyCoeffTraits<__int128> {
+   typedef unsigned __int128 Word;
+   typedef unsigned __int128 Wide;
+   static const bool KARATSUBA = true;
+   static const bool TOOM3 = false;
+   static const bool NTT = false;
+};
+
+template <uint32_t P>
+struct PolyCoeffTraits<ModInt<P> > {
+   typedef ModInt<P> Word;
+   typedef ModInt<P> Wide;
+   static const bool KARATSUBA = true;
+   static const bool TOOM3 = false;
+   static const bool NTT = true;
+};
+
+#endif
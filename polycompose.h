@@ -0,0 +1,209 @@
+//-----------------------------------------------------------------------//
+// POLYCOMPOSE.H                                                         //
+//                                                                       //
+// Power, Taylor shift and composition kernels used by Poly              //
+//-----------------------------------------------------------------------//
+// For a(x) with n coefficients:                                         //
+//                                                                       //
+//   -- power:    a^k by repeated squaring, optionally modulo x^n with   //
+//                polyseries::mullow(), in O(M(n) log k) time for M(n)   //
+//                the time of a product                                  //
+//   -- shift:    a(x + c).  Over a field, with u[i] = i! a[i] and       //
+//                v[j] = c^j / j!,                                       //
+//                                                                       //
+//                    a(x + c)[k] = (1 / k!) sum of u[i] v[i - k]        //
+//                                                                       //
+//                is one product of u reversed by v.  Over any ring,     //
+//                a = lo + x^h hi for h a power of 2 gives               //
+//                a(x + c) = lo(x + c) + (x + c)^h hi(x + c), with the   //
+//                powers (x + c)^h found once by squaring.  Both take    //
+//                O(M(n) log n) time at most, against O(n^2) for         //
+//                Horner's rule                                          //
+//   -- compose:  a(b(x)) mod x^n by Brent and Kung's baby steps and     //
+//                giant steps: with m = ceil(sqrt(na)), the powers b^i   //
+//                for i <= m are the baby steps, a is cut into blocks    //
+//                a_j of m coefficients, and                             //
+//                                                                       //
+//                    a(b) = sum of a_j(b) (b^m)^j                       //
+//                                                                       //
+//                is evaluated by Horner's rule in G = b^m, each a_j(b)  //
+//                being a linear combination of the baby steps.  That    //
+//                is about 2 sqrt(na) products and na n multiply-adds,   //
+//                against na products for Horner's rule in b             //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- W is a ring word as in polymul.h; shiftField() also needs        //
+//      inverse() (ModInt) and fewer than p coefficients                 //
+//   -- Mul multiplies two W arrays like polymul::multiply()             //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYCOMPOSE_H
+#define POLYCOMPOSE_H
+
+#include <algorithm>
+#include <vector>
+#include "polyseries.h"
+using namespace std;
+
+namespace polycompose {
+
+//shift() of at most this many coefficients uses Horner's rule
+const int SHIFT_SCHOOLBOOK = 64;
+
+//-------------------------------- power ----------------------------------
+// a^k modulo x^n
+// Preconditions:   na >= 1, k >= 0, n >= 1; out has room for n
+// Postconditions:  out[0..n) holds a^k mod x^n
+template <class W, class Mul>
+void power(const W* a, int na, long long k, int n, W* out, Mul mul) {
+   vector<W> base(a, a + min(na, n)), next(n), product;
+   fill(out, out + n, W(0));
+   out[0] = W(1);
+   int used = 1;                    //terms of out that may be nonzero
+   while (k > 0) {
+      if (k & 1) {
+         polyseries::mullow(out, used, &base[0], (int)base.size(), n,
+                            &next[0], product, mul);
+         copy(next.begin(), next.end(), out);
+         used = min(n, used + (int)base.size() - 1);
+      }
+      k >>= 1;
+      if (k > 0) {
+         int len = min(n, 2 * (int)base.size() - 1);
+         polyseries::mullow(&base[0], (int)base.size(), &base[0],
+                            (int)base.size(), len, &next[0], product, mul);
+         base.assign(next.begin(), next.begin() + len);
+      }
+   }
+}
+
+//---------------------------- shiftHorner --------------------------------
+// a(x + c) in place by Horner's rule: each pass is a synthetic division
+// by x - (-c), leaving one more coefficient of the result
+template <class W>
+void shiftHorner(W* a, int d, W c) {
+   for (int i = 0; i < d - 1; i++)
+      for (int j = d - 2; j >= i; j--)
+         a[j] += c * a[j + 1];
+}
+
+//---------------------------- shiftSplit ---------------------------------
+// a(x + c) in place for d coefficients; powers[k] = (x + c)^(2^k)
+template <class W, class Mul>
+void shiftSplit(W* a, int d, W c, const vector<vector<W> >& powers,
+                vector<W>& product, Mul mul) {
+   if (d <= SHIFT_SCHOOLBOOK) {
+      shiftHorner(a, d, c);
+      return;
+   }
+   int k = 0;
+   while ((2 << k) < d)
+      k++;
+   int h = 1 << k;                  //largest power of 2 below d
+   shiftSplit(a, h, c, powers, product, mul);
+   shiftSplit(a + h, d - h, c, powers, product, mul);
+   const vector<W>& p = powers[k];
+   vector<W> high(a + h, a + d);
+   product.resize(d);
+   mul(&p[0], h + 1, &high[0], d - h, &product[0]);
+   for (int i = 0; i < h; i++)
+      a[i] += product[i];
+   copy(product.begin() + h, product.end(), a + h);
+}
+
+//-------------------------------- shift ----------------------------------
+// a(x + c) over any ring
+// Preconditions:   d >= 1; out has room for d coefficients
+// Postconditions:  out holds the coefficients of a(x + c), by splitting
+//       at powers of 2 down to SHIFT_SCHOOLBOOK
+template <class W, class Mul>
+void shift(const W* a, int d, W c, W* out, Mul mul) {
+   copy(a, a + d, out);
+   vector<vector<W> > powers(1);
+   powers[0].push_back(c);
+   powers[0].push_back(W(1));
+   while ((2 << (powers.size() - 1)) < d) {
+      const vector<W>& last = powers.back();
+      vector<W> square(2 * last.size() - 1);
+      mul(&last[0], (int)last.size(), &last[0], (int)last.size(),
+          &square[0]);
+      powers.push_back(square);
+   }
+   vector<W> product;
+   shiftSplit(out, d, c, powers, product, mul);
+}
+
+//----------------------------- shiftField --------------------------------
+// a(x + c) over a field, by one product
+// Preconditions:   1 <= d < p; out has room for d coefficients and does
+//       not overlap a
+// Postconditions:  out holds the coefficients of a(x + c)
+template <class W, class Mul>
+void shiftField(const W* a, int d, W c, W* out, Mul mul) {
+   vector<W> factorial(d), inverse(d), u(d), v(d), product;
+   factorial[0] = W(1);
+   for (int i = 1; i < d; i++)
+      factorial[i] = factorial[i - 1] * W(i);
+   inverse[d - 1] = factorial[d - 1].inverse();
+   for (int i = d - 1; i > 0; i--)
+      inverse[i - 1] = inverse[i] * W(i);
+   W power(1);
+   for (int i = 0; i < d; i++) {
+      u[i] = a[d - 1 - i] * factorial[d - 1 - i];
+      v[i] = power * inverse[i];
+      power *= c;
+   }
+   polyseries::mullow(&u[0], d, &v[0], d, d, out, product, mul);
+   reverse(out, out + d);
+   for (int k = 0; k < d; k++)
+      out[k] *= inverse[k];
+}
+
+//------------------------------- compose ---------------------------------
+// a(b(x)) modulo x^n by baby steps and giant steps
+// Preconditions:   na >= 1, nb >= 1, n >= 1; out has room for n and does
+//       not overlap a or b
+// Postconditions:  out[0..n) holds a(b) mod x^n
+template <class W, class Mul>
+void compose(const W* a, int na, const W* b, int nb, int n, W* out,
+             Mul mul) {
+   nb = min(nb, n);
+   int m = 1;
+   while ((long long)m * m < na)
+      m++;
+   //baby[i] = b^i mod x^n, without the zeros above its degree
+   vector<vector<W> > baby(m + 1);
+   vector<W> product;
+   baby[0].assign(1, W(1));
+   for (int i = 1; i <= m; i++) {
+      const vector<W>& last = baby[i - 1];
+      int len = (int)min((long long)n, (long long)last.size() + nb - 1);
+      baby[i].resize(len);
+      polyseries::mullow(&last[0], (int)last.size(), b, nb, len,
+                         &baby[i][0], product, mul);
+   }
+   const vector<W>& giant = baby[m];
+
+   vector<W> next(n);
+   fill(out, out + n, W(0));
+   int used = 0;                    //terms of out that may be nonzero
+   for (int j = (na - 1) / m; j >= 0; j--) {
+      if (used > 0) {
+         polyseries::mullow(out, used, &giant[0], (int)giant.size(), n,
+                            &next[0], product, mul);
+         copy(next.begin(), next.end(), out);
+         used = min(n, used + (int)giant.size() - 1);
+      }
+      for (int i = 0; i < m && j * m + i < na; i++) {
+         W coeff = a[j * m + i];
+         const vector<W>& p = baby[i];
+         for (size_t t = 0; t < p.size(); t++)
+            out[t] += coeff * p[t];
+         used = max(used, (int)p.size());
+      }
+   }
+}
+
+} // namespace polycompose
+
+#endif
@@ -0,0 +1,340 @@
+//-----------------------------------------------------------------------//
+// POLYEVAL.H                                                            //
+//                                                                       //
+// Evaluation of a Poly at one point or many; included by poly.h         //
+//-----------------------------------------------------------------------//
+// BasicPoly<T>::evaluate() substitutes a point x of type X for the      //
+// variable, reading the coefficient array directly:                     //
+//                                                                       //
+//     X y = p.evaluate(x);                  one point                   //
+//     p.evaluate(xs, ys, n);                ys[i] = p(xs[i]), i < n     //
+//                                                                       //
+// X may be an integer type, whose arithmetic wraps exactly as the       //
+// product of two Polys does, a floating point type, or any coefficient  //
+// type of polycoeff.h.                                                  //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- arithmetic is done in PolyCoeffTraits<X>::Word, so int points    //
+//      wrap modulo 2^32 instead of overflowing                          //
+//   -- one point:  the DENSE array is split into 4 interleaved chains   //
+//      in x^4 (Estrin's scheme), which are independent and so overlap   //
+//      in the pipeline; low degrees use plain Horner                    //
+//   -- many points: Horner's rule for a block of points at a time, one  //
+//      point per SIMD lane.  With AVX/AVX2 or SSE2/SSE4.1 enabled at    //
+//      compile time (e.g. -march=native), double and 32 bit int points  //
+//      use intrinsics; every other case is a plain loop over the block  //
+//   -- points are processed TILE at a time and coefficients CHUNK at a  //
+//      time, so both stay in the L1 cache at high degree                //
+//   -- at high degree, many points of the coefficient type T itself     //
+//      are evaluated with a subproduct tree instead (see polytree.h)    //
+//   -- a SPARSE Poly is evaluated term by term, raising x to the gap    //
+//      between exponents by repeated squaring                           //
+//   -- for floating point X, one point and many points may differ in    //
+//      rounding, as they add the terms in a different order; FMA is     //
+//      used when enabled at compile time                                //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYEVAL_H
+#define POLYEVAL_H
+
+#include <algorithm>
+#include <stddef.h>
+#include "polyseries.h"
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace polyeval {
+
+//a single point is evaluated with Estrin's scheme from this degree up
+const int ESTRIN_MIN_DEGREE = 16;
+
+//points evaluated together, and coefficients applied to them per pass
+const int TILE = 256;
+const int CHUNK = 1024;
+
+//------------------------------- horner ----------------------------------
+// Apply coefficients hi down to lo to one running Horner value
+// Preconditions:   hi >= lo - 1
+// Postconditions:  returns acc * x^(hi-lo+1) + coeffs[hi] * x^(hi-lo)
+//       + ... + coeffs[lo]
+template <class W, class C>
+W horner(const C* coeffs, int hi, int lo, W x, W acc) {
+   for (int e = hi; e >= lo; e--)
+      acc = acc * x + W(coeffs[e]);
+   return acc;
+}
+
+//------------------------------- estrin ----------------------------------
+// Evaluate coeffs[0..degree] at one point
+// Preconditions:   degree >= 0
+// Postconditions:  returns the value at x.  From ESTRIN_MIN_DEGREE up, the
+//       coefficients with exponents k, k+4, k+8, ... form chain k, a
+//       polynomial in x^4 evaluated by Horner's rule; the four chains are
+//       then combined as p0 + x*(p1 + x*(p2 + x*p3))
+template <class W, class C>
+W estrin(const C* coeffs, int degree, W x) {
+   if (degree < ESTRIN_MIN_DEGREE)
+      return horner(coeffs, degree - 1, 0, x, W(coeffs[degree]));
+   W x2 = x * x;
+   W x4 = x2 * x2;
+   int m = degree / 4;
+   int r = degree % 4;
+   //chains k <= r start at exponent 4m + k, the others at 4(m-1) + k
+   W p0 = W(coeffs[4 * m]);
+   W p1 = W(coeffs[(r >= 1) ? 4 * m + 1 : 4 * m - 3]);
+   W p2 = W(coeffs[(r >= 2) ? 4 * m + 2 : 4 * m - 2]);
+   W p3 = W(coeffs[(r >= 3) ? 4 * m + 3 : 4 * m - 1]);
+   const C* block = coeffs + 4 * (m - 1);
+   p0 = p0 * x4 + W(block[0]);
+   if (r >= 1)
+      p1 = p1 * x4 + W(block[1]);
+   if (r >= 2)
+      p2 = p2 * x4 + W(block[2]);
+   if (r >= 3)
+      p3 = p3 * x4 + W(block[3]);
+   for (int j = m - 2; j >= 0; j--) {
+      block = coeffs + 4 * j;
+      p0 = p0 * x4 + W(block[0]);
+      p1 = p1 * x4 + W(block[1]);
+      p2 = p2 * x4 + W(block[2]);
+      p3 = p3 * x4 + W(block[3]);
+   }
+   return ((p3 * x + p2) * x + p1) * x + p0;
+}
+
+//-------------------------------- Lanes ----------------------------------
+// Horner's rule for BLOCK points at once:
+//       acc[i] = horner(coeffs, hi, lo, xs[i], acc[i]) for i < BLOCK
+// The general version is a loop over the block that the compiler may
+// vectorize; double and unsigned have intrinsic versions below
+template <class W>
+struct Lanes {
+   static const int BLOCK = 8;
+
+   template <class C>
+   static void step(const C* coeffs, int hi, int lo, const W* xs, W* acc) {
+      W a[BLOCK], x[BLOCK];
+      for (int i = 0; i < BLOCK; i++) {
+         a[i] = acc[i];
+         x[i] = xs[i];
+      }
+      for (int e = hi; e >= lo; e--) {
+         W c = W(coeffs[e]);
+         for (int i = 0; i < BLOCK; i++)
+            a[i] = a[i] * x[i] + c;
+      }
+      for (int i = 0; i < BLOCK; i++)
+         acc[i] = a[i];
+   }
+};
+
+#if defined(__AVX__)
+//4 registers of 4 doubles, so four independent multiply-add chains
+template <>
+struct Lanes<double> {
+   static const int BLOCK = 16;
+
+   static __m256d muladd(__m256d a, __m256d x, __m256d c) {
+#if defined(__FMA__)
+      return _mm256_fmadd_pd(a, x, c);
+#else
+      return _mm256_add_pd(_mm256_mul_pd(a, x), c);
+#endif
+   }
+
+   template <class C>
+   static void step(const C* coeffs, int hi, int lo, const double* xs,
+                    double* acc) {
+      __m256d x0 = _mm256_loadu_pd(xs), x1 = _mm256_loadu_pd(xs + 4);
+      __m256d x2 = _mm256_loadu_pd(xs + 8), x3 = _mm256_loadu_pd(xs + 12);
+      __m256d a0 = _mm256_loadu_pd(acc), a1 = _mm256_loadu_pd(acc + 4);
+      __m256d a2 = _mm256_loadu_pd(acc + 8), a3 = _mm256_loadu_pd(acc + 12);
+      for (int e = hi; e >= lo; e--) {
+         __m256d c = _mm256_set1_pd((double)coeffs[e]);
+         a0 = muladd(a0, x0, c);
+         a1 = muladd(a1, x1, c);
+         a2 = muladd(a2, x2, c);
+         a3 = muladd(a3, x3, c);
+      }
+      _mm256_storeu_pd(acc, a0);
+      _mm256_storeu_pd(acc + 4, a1);
+      _mm256_storeu_pd(acc + 8, a2);
+      _mm256_storeu_pd(acc + 12, a3);
+   }
+};
+#elif defined(__SSE2__)
+//4 registers of 2 doubles
+template <>
+struct Lanes<double> {
+   static const int BLOCK = 8;
+
+   template <class C>
+   static void step(const C* coeffs, int hi, int lo, const double* xs,
+                    double* acc) {
+      __m128d x0 = _mm_loadu_pd(xs), x1 = _mm_loadu_pd(xs + 2);
+      __m128d x2 = _mm_loadu_pd(xs + 4), x3 = _mm_loadu_pd(xs + 6);
+      __m128d a0 = _mm_loadu_pd(acc), a1 = _mm_loadu_pd(acc + 2);
+      __m128d a2 = _mm_loadu_pd(acc + 4), a3 = _mm_loadu_pd(acc + 6);
+      for (int e = hi; e >= lo; e--) {
+         __m128d c = _mm_set1_pd((double)coeffs[e]);
+         a0 = _mm_add_pd(_mm_mul_pd(a0, x0), c);
+         a1 = _mm_add_pd(_mm_mul_pd(a1, x1), c);
+         a2 = _mm_add_pd(_mm_mul_pd(a2, x2), c);
+         a3 = _mm_add_pd(_mm_mul_pd(a3, x3), c);
+      }
+      _mm_storeu_pd(acc, a0);
+      _mm_storeu_pd(acc + 2, a1);
+      _mm_storeu_pd(acc + 4, a2);
+      _mm_storeu_pd(acc + 6, a3);
+   }
+};
+#endif
+
+#if defined(__AVX2__)
+//4 registers of 8 unsigned ints; the low 32 bits of a product are the
+//same signed or unsigned, so this serves int points
+template <>
+struct Lanes<unsigned> {
+   static const int BLOCK = 32;
+
+   template <class C>
+   static void step(const C* coeffs, int hi, int lo, const unsigned* xs,
+                    unsigned* acc) {
+      const __m256i* xv = reinterpret_cast<const __m256i*>(xs);
+      __m256i* av = reinterpret_cast<__m256i*>(acc);
+      __m256i x0 = _mm256_loadu_si256(xv), x1 = _mm256_loadu_si256(xv + 1);
+      __m256i x2 = _mm256_loadu_si256(xv + 2), x3 = _mm256_loadu_si256(xv + 3);
+      __m256i a0 = _mm256_loadu_si256(av), a1 = _mm256_loadu_si256(av + 1);
+      __m256i a2 = _mm256_loadu_si256(av + 2), a3 = _mm256_loadu_si256(av + 3);
+      for (int e = hi; e >= lo; e--) {
+         __m256i c = _mm256_set1_epi32((int)(unsigned)coeffs[e]);
+         a0 = _mm256_add_epi32(_mm256_mullo_epi32(a0, x0), c);
+         a1 = _mm256_add_epi32(_mm256_mullo_epi32(a1, x1), c);
+         a2 = _mm256_add_epi32(_mm256_mullo_epi32(a2, x2), c);
+         a3 = _mm256_add_epi32(_mm256_mullo_epi32(a3, x3), c);
+      }
+      _mm256_storeu_si256(av, a0);
+      _mm256_storeu_si256(av + 1, a1);
+      _mm256_storeu_si256(av + 2, a2);
+      _mm256_storeu_si256(av + 3, a3);
+   }
+};
+#elif defined(__SSE4_1__)
+//4 registers of 4 unsigned ints
+template <>
+struct Lanes<unsigned> {
+   static const int BLOCK = 16;
+
+   template <class C>
+   static void step(const C* coeffs, int hi, int lo, const unsigned* xs,
+                    unsigned* acc) {
+      const __m128i* xv = reinterpret_cast<const __m128i*>(xs);
+      __m128i* av = reinterpret_cast<__m128i*>(acc);
+      __m128i x0 = _mm_loadu_si128(xv), x1 = _mm_loadu_si128(xv + 1);
+      __m128i x2 = _mm_loadu_si128(xv + 2), x3 = _mm_loadu_si128(xv + 3);
+      __m128i a0 = _mm_loadu_si128(av), a1 = _mm_loadu_si128(av + 1);
+      __m128i a2 = _mm_loadu_si128(av + 2), a3 = _mm_loadu_si128(av + 3);
+      for (int e = hi; e >= lo; e--) {
+         __m128i c = _mm_set1_epi32((int)(unsigned)coeffs[e]);
+         a0 = _mm_add_epi32(_mm_mullo_epi32(a0, x0), c);
+         a1 = _mm_add_epi32(_mm_mullo_epi32(a1, x1), c);
+         a2 = _mm_add_epi32(_mm_mullo_epi32(a2, x2), c);
+         a3 = _mm_add_epi32(_mm_mullo_epi32(a3, x3), c);
+      }
+      _mm_storeu_si128(av, a0);
+      _mm_storeu_si128(av + 1, a1);
+      _mm_storeu_si128(av + 2, a2);
+      _mm_storeu_si128(av + 3, a3);
+   }
+};
+#endif
+
+//------------------------------ hornerMany -------------------------------
+// Evaluate coeffs[0..degree] at n points
+// Preconditions:   degree >= 0; out may be xs itself
+// Postconditions:  out[i] is the value at xs[i], for i < n
+template <class W, class C>
+void hornerMany(const C* coeffs, int degree, const W* xs, W* out, size_t n) {
+   const int block = Lanes<W>::BLOCK;
+   W acc[TILE];
+   for (size_t start = 0; start < n; start += TILE) {
+      int count = (int)min((size_t)TILE, n - start);
+      const W* x = xs + start;
+      for (int i = 0; i < count; i++)
+         acc[i] = W(coeffs[degree]);
+      for (int hi = degree - 1; hi >= 0; hi -= CHUNK) {
+         int lo = max(hi - CHUNK + 1, 0);
+         int i = 0;
+         for (; i + block <= count; i += block)
+            Lanes<W>::step(coeffs, hi, lo, x + i, acc + i);
+         for (; i < count; i++)
+            acc[i] = horner(coeffs, hi, lo, x[i], acc[i]);
+      }
+      for (int i = 0; i < count; i++)
+         out[start + i] = acc[i];
+   }
+}
+
+//------------------------------ sparseAt ---------------------------------
+// Evaluate SPARSE terms, sorted by increasing exponent, at one point
+// Preconditions:   every term has a nonzero coefficient
+// Postconditions:  returns the value at x; 0 if there are no terms
+template <class W, class Term>
+W sparseAt(const Term* terms, int count, W x) {
+   if (count == 0)
+      return W(0);
+   W acc = W(terms[count - 1].coeff);
+   for (int i = count - 2; i >= 0; i--)
+      acc = acc * polyseries::power(x, terms[i + 1].exp - terms[i].exp)
+            + W(terms[i].coeff);
+   return acc * polyseries::power(x, terms[0].exp);
+}
+
+}
+
+//---------------------------- evaluate -----------------------------------
+// Evaluate Poly at one point
+// Preconditions:   X can be made from T, and has a PolyCoeffTraits Word of
+//       the same size
+// Postconditions:  returns the value at the point, computed in Word
+template <class T>
+template <class X>
+X BasicPoly<T>::evaluate(X x) const {
+   typedef typename PolyCoeffTraits<X>::Word W;
+   W result = sparse
+      ? polyeval::sparseAt(terms.data(), (int)terms.size(), W(x))
+      : polyeval::estrin(coeffPtr, highestExp, W(x));
+   return X(result);
+}
+
+//---------------------------- evaluate -----------------------------------
+// Evaluate Poly at many points
+// Preconditions:   as for one point; xs and out hold n points each, and
+//       out is either xs itself or does not overlap it
+// Postconditions:  out[i] is the value at xs[i], for i < n
+template <class T>
+template <class X>
+void BasicPoly<T>::evaluate(const X* xs, X* out, size_t n) const {
+   typedef typename PolyCoeffTraits<X>::Word W;
+   static_assert(sizeof(W) == sizeof(X), "Word must have the layout of X");
+   const W* wx = reinterpret_cast<const W*>(xs);
+   W* wout = reinterpret_cast<W*>(out);
+   POLY_STATS_OP(OP_EVALUATE, n);
+   if (sparse) {
+      for (size_t i = 0; i < n; i++)
+         wout[i] = polyeval::sparseAt(terms.data(), (int)terms.size(), wx[i]);
+   } else if (!evaluateTree(xs, out, n)) {
+      polyeval::hornerMany(coeffPtr, highestExp, wx, wout, n);
+   }
+}
+
+//--------------------------- evaluateTree --------------------------------
+// Points of a type other than T are always evaluated by Horner's rule
+template <class T>
+template <class X>
+bool BasicPoly<T>::evaluateTree(const X*, X*, size_t) const {
+   return false;
+}
+
+#endif
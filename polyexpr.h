@@ -0,0 +1,485 @@
+//-----------------------------------------------------------------------//
+// POLYEXPR.H                                                            //
+//                                                                       //
+// Lazy expression layer for Poly arithmetic; included by poly.h         //
+//-----------------------------------------------------------------------//
+// Poly + Poly, Poly - Poly, Poly + int, Poly - int and Poly * int do    //
+// not compute anything.  They return a small expression object that     //
+// remembers its operands, so a chain such as                            //
+//                                                                       //
+//     A + B - C + E        A * B - 15        (A - B) * 3 + 1            //
+//                                                                       //
+// is only evaluated when it is assigned to a Poly, used to construct    //
+// one, or printed.  The evaluation makes one pass over the exponents    //
+// 0..degree, where degree is the largest highestExp of the operands,    //
+// and writes each coefficient of the result once into a single array.   //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- every expression derives from PolyExpr<E> and provides           //
+//         Coeff       the coefficient type T of its BasicPoly<T>        //
+//         dense()     true if every Poly operand is DENSE               //
+//         degree()    highestExp of the result                          //
+//         coeff(i)    coefficient i of the result, for i <= degree()    //
+//         reusable()  a temporary Poly owned by the expression whose    //
+//                     array may be written into, or NULL                //
+//         eval()      the result, computed one operator at a time; used //
+//                     when an operand is SPARSE                         //
+//   -- a named Poly operand is held by reference (PolyRef), so it must  //
+//      outlive the expression; a temporary Poly operand, such as the    //
+//      product in A * B - 15, is moved into the expression (PolyTemp)   //
+//   -- Poly * Poly is not lazy: it is evaluated right away by multiply()//
+//   -- the int of Poly + int is converted to the coefficient type, and  //
+//      both operands of + and - must have the same coefficient type     //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYEXPR_H
+#define POLYEXPR_H
+
+#include <type_traits>
+#include <utility>
+
+//------------------------------- PolyRef ---------------------------------
+// Expression leaf referring to a named Poly
+template <class T>
+struct PolyRef : public PolyExpr<PolyRef<T> > {
+   typedef T Coeff;
+   const BasicPoly<T>& p;
+
+   PolyRef(const BasicPoly<T>& poly) : p(poly) {}
+   bool dense() const { return !p.sparse; }
+   int degree() const { return p.highestExp; }
+   T coeff(int i) const { return (i <= p.highestExp) ? p.coeffPtr[i] : T(0); }
+   BasicPoly<T>* reusable() const { return NULL; }
+   BasicPoly<T> eval() const { return p; }
+};
+
+//------------------------------- PolyTemp --------------------------------
+// Expression leaf owning a temporary Poly; its array may be reused for
+// the result when the expression itself is a temporary
+template <class T>
+struct PolyTemp : public PolyExpr<PolyTemp<T> > {
+   typedef T Coeff;
+   mutable BasicPoly<T> p;
+
+   PolyTemp(BasicPoly<T>&& poly) : p(std::move(poly)) {}
+   PolyTemp(const BasicPoly<T>& poly) : p(poly) {}
+   bool dense() const { return !p.sparse; }
+   int degree() const { return p.highestExp; }
+   T coeff(int i) const { return (i <= p.highestExp) ? p.coeffPtr[i] : T(0); }
+   BasicPoly<T>* reusable() const { return p.sparse ? NULL : &p; }
+   BasicPoly<T> eval() const { return p; }
+};
+
+//----------------------------- PolyConstant ------------------------------
+// Expression leaf for a coefficient, i.e. the Poly c*x^0
+template <class T>
+struct PolyConstant : public PolyExpr<PolyConstant<T> > {
+   typedef T Coeff;
+   T c;
+
+   explicit PolyConstant(T value) : c(value) {}
+   bool dense() const { return true; }
+   int degree() const { return 0; }
+   T coeff(int i) const { return (i == 0) ? c : T(0); }
+   BasicPoly<T>* reusable() const { return NULL; }
+   BasicPoly<T> eval() const { return BasicPoly<T>(c); }
+};
+
+//------------------------------- PolySum ---------------------------------
+// Expression node for left + right (SIGN 1) or left - right (SIGN -1)
+template <class L, class R, int SIGN>
+struct PolySum : public PolyExpr<PolySum<L, R, SIGN> > {
+   typedef typename L::Coeff Coeff;
+   L left;
+   R right;
+
+   template <class A, class B>
+   PolySum(A&& a, B&& b) :
+         left(std::forward<A>(a)), right(std::forward<B>(b)) {}
+   bool dense() const { return left.dense() && right.dense(); }
+   int degree() const {
+      int l = left.degree();
+      int r = right.degree();
+      return (l > r) ? l : r;
+   }
+   Coeff coeff(int i) const {
+      return (SIGN > 0) ? left.coeff(i) + right.coeff(i)
+                        : left.coeff(i) - right.coeff(i);
+   }
+   BasicPoly<Coeff>* reusable() const {
+      BasicPoly<Coeff>* p = left.reusable();
+      return (p != NULL) ? p : right.reusable();
+   }
+   BasicPoly<Coeff> eval() const {
+      BasicPoly<Coeff> result = left.eval();
+      if (SIGN > 0)
+         result += right.eval();
+      else
+         result -= right.eval();
+      return result;
+   }
+};
+
+//------------------------------ PolyScaled -------------------------------
+// Expression node for inner * c
+template <class E>
+struct PolyScaled : public PolyExpr<PolyScaled<E> > {
+   typedef typename E::Coeff Coeff;
+   E inner;
+   Coeff c;
+
+   template <class A>
+   PolyScaled(A&& a, Coeff value) : inner(std::forward<A>(a)), c(value) {}
+   bool dense() const { return inner.dense(); }
+   int degree() const { return inner.degree(); }
+   Coeff coeff(int i) const { return inner.coeff(i) * c; }
+   BasicPoly<Coeff>* reusable() const { return inner.reusable(); }
+   BasicPoly<Coeff> eval() const {
+      BasicPoly<Coeff> result = inner.eval();
+      result.scaleBy(c);
+      return result;
+   }
+};
+
+//----------------------------- IsPolyExpr --------------------------------
+// True for Poly and every expression type, under any reference or const
+template <class T>
+struct IsPolyExpr : public std::is_base_of<
+      PolyExpr<typename std::decay<T>::type>, typename std::decay<T>::type> {
+};
+
+//----------------------------- PolyCoeffOf -------------------------------
+// The coefficient type of an operand; has no type member for anything
+// that is not a Poly or expression, so operators using it drop out
+template <class T, bool = IsPolyExpr<T>::value>
+struct PolyCoeffOf {};
+template <class T>
+struct PolyCoeffOf<T, true> {
+   typedef typename std::decay<T>::type::Coeff type;
+};
+
+//---------------------------- SameCoeff ----------------------------------
+// True if two operands are Polys or expressions of one coefficient type
+template <class L, class R, 
+          bool = IsPolyExpr<L>::value && IsPolyExpr<R>::value>
+struct SameCoeff {
+   static const bool value = false;
+};
+template <class L, class R>
+struct SameCoeff<L, R, true> {
+   static const bool value = std::is_same<typename PolyCoeffOf<L>::type,
+                                          typename PolyCoeffOf<R>::type>::value;
+};
+
+//----------------------------- PolyOperand -------------------------------
+// How an operator stores an operand of forwarded type T: a named Poly by
+// reference, a temporary Poly by value, and expression nodes by value
+template <class T>
+struct PolyOperand { typedef typename std::decay<T>::type type; };
+template <class T> struct PolyOperand<BasicPoly<T>&> { 
+   typedef PolyRef<T> type; 
+};
+template <class T> struct PolyOperand<const BasicPoly<T>&> { 
+   typedef PolyRef<T> type; 
+};
+template <class T> struct PolyOperand<BasicPoly<T> > { 
+   typedef PolyTemp<T> type; 
+};
+template <class T> struct PolyOperand<const BasicPoly<T> > { 
+   typedef PolyTemp<T> type; 
+};
+
+//------------------------------ bothPoly ---------------------------------
+// True if both operand types are plain Polys, where the Poly member
+// operators apply instead of the expression ones
+template <class T>
+struct IsBasicPoly { static const bool value = false; };
+template <class T>
+struct IsBasicPoly<BasicPoly<T> > { static const bool value = true; };
+
+template <class L, class R>
+struct BothPoly {
+   static const bool value =
+         IsBasicPoly<typename std::decay<L>::type>::value &&
+         IsBasicPoly<typename std::decay<R>::type>::value;
+};
+
+//------------------------------- polyOf ----------------------------------
+// A Poly operand as is, or any other expression evaluated into a Poly
+template <class T>
+const BasicPoly<T>& polyOf(const BasicPoly<T>& p) {
+   return p;
+}
+template <class E>
+BasicPoly<typename E::Coeff> polyOf(const PolyExpr<E>& e) {
+   return BasicPoly<typename E::Coeff>(e.self());
+}
+
+//------------------------------  +  --------------------------------------
+// Overloaded addition operator; add 2 Polys or expressions
+// Preconditions:   none
+// Postconditions:  an expression for lhs + rhs is returned
+template <class L, class R>
+typename std::enable_if<SameCoeff<L, R>::value,
+      PolySum<typename PolyOperand<L>::type,
+              typename PolyOperand<R>::type, 1> >::type
+operator+(L&& lhs, R&& rhs) {
+   return PolySum<typename PolyOperand<L>::type,
+                  typename PolyOperand<R>::type, 1>(
+         std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+//------------------------------  +  --------------------------------------
+// Overloaded addition operator; add a Poly or expression and an int or
+// coefficient
+// Preconditions:   none
+// Postconditions:  an expression for lhs + rhs is returned
+template <class L>
+PolySum<typename PolyOperand<L>::type, 
+        PolyConstant<typename PolyCoeffOf<L>::type>, 1>
+operator+(L&& lhs, typename PolyCoeffOf<L>::type rhs) {
+   typedef PolyConstant<typename PolyCoeffOf<L>::type> Constant;
+   return PolySum<typename PolyOperand<L>::type, Constant, 1>(
+         std::forward<L>(lhs), Constant(rhs));
+}
+
+//------------------------------  -  --------------------------------------
+// Overloaded subtraction operator; subtract 2 Polys or expressions
+// Preconditions:   none
+// Postconditions:  an expression for lhs - rhs is returned
+template <class L, class R>
+typename std::enable_if<SameCoeff<L, R>::value,
+      PolySum<typename PolyOperand<L>::type,
+              typename PolyOperand<R>::type, -1> >::type
+operator-(L&& lhs, R&& rhs) {
+   return PolySum<typename PolyOperand<L>::type,
+                  typename PolyOperand<R>::type, -1>(
+         std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+//------------------------------  -  --------------------------------------
+// Overloaded subtraction operator; subtract an int or coefficient from
+// a Poly or expression
+// Preconditions:   none
+// Postconditions:  an expression for lhs - rhs is returned
+template <class L>
+PolySum<typename PolyOperand<L>::type, 
+        PolyConstant<typename PolyCoeffOf<L>::type>, -1>
+operator-(L&& lhs, typename PolyCoeffOf<L>::type rhs) {
+   typedef PolyConstant<typename PolyCoeffOf<L>::type> Constant;
+   return PolySum<typename PolyOperand<L>::type, Constant, -1>(
+         std::forward<L>(lhs), Constant(rhs));
+}
+
+//------------------------------  *  --------------------------------------
+// Overloaded multiplication operator; multiply a Poly or expression and
+// an int or coefficient
+// Preconditions:   none
+// Postconditions:  an expression for lhs * rhs is returned
+template <class L>
+PolyScaled<typename PolyOperand<L>::type>
+operator*(L&& lhs, typename PolyCoeffOf<L>::type rhs) {
+   return PolyScaled<typename PolyOperand<L>::type>(std::forward<L>(lhs),
+                                                    rhs);
+}
+
+//------------------------------  *  --------------------------------------
+// Overloaded multiplication operator; multiply expressions that are not
+// both plain Polys, e.g. (A + B) * C
+// Preconditions:   none
+// Postconditions:  the operands are evaluated, and their product is
+//       returned from Poly::multiply()
+template <class L, class R>
+typename std::enable_if<SameCoeff<L, R>::value && !BothPoly<L, R>::value,
+      BasicPoly<typename PolyCoeffOf<L>::type> >::type
+operator*(const L& lhs, const R& rhs) {
+   return polyOf(lhs).multiply(polyOf(rhs));
+}
+
+//--------------------------  /  and  %  ----------------------------------
+// Overloaded division and remainder operators for expressions that are
+// not both plain Polys, e.g. (A * B + C) / B
+// Preconditions:   as for Poly::divmod()
+// Postconditions:  the operands are evaluated, and the quotient or the
+//       remainder of Poly::divmod() is returned
+template <class L, class R>
+typename std::enable_if<SameCoeff<L, R>::value && !BothPoly<L, R>::value,
+      BasicPoly<typename PolyCoeffOf<L>::type> >::type
+operator/(const L& lhs, const R& rhs) {
+   return polyOf(lhs) / polyOf(rhs);
+}
+
+template <class L, class R>
+typename std::enable_if<SameCoeff<L, R>::value && !BothPoly<L, R>::value,
+      BasicPoly<typename PolyCoeffOf<L>::type> >::type
+operator%(const L& lhs, const R& rhs) {
+   return polyOf(lhs) % polyOf(rhs);
+}
+
+//-----------------------------  ==  --------------------------------------
+// Determine if two expressions, not both plain Polys, are equal
+// Preconditions:   none
+// Postconditions:  the operands are evaluated and compared with
+//       Poly::operator==
+template <class L, class R>
+typename std::enable_if<SameCoeff<L, R>::value && !BothPoly<L, R>::value,
+      bool>::type
+operator==(const L& lhs, const R& rhs) {
+   return polyOf(lhs) == polyOf(rhs);
+}
+
+//-----------------------------  !=  --------------------------------------
+// Determine if two expressions, not both plain Polys, are not equal
+// Preconditions:   none
+// Postconditions:  the operands are evaluated and compared with
+//       Poly::operator!=
+template <class L, class R>
+typename std::enable_if<SameCoeff<L, R>::value && !BothPoly<L, R>::value,
+      bool>::type
+operator!=(const L& lhs, const R& rhs) {
+   return polyOf(lhs) != polyOf(rhs);
+}
+
+//-----------------------------  <<  --------------------------------------
+// Overloaded output operator for expressions; prints the evaluated Poly
+// exactly like the Poly output operator
+template <class E>
+ostream& operator<<(ostream& out, const PolyExpr<E>& e) {
+   return out << polyOf(e);
+}
+
+//------------------------- Expression Constructor ------------------------
+// Constructor evaluating a Poly expression
+// Preconditions:  none
+// Postconditions:  the expression is evaluated by assignExpr(), starting
+//       from a Poly with no array
+template <class T>
+template <class E>
+BasicPoly<T>::BasicPoly(const PolyExpr<E>& e) {
+   coeffPtr = NULL;
+   highestExp = 0;
+   capacity = 0;
+   sparse = true;
+   storage = AUTO;
+   allocator = PolyAllocator::getDefault();
+   assignExpr(e.self(), false);
+}
+
+template <class T>
+template <class E>
+BasicPoly<T>::BasicPoly(PolyExpr<E>&& e) {
+   coeffPtr = NULL;
+   highestExp = 0;
+   capacity = 0;
+   sparse = true;
+   storage = AUTO;
+   allocator = PolyAllocator::getDefault();
+   assignExpr(e.self(), true);
+}
+
+//------------------------------  =  --------------------------------------
+// Assignment from a Poly expression
+// Preconditions:   none
+// Postconditions:  the expression is evaluated by assignExpr()
+template <class T>
+template <class E>
+BasicPoly<T>& BasicPoly<T>::operator=(const PolyExpr<E>& e) {
+   assignExpr(e.self(), false);
+   return *this;
+}
+
+template <class T>
+template <class E>
+BasicPoly<T>& BasicPoly<T>::operator=(PolyExpr<E>&& e) {
+   assignExpr(e.self(), true);
+   return *this;
+}
+
+//--------------------------- assignExpr ----------------------------------
+// Evaluate a Poly expression into this Poly
+// Preconditions:   none
+// Postconditions:  this Poly holds the value of the expression.
+//       -- with every operand DENSE, coefficient i of the result is
+//          computed from coefficient i of each operand and written once,
+//          so the result may be written over an operand's array: into
+//          this object's array if it has room (this object may itself be
+//          an operand), else into a reusable temporary's array, else into
+//          one new array.  An array shared with another Poly is never
+//          written over
+//       -- otherwise the expression is evaluated one operator at a time
+//       -- the layout requested for this object is kept, and AUTO picks
+//          the layout from the nonzero count taken during the pass, which
+//          is also cached for termCount(); highestExp is normalized
+template <class T>
+template <class E>
+void BasicPoly<T>::assignExpr(const E& e, bool mayReuse) {
+   static_assert(std::is_same<typename E::Coeff, T>::value,
+                 "operands must have the Poly's coefficient type");
+   POLY_STATS_OP(OP_EXPR, e.degree() + 1);
+   Representation keep = storage;
+   if (!e.dense()) {
+      *this = e.eval();
+      storage = keep;
+      chooseRepresentation();
+      return;
+   }
+
+   int degree = e.degree();
+   BasicPoly* target = this;
+   if (sparse || capacity < degree + 1 || isShared()) {
+      BasicPoly* owned = mayReuse ? e.reusable() : NULL;
+      target = (owned != NULL && owned->capacity >= degree + 1 &&
+                !owned->isShared()) ? owned : NULL;
+   }
+
+   std::atomic<int> nonzero(0);
+   if (target == NULL) {
+      int size = degree + 1;
+      T* fresh = allocArray(size);
+      fillExpr(fresh, e, nonzero);
+      for (int i = size - 1; i > degree; i--)
+         fresh[i] = 0;
+      freeArray();
+      coeffPtr = fresh;
+      capacity = size;
+   } else {
+      T* out = target->coeffPtr;
+      fillExpr(out, e, nonzero);
+      for (int i = target->highestExp; i > degree; i--)
+         out[i] = 0;
+      target->highestExp = degree;
+      if (target != this)
+         *this = std::move(*target);
+   }
+   terms.clear();
+   sparse = false;
+   highestExp = degree;
+   storage = keep;
+   changed();
+   knownTerms.store(nonzero, std::memory_order_relaxed);
+   normalize();
+   if (storage == SPARSE ||
+         (storage == AUTO && wantsSparse(highestExp + 1, nonzero, false)))
+      toSparse();
+}
+
+//----------------------------- fillExpr ----------------------------------
+// Write coefficients 0..degree of a DENSE Poly expression into an array
+// Preconditions:   the array has room for degree + 1 coefficients
+// Postconditions:  out[i] = e.coeff(i), and the nonzero ones are added to
+//       nonzero.  A piece reads only coefficients of its own indexes, so
+//       out may be an operand's array
+template <class T>
+template <class E>
+void BasicPoly<T>::fillExpr(T* out, const E& e, std::atomic<int>& nonzero) {
+   forRange(e.degree() + 1, [out, &e, &nonzero](int lo, int hi) {
+      int count = 0;
+      for (int i = lo; i < hi; i++) {
+         out[i] = e.coeff(i);
+         count += (out[i] != 0);
+      }
+      nonzero += count;
+   });
+}
+
+#endif
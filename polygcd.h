@@ -0,0 +1,278 @@
+//-----------------------------------------------------------------------//
+// POLYGCD.H                                                             //
+//                                                                       //
+// Half-GCD kernels for Poly gcd, extended gcd and resultant             //
+//-----------------------------------------------------------------------//
+// The Euclidean algorithm divides r[i-1] by r[i] for the remainder      //
+// r[i+1] until it is zero; the last nonzero remainder is the gcd.  It   //
+// takes O(n^2) time, one long division per step.  The half-GCD          //
+// algorithm finds the quotients of the first half of the steps, those   //
+// that bring the degree from n down to below n/2, from the high halves  //
+// of the two Polys alone, recursively, as a 2 x 2 matrix of Polys       //
+//                                                                       //
+//     (r[j], r[j+1]) = M (r[0], r[1])                                   //
+//                                                                       //
+// so a gcd takes O(M(n) log n) time for M(n) the time of a product.     //
+//                                                                       //
+// The resultant is found along the way from the degrees and leading     //
+// coefficients of each dividend A and divisor B of the steps:           //
+//                                                                       //
+//     res(A, B) = (-1)^(deg A deg B) lc(B)^(deg A - deg R) res(B, R)    //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- W is a field word with inverse() (ModInt); Polys are vectors of  //
+//      W without leading zeros, the zero Poly being empty               //
+//   -- Mul multiplies two W arrays like polymul::multiply()             //
+//   -- inside halfGcd() the high halves stand for the whole Polys: a    //
+//      step on them is a step on the whole Polys whose degrees are      //
+//      shift higher, with the same leading coefficients                 //
+//   -- below HALF_GCD_MIN the steps are plain long divisions, which     //
+//      are faster there                                                 //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYGCD_H
+#define POLYGCD_H
+
+#include <algorithm>
+#include <vector>
+#include "polytree.h"
+using namespace std;
+
+namespace polygcd {
+
+//halfGcd() recurses on Polys of at least this degree, and gcd() calls it
+//while the divisor has at least this degree; below, steps are long
+//divisions
+const int HALF_GCD_MIN = 256;
+
+//-------------------------------- degree ---------------------------------
+// Degree of a Poly without leading zeros; -1 for the zero Poly
+template <class W>
+int degree(const vector<W>& a) {
+   return (int)a.size() - 1;
+}
+
+//--------------------------------- trim ----------------------------------
+// Remove leading zeros
+template <class W>
+void trim(vector<W>& a) {
+   while (!a.empty() && a.back() == W(0))
+      a.pop_back();
+}
+
+//-------------------------------- product --------------------------------
+// a * b, without leading zeros
+template <class W, class Mul>
+vector<W> product(const vector<W>& a, const vector<W>& b, Mul mul) {
+   vector<W> out;
+   if (!a.empty() && !b.empty()) {
+      polytree::mulInto(a, b, out, mul);
+      trim(out);
+   }
+   return out;
+}
+
+//------------------------------ combine ----------------------------------
+// a + b (SIGN 1) or a - b (SIGN -1), without leading zeros
+template <int SIGN, class W>
+vector<W> combine(const vector<W>& a, const vector<W>& b) {
+   vector<W> out(a);
+   if (out.size() < b.size())
+      out.resize(b.size(), W(0));
+   for (size_t i = 0; i < b.size(); i++) {
+      if (SIGN > 0)
+         out[i] += b[i];
+      else
+         out[i] -= b[i];
+   }
+   trim(out);
+   return out;
+}
+
+//--------------------------------- high ----------------------------------
+// a div x^k: the coefficients of a from k up
+template <class W>
+vector<W> high(const vector<W>& a, int k) {
+   if ((int)a.size() <= k)
+      return vector<W>();
+   return vector<W>(a.begin() + k, a.end());
+}
+
+//-------------------------------- divide ---------------------------------
+// Quotient and remainder of a by b
+// Preconditions:   b is not zero
+// Postconditions:  a == q * b + r with deg r < deg b, both without
+//       leading zeros; b is made monic for polytree::divideMonic()
+template <class W, class Mul>
+void divide(const vector<W>& a, const vector<W>& b, vector<W>& q,
+            vector<W>& r, Mul mul) {
+   if (a.size() < b.size()) {
+      q.clear();
+      r = a;
+      return;
+   }
+   W inverse = b.back().inverse();
+   vector<W> monic(b);
+   for (size_t i = 0; i < monic.size(); i++)
+      monic[i] *= inverse;
+   polytree::divideMonic(&a[0], (int)a.size(), &monic[0],
+                         (int)monic.size(), q, r, mul);
+   for (size_t i = 0; i < q.size(); i++)
+      q[i] *= inverse;
+   trim(q);
+   trim(r);
+}
+
+//-------------------------------- Matrix ---------------------------------
+// 2 x 2 matrix of Polys, acting on a pair (a, b) as a column
+template <class W>
+struct Matrix {
+   vector<W> m[2][2];
+
+   //the identity
+   Matrix() {
+      m[0][0].assign(1, W(1));
+      m[1][1].assign(1, W(1));
+   }
+
+   //(a, b) = (b, a - q * b), applied after this matrix
+   template <class Mul>
+   void step(const vector<W>& q, Mul mul) {
+      for (int j = 0; j < 2; j++) {
+         vector<W> next = combine<-1>(m[0][j], product(q, m[1][j], mul));
+         m[0][j].swap(m[1][j]);
+         m[1][j].swap(next);
+      }
+   }
+
+   //(c, d) = this (a, b); c and d may be a and b
+   template <class Mul>
+   void apply(const vector<W>& a, const vector<W>& b, vector<W>& c,
+              vector<W>& d, Mul mul) const {
+      vector<W> c1 = combine<1>(product(m[0][0], a, mul),
+                                product(m[0][1], b, mul));
+      d = combine<1>(product(m[1][0], a, mul), product(m[1][1], b, mul));
+      c.swap(c1);
+   }
+};
+
+//------------------------------ multiply ---------------------------------
+// The matrix a * b, i.e. b applied first
+template <class W, class Mul>
+Matrix<W> multiply(const Matrix<W>& a, const Matrix<W>& b, Mul mul) {
+   Matrix<W> out;
+   for (int i = 0; i < 2; i++) {
+      for (int j = 0; j < 2; j++) {
+         out.m[i][j] = combine<1>(product(a.m[i][0], b.m[0][j], mul),
+                                  product(a.m[i][1], b.m[1][j], mul));
+      }
+   }
+   return out;
+}
+
+//------------------------------ Resultant --------------------------------
+// Product of the factors of the resultant formula over the steps seen.
+// The factor lc(B)^(deg A - deg R) of a step is split as lc(B)^(deg A)
+// in that step and lc(B)^(-deg R) in the next one, whose dividend is B
+// and divisor R, so each step needs only its own A and B
+template <class W>
+struct Resultant {
+   W value;
+
+   //start from res(a, b), cancelling the lc(a)^(-deg b) of the first step
+   Resultant(const vector<W>& a, const vector<W>& b)
+         : value(polyseries::power(a.back(), degree(b))) {}
+
+   //a step dividing A by B, whose degrees are shift higher than these
+   void step(const vector<W>& a, const vector<W>& b, int shift) {
+      long long na = degree(a) + shift;
+      long long nb = degree(b) + shift;
+      W factor = polyseries::power(b.back(), na)
+                 * polyseries::power(a.back(), nb).inverse();
+      value *= ((na & nb & 1) != 0) ? W(0) - factor : factor;
+   }
+};
+
+//------------------------------ halfGcd ----------------------------------
+// The steps of the Euclidean algorithm on (a, b) that bring the degree
+// below half that of a
+// Preconditions:   deg a > deg b; res is NULL or collects the steps, which
+//       are shift degrees higher than a and b
+// Postconditions:  returns M with (c, d) = M (a, b) two consecutive
+//       remainders of a and b, deg c >= m > deg d for m = ceil(deg a / 2).
+//       The high parts from x^m up give the first steps, down to degree
+//       about 3/4 deg a; one long division and the high parts from x^k
+//       up of the new pair give the rest
+template <class W, class Mul>
+Matrix<W> halfGcd(const vector<W>& a, const vector<W>& b, int shift,
+                  Resultant<W>* res, Mul mul) {
+   int n = degree(a);
+   int m = (n + 1) / 2;
+   Matrix<W> result;
+   if (degree(b) < m)
+      return result;
+   vector<W> c, d, q, r;
+   if (n < HALF_GCD_MIN) {
+      c = a;
+      d = b;
+      while (degree(d) >= m) {
+         divide(c, d, q, r, mul);
+         if (res != NULL)
+            res->step(c, d, shift);
+         result.step(q, mul);
+         c.swap(d);
+         d.swap(r);
+      }
+      return result;
+   }
+
+   result = halfGcd(high(a, m), high(b, m), shift + m, res, mul);
+   result.apply(a, b, c, d, mul);
+   if (degree(d) < m)
+      return result;
+   divide(c, d, q, r, mul);
+   if (res != NULL)
+      res->step(c, d, shift);
+   result.step(q, mul);
+   if (degree(r) < m)
+      return result;
+   int k = 2 * m - degree(d);
+   Matrix<W> rest = halfGcd(high(d, k), high(r, k), shift + k, res, mul);
+   return multiply(rest, result, mul);
+}
+
+//-------------------------------- gcd ------------------------------------
+// Last nonzero remainder of the Euclidean algorithm on (a, b)
+// Preconditions:   cofactors and res are NULL, or cofactors is the
+//       identity and res was made from a and b
+// Postconditions:  returns the gcd, not made monic; empty if both are
+//       zero.  cofactors, if given, is M with (gcd, 0) = M (a, b), and res
+//       has seen every step.  Long pairs are reduced by halfGcd() between
+//       single long divisions
+template <class W, class Mul>
+vector<W> gcd(vector<W> a, vector<W> b, Matrix<W>* cofactors,
+              Resultant<W>* res, Mul mul) {
+   vector<W> q, r;
+   while (!b.empty()) {
+      if (degree(a) > degree(b) && degree(b) >= HALF_GCD_MIN) {
+         Matrix<W> half = halfGcd(a, b, 0, res, mul);
+         half.apply(a, b, a, b, mul);
+         if (cofactors != NULL)
+            *cofactors = multiply(half, *cofactors, mul);
+         if (b.empty())
+            break;
+      }
+      divide(a, b, q, r, mul);
+      if (res != NULL)
+         res->step(a, b, 0);
+      if (cofactors != NULL)
+         cofactors->step(q, mul);
+      a.swap(b);
+      b.swap(r);
+   }
+   return a;
+}
+
+} // namespace polygcd
+
+#endif
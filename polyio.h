@@ -0,0 +1,359 @@
+//-----------------------------------------------------------------------//
+// POLYIO.H                                                              //
+//                                                                       //
+// Binary file format of Poly, and a read-only memory-mapped view        //
+//-----------------------------------------------------------------------//
+// BasicPoly::save() writes, and BasicPoly::load() reads:                //
+//                                                                       //
+//     offset  size  field                                               //
+//          0     4  magic "POLY"                                        //
+//          4     2  format version, VERSION                             //
+//          6     1  coefficient width in bytes                          //
+//          7     1  flags: FLAG_SPARSE for the SPARSE layout            //
+//          8     1  coefficient kind: KIND_SIGNED or KIND_MOD           //
+//          9     3  zero                                                //
+//         12     4  modulus P of KIND_MOD, else 0                       //
+//         16     8  highest exponent                                    //
+//         24     8  count: highest exponent + 1 coefficients (DENSE),   //
+//                   or the number of nonzero terms (SPARSE)             //
+//         32        DENSE:  count coefficients, exponent 0 first        //
+//                   SPARSE: count 4-byte exponents in increasing        //
+//                           order, zero padded to a multiple of 16      //
+//                           bytes, then their count coefficients        //
+//                                                                       //
+// Every field is little-endian; signed coefficients are two's           //
+// complement, ModInt ones their value in [0, P).  Both arrays start on  //
+// a 16-byte boundary, so PolyView reads a mapped file in place:         //
+//                                                                       //
+//     PolyView<int64_t> view("big.poly");                               //
+//     int64_t c = view.getCoeff(1000000);      // no copy, no parsing   //
+//     Poly64 p = view.toPoly();                // one pass to a Poly    //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- a file of narrower signed coefficients loads as a wider type,    //
+//      sign extended (a Poly file as a Poly64); any other mismatch of   //
+//      kind, width or modulus throws runtime_error, as do a bad magic   //
+//      number, a newer version, and a truncated or inconsistent file    //
+//   -- PolyView needs POSIX mmap().  data() gives the coefficients as   //
+//      a T array only when the file holds them in T's own layout: same  //
+//      width, little-endian host, and not ModInt (Montgomery form in    //
+//      memory); getCoeff() works for every file                         //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYIO_H
+#define POLYIO_H
+
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+namespace polyio {
+
+const int VERSION = 1;
+const int HEADER_SIZE = 32;
+const int ALIGN = 16;
+const int FLAG_SPARSE = 1;
+const int KIND_SIGNED = 0;
+const int KIND_MOD = 1;
+
+//coefficients can be copied to and from the file as raw bytes
+const bool LITTLE_ENDIAN_HOST = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+
+//------------------------------ Header -----------------------------------
+// The fields of the first HEADER_SIZE bytes
+struct Header {
+   int version;
+   int width;
+   int kind;
+   bool sparse;
+   uint32_t modulus;
+   uint64_t highestExp;
+   uint64_t count;
+};
+
+//-------------------------- putLE / getLE --------------------------------
+// Store or fetch an unsigned integer of a number of bytes, little-endian
+inline void putLE(unsigned char* out, uint64_t x, int bytes) {
+   for (int k = 0; k < bytes; k++)
+      out[k] = (unsigned char)(x >> (8 * k));
+}
+
+inline uint64_t getLE(const unsigned char* in, int bytes) {
+   uint64_t x = 0;
+   for (int k = 0; k < bytes; k++)
+      x |= (uint64_t)in[k] << (8 * k);
+   return x;
+}
+
+//------------------------------ padded -----------------------------------
+// A number of bytes rounded up to a multiple of ALIGN
+inline uint64_t padded(uint64_t bytes) {
+   return (bytes + ALIGN - 1) / ALIGN * ALIGN;
+}
+
+//---------------------------- coeffOffset --------------------------------
+// Where the coefficients start, counted from the end of the header; the
+// exponents of a SPARSE file are at offset 0
+inline uint64_t coeffOffset(const Header& h) {
+   return h.sparse ? padded(h.count * 4) : 0;
+}
+
+//---------------------------- payloadSize --------------------------------
+// Number of bytes after the header
+inline uint64_t payloadSize(const Header& h) {
+   return coeffOffset(h) + h.count * h.width;
+}
+
+//---------------------------- writeHeader --------------------------------
+// Preconditions:   out has room for HEADER_SIZE bytes
+// Postconditions:  out holds the header fields in the file layout
+inline void writeHeader(const Header& h, unsigned char* out) {
+   memset(out, 0, HEADER_SIZE);
+   memcpy(out, "POLY", 4);
+   putLE(out + 4, h.version, 2);
+   out[6] = (unsigned char)h.width;
+   out[7] = h.sparse ? FLAG_SPARSE : 0;
+   out[8] = (unsigned char)h.kind;
+   putLE(out + 12, h.modulus, 4);
+   putLE(out + 16, h.highestExp, 8);
+   putLE(out + 24, h.count, 8);
+}
+
+//---------------------------- readHeader ---------------------------------
+// Preconditions:   in holds the first size bytes of a file, or at least
+//       its HEADER_SIZE bytes when size is 0 (the rest is not known yet)
+// Postconditions:  h holds the header fields; throws runtime_error if the
+//       header is malformed, or the file is shorter than it says
+inline void readHeader(const unsigned char* in, uint64_t size, Header& h) {
+   if ((size != 0 && size < (uint64_t)HEADER_SIZE) ||
+         memcmp(in, "POLY", 4) != 0)
+      throw runtime_error("Poly file: bad magic number");
+   h.version = (int)getLE(in + 4, 2);
+   h.width = in[6];
+   h.sparse = (in[7] & FLAG_SPARSE) != 0;
+   h.kind = in[8];
+   h.modulus = (uint32_t)getLE(in + 12, 4);
+   h.highestExp = getLE(in + 16, 8);
+   h.count = getLE(in + 24, 8);
+   if (h.version > VERSION)
+      throw runtime_error("Poly file: newer format version");
+   if (h.width == 0 || h.width > 16 ||
+         (h.kind != KIND_SIGNED && h.kind != KIND_MOD))
+      throw runtime_error("Poly file: bad coefficient type");
+   if (h.highestExp > 0x7FFFFFFF ||
+         (h.sparse ? h.count > h.highestExp + 1
+                   : h.count != h.highestExp + 1))
+      throw runtime_error("Poly file: bad term count");
+   if (size != 0 && size - HEADER_SIZE < payloadSize(h))
+      throw runtime_error("Poly file: truncated");
+}
+
+//------------------------------ Codec ------------------------------------
+// How a coefficient type is stored
+//       -- KIND, WIDTH, MODULUS:  the header fields it is written with
+//       -- IN_PLACE:  the file bytes are the T in memory
+//       -- encode():  write WIDTH little-endian bytes
+//       -- decode():  read width bytes, width <= WIDTH
+template <class I, class U, bool RAW = LITTLE_ENDIAN_HOST>
+struct SignedCodec {
+   static const int KIND = KIND_SIGNED;
+   static const int WIDTH = sizeof(I);
+   static const uint32_t MODULUS = 0;
+   static const bool IN_PLACE = RAW;
+
+   static void encode(I x, unsigned char* out) {
+      U u = (U)x;
+      for (int k = 0; k < WIDTH; k++)
+         out[k] = (unsigned char)(u >> (8 * k));
+   }
+   static I decode(const unsigned char* in, int width) {
+      U u = 0;
+      for (int k = 0; k < width; k++)
+         u |= (U)in[k] << (8 * k);
+      if (width < WIDTH && (in[width - 1] & 0x80))
+         u |= ~(U)0 << (8 * width);       //sign extend
+      return (I)u;
+   }
+};
+
+template <class T> struct Codec;
+template <> struct Codec<int> : SignedCodec<int, uint32_t> {};
+template <> struct Codec<int64_t> : SignedCodec<int64_t, uint64_t> {};
+template <> struct Codec<__int128>
+      : SignedCodec<__int128, unsigned __int128> {};
+
+template <>
+struct Codec<CheckedInt> : SignedCodec<int, uint32_t> {
+   static void encode(CheckedInt x, unsigned char* out) {
+      SignedCodec<int, uint32_t>::encode(x.value(), out);
+   }
+   static CheckedInt decode(const unsigned char* in, int width) {
+      return CheckedInt(SignedCodec<int, uint32_t>::decode(in, width));
+   }
+};
+
+template <uint32_t P>
+struct Codec<ModInt<P> > {
+   static const int KIND = KIND_MOD;
+   static const int WIDTH = 4;
+   static const uint32_t MODULUS = P;
+   static const bool IN_PLACE = false;
+
+   static void encode(ModInt<P> x, unsigned char* out) {
+      putLE(out, x.value(), 4);
+   }
+   static ModInt<P> decode(const unsigned char* in, int) {
+      return ModInt<P>((long long)getLE(in, 4));
+   }
+};
+
+//------------------------------ accepts ----------------------------------
+// Determine if a file's coefficients can be read as T
+// Preconditions:   none
+// Postconditions:  returns true for the same kind and modulus, and a
+//       width no larger than T's (equal for KIND_MOD)
+template <class T>
+bool accepts(const Header& h) {
+   typedef Codec<T> C;
+   return h.kind == C::KIND && h.modulus == C::MODULUS &&
+          (h.width == C::WIDTH ||
+           (h.kind == KIND_SIGNED && h.width < C::WIDTH));
+}
+
+//---------------------------- MappedFile ---------------------------------
+// A whole file mapped read-only into memory, unmapped on destruction
+class MappedFile {
+public:
+explicit MappedFile(const string& path) : bytes(NULL), length(0) {
+   int fd = open(path.c_str(), O_RDONLY);
+   if (fd < 0)
+      throw runtime_error("cannot open " + path);
+   struct stat info;
+   if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      length = (size_t)info.st_size;
+      void* p = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+      bytes = (p == MAP_FAILED) ? NULL : (const unsigned char*)p;
+   }
+   close(fd);
+   if (bytes == NULL)
+      throw runtime_error("cannot map " + path);
+}
+
+~MappedFile() {
+   munmap((void*)bytes, length);
+}
+
+const unsigned char* data() const { return bytes; }
+size_t size() const { return length; }
+
+private:
+MappedFile(const MappedFile&);
+MappedFile& operator=(const MappedFile&);
+
+const unsigned char* bytes;
+size_t length;
+};
+
+} // namespace polyio
+
+//------------------------------ PolyView ---------------------------------
+// A saved Poly used straight from its memory-mapped file
+template <class T>
+class PolyView {
+public:
+//------------------------------ Constructor ------------------------------
+// Preconditions:   the file was written by BasicPoly::save() with
+//       coefficients that can be read as T
+// Postconditions:  the file is mapped; throws runtime_error if it cannot
+//       be opened or is not such a file
+explicit PolyView(const string& path) : file(path) {
+   polyio::readHeader(file.data(), file.size(), header);
+   if (!polyio::accepts<T>(header))
+      throw runtime_error("Poly file: coefficients of another type");
+   const unsigned char* payload = file.data() + polyio::HEADER_SIZE;
+   exps = payload;
+   coeffs = payload + polyio::coeffOffset(header);
+}
+
+//--------------------------- getHighestExp -------------------------------
+int getHighestExp() const { return (int)header.highestExp; }
+
+//----------------------------- isSparse ----------------------------------
+// Determine if the file holds the SPARSE layout
+bool isSparse() const { return header.sparse; }
+
+//----------------------------- getCount ----------------------------------
+// Number of coefficients in the file: getHighestExp() + 1 for DENSE, the
+// number of nonzero terms for SPARSE
+int getCount() const { return (int)header.count; }
+
+//----------------------------- getCoeff ----------------------------------
+// Get the coefficient of an exponent, reading the file in place
+// Preconditions:   none
+// Postconditions:  returns the coefficient, 0 for an absent exponent;
+//       SPARSE files are binary searched
+T getCoeff(int exponent) const {
+   if (exponent < 0 || exponent > getHighestExp())
+      return T(0);
+   int k = exponent;
+   if (header.sparse) {
+      int low = 0;
+      int high = getCount();
+      while (low < high) {
+         int mid = low + (high - low) / 2;
+         if ((int)polyio::getLE(exps + 4 * mid, 4) < exponent)
+            low = mid + 1;
+         else
+            high = mid;
+      }
+      if (low == getCount() ||
+            (int)polyio::getLE(exps + 4 * low, 4) != exponent)
+         return T(0);
+      k = low;
+   }
+   return coeffAt(k);
+}
+
+//----------------------------- getTerm -----------------------------------
+// Get the k-th stored term: for DENSE, exponent k
+// Preconditions:   0 <= k < getCount()
+// Postconditions:  exponent and coefficient are set
+void getTerm(int k, int& exponent, T& coeff) const {
+   exponent = header.sparse ? (int)polyio::getLE(exps + 4 * k, 4) : k;
+   coeff = coeffAt(k);
+}
+
+//------------------------------- data ------------------------------------
+// The stored coefficients as a T array inside the mapping, or NULL if
+// the file does not hold them in T's layout
+const T* data() const {
+   bool raw = polyio::Codec<T>::IN_PLACE &&
+              header.width == (int)sizeof(T);
+   return raw ? reinterpret_cast<const T*>(coeffs) : NULL;
+}
+
+//------------------------------ toPoly -----------------------------------
+// Copy the file's terms into a Poly, as BasicPoly::load() does
+BasicPoly<T> toPoly() const {
+   return BasicPoly<T>::load(file.data(), file.size());
+}
+
+private:
+T coeffAt(int k) const {
+   return polyio::Codec<T>::decode(coeffs + (size_t)k * header.width,
+                                   header.width);
+}
+
+polyio::MappedFile file;
+polyio::Header header;
+const unsigned char* exps;       //SPARSE exponents
+const unsigned char* coeffs;
+};
+
+#endif
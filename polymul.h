@@ -0,0 +1,301 @@
+//-----------------------------------------------------------------------//
+// POLYMUL.H                                                             //
+//                                                                       //
+// Dense polynomial multiplication kernels used by Poly                  //
+//-----------------------------------------------------------------------//
+// Every kernel multiplies two coefficient arrays, where array position  //
+// is the exponent value, and writes the full product into a buffer the  //
+// caller has already allocated:                                         //
+//                                                                       //
+//     a[0..na) * b[0..nb)  ->  out[0..na+nb-1)                          //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- the coefficient type W is an unsigned integer type, so all       //
+//      arithmetic wraps modulo 2^bits exactly like the schoolbook loop, //
+//      or a ring type such as ModInt (see polycoeff.h), where only the  //
+//      schoolbook and Karatsuba kernels are used                        //
+//   -- schoolbook:  O(na*nb), used below KARATSUBA_THRESHOLD            //
+//   -- Karatsuba:   3 half size products, no divisions, so it is exact  //
+//      modulo 2^bits for any W                                          //
+//   -- Toom-3:      5 third size products; its interpolation divides    //
+//      by 2 and 3.  Dividing by 3 is exact modulo 2^bits, dividing by   //
+//      2 loses the top bit, so each Toom-3 level is exact modulo        //
+//      2^(bits-1).  Callers only use it with a W at least twice as wide //
+//      as the coefficients they keep                                    //
+//   -- unbalanced operands are cut into blocks of the shorter length    //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYMUL_H
+#define POLYMUL_H
+
+#include <type_traits>
+#include <vector>
+using namespace std;
+
+namespace polymul {
+
+//operands shorter than this are multiplied with the schoolbook loop
+const int KARATSUBA_THRESHOLD = 32;
+
+//balanced operands at least this long use Toom-3 when it is allowed
+const int TOOM3_THRESHOLD = 256;
+
+//---------------------------- schoolbook ---------------------------------
+// Multiply two coefficient arrays with the O(na*nb) double loop
+// Preconditions:   na >= 1, nb >= 1, out has room for na + nb - 1
+// Postconditions:  out holds the product; previous contents are ignored
+template <class W>
+void schoolbook(const W* a, int na, const W* b, int nb, W* out) {
+   for (int i = na + nb - 2; i >= 0; i--)
+      out[i] = 0;
+   for (int i = 0; i < na; i++) {
+      W ai = a[i];
+      W* row = out + i;
+      for (int j = 0; j < nb; j++)
+         row[j] += ai * b[j];
+   }
+}
+
+//--------------------------- scratchSize ---------------------------------
+// Number of scratch elements mulBalanced() needs for operands of size n
+// Preconditions:   n >= 1
+// Postconditions:  returns an upper bound on the scratch used by the
+//       recursion, including every level below this one
+inline int scratchSize(int n, bool useToom) {
+   if (n < KARATSUBA_THRESHOLD)
+      return 0;
+   if (useToom && n >= TOOM3_THRESHOLD) {
+      int k = (n + 2) / 3;
+      return 12 * k + scratchSize(k, useToom);
+   }
+   int h = n - n / 2;
+   return 4 * h + scratchSize(h, useToom);
+}
+
+template <class W>
+void mulBalanced(const W* a, const W* b, int n, W* out, W* scratch,
+                 bool useToom);
+
+//--------------------------- Toom3Allowed --------------------------------
+// True for the word types Toom-3 can run on: unsigned integers, whose
+// shifts and wrapping division by 3 it relies on
+template <class W>
+struct Toom3Allowed {
+   static const bool value = is_integral<W>::value && is_unsigned<W>::value;
+};
+template <> struct Toom3Allowed<unsigned __int128> {
+   static const bool value = true;
+};
+
+//---------------------------- karatsuba ----------------------------------
+// One Karatsuba level for operands of equal size n
+// Preconditions:   n >= 2, out has room for 2n - 1, scratch has room for
+//       scratchSize(n)
+// Postconditions:  out holds a * b
+//       a = a0 + a1*x^m,  b = b0 + b1*x^m
+//       a*b = z0 + ((a0+a1)(b0+b1) - z0 - z2)*x^m + z2*x^2m
+template <class W>
+void karatsuba(const W* a, const W* b, int n, W* out, W* scratch,
+               bool useToom) {
+   int m = n / 2;       //size of the low halves
+   int h = n - m;       //size of the high halves, h >= m
+
+   W* sa = scratch;
+   W* sb = sa + h;
+   W* z1 = sb + h;      //2h - 1 elements
+   W* rest = z1 + 2 * h;
+
+   //z0 and z2 go straight into their places in out
+   mulBalanced(a, b, m, out, rest, useToom);
+   out[2 * m - 1] = 0;
+   mulBalanced(a + m, b + m, h, out + 2 * m, rest, useToom);
+
+   for (int i = 0; i < h; i++) {
+      sa[i] = a[m + i];
+      sb[i] = b[m + i];
+   }
+   for (int i = 0; i < m; i++) {
+      sa[i] += a[i];
+      sb[i] += b[i];
+   }
+   mulBalanced(sa, sb, h, z1, rest, useToom);
+
+   for (int i = 0; i < 2 * m - 1; i++)
+      z1[i] -= out[i];
+   for (int i = 0; i < 2 * h - 1; i++)
+      z1[i] -= out[2 * m + i];
+   for (int i = 0; i < 2 * h - 1; i++)
+      out[m + i] += z1[i];
+}
+
+//------------------------------ toom3 ------------------------------------
+// One Toom-3 level for operands of equal size n, evaluating at
+// 0, 1, -1, -2 and infinity with Bodrato's interpolation sequence
+// Preconditions:   n >= 5, out has room for 2n - 1, scratch has room for
+//       scratchSize(n)
+// Postconditions:  out holds a * b, exact modulo 2^(bits-1) (see top)
+template <class W>
+void toom3(const W* a, const W* b, int n, W* out, W* scratch,
+           bool useToom) {
+   int k = (n + 2) / 3;     //size of the two low parts
+   int r = n - 2 * k;       //size of the top part, 1 <= r <= k
+
+   const W* a0 = a;
+   const W* a1 = a + k;
+   const W* a2 = a + 2 * k;
+   const W* b0 = b;
+   const W* b1 = b + k;
+   const W* b2 = b + 2 * k;
+
+   W* p1 = scratch;          W* q1 = p1 + k;
+   W* pm1 = q1 + k;          W* qm1 = pm1 + k;
+   W* pm2 = qm1 + k;         W* qm2 = pm2 + k;
+   W* r1 = qm2 + k;          //each product is 2k - 1 elements
+   W* rm1 = r1 + 2 * k;
+   W* rm2 = rm1 + 2 * k;
+   W* rest = rm2 + 2 * k;
+
+   //evaluate: p(1) = a0+a1+a2, p(-1) = a0-a1+a2, p(-2) = a0-2a1+4a2
+   for (int i = 0; i < k; i++) {
+      W top = (i < r) ? a2[i] : 0;
+      W even = a0[i] + top;
+      p1[i] = even + a1[i];
+      pm1[i] = even - a1[i];
+      pm2[i] = ((pm1[i] + top) << 1) - a0[i];
+
+      top = (i < r) ? b2[i] : 0;
+      even = b0[i] + top;
+      q1[i] = even + b1[i];
+      qm1[i] = even - b1[i];
+      qm2[i] = ((qm1[i] + top) << 1) - b0[i];
+   }
+
+   //r(0) and r(inf) go straight into their places in out
+   mulBalanced(a0, b0, k, out, rest, useToom);
+   for (int i = 2 * k - 1; i < 4 * k; i++)
+      out[i] = 0;
+   mulBalanced(a2, b2, r, out + 4 * k, rest, useToom);
+   mulBalanced(p1, q1, k, r1, rest, useToom);
+   mulBalanced(pm1, qm1, k, rm1, rest, useToom);
+   mulBalanced(pm2, qm2, k, rm2, rest, useToom);
+
+   //exact division by 3 is multiplication by the inverse of 3
+   const W inv3 = (W)((W)(~(W)0) / 3 * 2 + 1);
+   const W* r0 = out;
+   const W* rinf = out + 4 * k;
+   for (int i = 0; i < 2 * k - 1; i++) {
+      W v0 = r0[i];
+      W vinf = (i < 2 * r - 1) ? rinf[i] : 0;
+      W v3 = (rm2[i] - r1[i]) * inv3;
+      W v1 = (r1[i] - rm1[i]) >> 1;
+      W v2 = rm1[i] - v0;
+      v3 = ((v2 - v3) >> 1) + (vinf << 1);
+      v2 = v2 + v1 - vinf;
+      v1 = v1 - v3;
+      r1[i] = v1;
+      rm1[i] = v2;
+      rm2[i] = v3;
+   }
+
+   //recompose: out = r0 + r1 x^k + r2 x^2k + r3 x^3k + rinf x^4k
+   int outSize = 2 * n - 1;
+   for (int i = 0; i < 2 * k - 1; i++) {
+      out[k + i] += r1[i];
+      out[2 * k + i] += rm1[i];
+      if (3 * k + i < outSize)
+         out[3 * k + i] += rm2[i];
+   }
+}
+
+//----------------------------- Toom3Step ---------------------------------
+// Run one Toom-3 level if it is allowed for W and pays off for size n.
+// apply() returns false, doing nothing, otherwise; for other word types
+// toom3() is never instantiated
+template <class W, bool ALLOWED = Toom3Allowed<W>::value>
+struct Toom3Step {
+   static bool apply(const W*, const W*, int, W*, W*, bool) {
+      return false;
+   }
+};
+
+template <class W>
+struct Toom3Step<W, true> {
+   static bool apply(const W* a, const W* b, int n, W* out, W* scratch,
+                     bool useToom) {
+      if (!useToom || n < TOOM3_THRESHOLD)
+         return false;
+      toom3(a, b, n, out, scratch, useToom);
+      return true;
+   }
+};
+
+//--------------------------- mulBalanced ---------------------------------
+// Multiply two operands of equal size n, picking the kernel by size
+// Preconditions:   n >= 1, out has room for 2n - 1, scratch has room for
+//       scratchSize(n, useToom)
+// Postconditions:  out holds a * b
+template <class W>
+void mulBalanced(const W* a, const W* b, int n, W* out, W* scratch,
+                 bool useToom) {
+   if (n < KARATSUBA_THRESHOLD)
+      schoolbook(a, n, b, n, out);
+   else if (!Toom3Step<W>::apply(a, b, n, out, scratch, useToom))
+      karatsuba(a, b, n, out, scratch, useToom);
+}
+
+//----------------------------- multiply ----------------------------------
+// Multiply two operands of any sizes
+// Preconditions:   na >= 1, nb >= 1, out has room for na + nb - 1 and does
+//       not overlap a or b
+// Postconditions:  out holds a * b.  The longer operand is cut into
+//       blocks as long as the shorter one, and the balanced block
+//       products are added into out.  The scratch space and the block
+//       product are kept in work, which a caller multiplying many times
+//       may reuse
+template <class W>
+void multiply(const W* a, int na, const W* b, int nb, W* out, bool useToom,
+              vector<W>& work) {
+   if (na < nb) {
+      const W* t = a; a = b; b = t;
+      int tn = na; na = nb; nb = tn;
+   }
+   if (nb < KARATSUBA_THRESHOLD) {
+      schoolbook(a, na, b, nb, out);
+      return;
+   }
+
+   int size = scratchSize(nb, useToom) + 1;
+   work.resize(size + 2 * nb - 1);
+   W* scratch = &work[0];
+   if (na == nb) {
+      mulBalanced(a, b, nb, out, scratch, useToom);
+      return;
+   }
+
+   W* block = scratch + size;
+   for (int i = na + nb - 2; i >= 0; i--)
+      out[i] = 0;
+   for (int start = 0; start < na; start += nb) {
+      int len = na - start;
+      if (len >= nb) {
+         len = nb;
+         mulBalanced(a + start, b, nb, block, scratch, useToom);
+      } else {
+         vector<W> rest;
+         multiply(b, nb, a + start, len, block, useToom, rest);
+      }
+      for (int i = len + nb - 2; i >= 0; i--)
+         out[start + i] += block[i];
+   }
+}
+
+//with its own scratch space
+template <class W>
+void multiply(const W* a, int na, const W* b, int nb, W* out, bool useToom) {
+   vector<W> work;
+   multiply(a, na, b, nb, out, useToom, work);
+}
+
+} // namespace polymul
+
+#endif
@@ -0,0 +1,574 @@
+//-----------------------------------------------------------------------//
+// POLYMULTI.H                                                           //
+//                                                                       //
+// Multivariate polynomials in 1 to 6 variables, built on Poly           //
+//-----------------------------------------------------------------------//
+// BasicMultiPoly<T> holds a polynomial in the first getVars() of x, y,  //
+// z, u, v and w as its nonzero terms, sorted by monomial in one vector. //
+// A monomial x^a y^b z^c is packed into one 64-bit word, a field of     //
+// FIELD = 64 / vars bits per variable, x highest:                       //
+//                                                                       //
+//     | 0 a | 0 b | 0 c |          3 variables: 21-bit fields           //
+//                                                                       //
+// Comparing two words compares their monomials in lexicographic order,  //
+// and adding them multiplies the monomials, each in one instruction     //
+// with no loop or branch over the variables.  The top bit of each field //
+// is a guard bit, kept zero by checking the degrees before a product,   //
+// so a field never carries into the next:                               //
+//                                                                       //
+//     variables   1        2        3       4       5       6           //
+//     FIELD       64       32       21      16      12      10          //
+//     exponents   INT_MAX  INT_MAX  2^20-1  2^15-1  2^11-1  2^9-1       //
+//                                                                       //
+// +, - and == merge or compare the two sorted vectors in one pass.  *   //
+// maps both operands onto one variable by Kronecker substitution,       //
+//                                                                       //
+//     x^a y^b z^c  ->  t^(a Dy Dz + b Dz + c)                           //
+//                                                                       //
+// for Dy, Dz one more than the degrees of the product in y and z, which //
+// keeps the order and sends different monomials to different powers.    //
+// When those powers fit an int and polysparse::useHeap() says a dense   //
+// product of that length is cheaper, BasicPoly multiplies the two       //
+// images with its dense kernels; otherwise polysparse::multiply()       //
+// merges the products of terms in a heap, on the packed words.  With    //
+// one variable the image is the polynomial itself, so * is exactly      //
+// BasicPoly's, and evaluate() is too.                                   //
+//                                                                       //
+// << prints the terms by decreasing monomial, as Poly does, e.g.        //
+//                                                                       //
+//     +3x^2y -5yz^4 +7                                                  //
+//                                                                       //
+// and >> reads a coefficient and getVars() exponents per term, ended by //
+// -1 and getVars() exponents of -1, e.g. "3 2 1 0  -5 0 1 4  7 0 0 0    //
+// -1 -1 -1 -1" for the Poly above.                                      //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- T is a coefficient type instantiated in poly.cpp; products and   //
+//      sums wrap, or throw for CheckedInt, exactly as Poly's do         //
+//   -- operands of +, -, * and == need the same number of variables,    //
+//      else invalid_argument is thrown; an exponent that is negative    //
+//      or above maxExponent() throws domain_error, a product whose      //
+//      degree in some variable would be above it overflow_error         //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYMULTI_H
+#define POLYMULTI_H
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <stdexcept>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "poly.h"
+#include "polysparse.h"
+using namespace std;
+
+template <class T> class BasicMultiPoly;
+template <class T>
+ostream& operator<<(ostream&, const BasicMultiPoly<T>&);
+template <class T>
+istream& operator>>(istream&, BasicMultiPoly<T>&);
+
+template <class T>
+class BasicMultiPoly {
+//-----------------------------  <<  --------------------------------------
+// Print the terms by decreasing monomial, through format()
+friend ostream& operator<< <>(ostream&, const BasicMultiPoly&);
+
+//-----------------------------  >>  --------------------------------------
+// Read terms, each a coefficient then getVars() exponents, up to -1 and
+// getVars() exponents of -1
+// Preconditions:   none
+// Postconditions:  the terms read are set as by setCoeff(), the later of
+//       two with one monomial winning, all at once; malformed input or
+//       an exponent out of range sets failbit and leaves MultiPoly
+//       unchanged
+friend istream& operator>> <>(istream&, BasicMultiPoly&);
+
+public:
+//coefficient type
+typedef T Coeff;
+
+//most variables a MultiPoly can have, and their names
+static const int MAX_VARS = 6;
+static const char* names() { return "xyzuvw"; }
+
+//------------------------------ Term -------------------------------------
+// One coefficient and its monomial, packed as described above
+struct Term {
+   T coeff;
+   uint64_t exp;
+};
+
+//-------------------------- Constructor ----------------------------------
+// Preconditions:   1 <= vars <= MAX_VARS
+// Postconditions:  the zero polynomial, or the constant c, in vars
+//       variables; throws invalid_argument for another number of
+//       variables
+explicit BasicMultiPoly(int vars = 1) : varCount(vars) {
+   if (vars < 1 || vars > MAX_VARS)
+      throw invalid_argument("MultiPoly: 1 to 6 variables");
+}
+
+BasicMultiPoly(int vars, T c) : BasicMultiPoly(vars) {
+   if (c != T(0)) {
+      Term t = { c, 0 };
+      terms.push_back(t);
+   }
+}
+
+//-------------------------- Constructor ----------------------------------
+// The MultiPoly in x of a Poly
+// Preconditions:   none
+// Postconditions:  one variable, the nonzero terms of p
+explicit BasicMultiPoly(const BasicPoly<T>& p) : varCount(1) {
+   vector<typename BasicPoly<T>::Term> list;
+   p.getTerms(list);
+   fromUnivariate(list, NULL, NULL);
+}
+
+//------------------------------ toPoly -----------------------------------
+// Preconditions:   getVars() == 1
+// Postconditions:  returns the Poly with the same terms; throws
+//       invalid_argument for more variables
+BasicPoly<T> toPoly() const {
+   if (varCount != 1)
+      throw invalid_argument("MultiPoly toPoly: more than one variable");
+   long long weight[MAX_VARS] = { 1 };
+   return toUnivariate(weight);
+}
+
+//------------------------------ getVars ----------------------------------
+int getVars() const { return varCount; }
+
+//---------------------------- maxExponent --------------------------------
+// Largest exponent of a variable for getVars() variables
+int maxExponent() const {
+   int bits = fieldBits();
+   return (bits > 32) ? INT_MAX : (int)((1ull << (bits - 1)) - 1);
+}
+
+//----------------------------- termCount ---------------------------------
+int termCount() const { return (int)terms.size(); }
+
+//------------------------------ degree -----------------------------------
+// Highest exponent of variable var in any term; 0 for the zero
+// polynomial
+// Preconditions:   0 <= var < getVars()
+int degree(int var) const {
+   int highest = 0;
+   for (size_t k = 0; k < terms.size(); k++)
+      highest = max(highest, exponent(terms[k].exp, var));
+   return highest;
+}
+
+//------------------------------ getTerm ----------------------------------
+// The k-th term by increasing monomial
+// Preconditions:   0 <= k < termCount()
+// Postconditions:  returns its coefficient; exps holds its exponents
+T getTerm(int k, vector<int>& exps) const {
+   exps.resize(varCount);
+   for (int v = 0; v < varCount; v++)
+      exps[v] = exponent(terms[k].exp, v);
+   return terms[k].coeff;
+}
+
+//----------------------------- getCoeff ----------------------------------
+// Preconditions:   exps holds getVars() exponents
+// Postconditions:  returns the coefficient of their monomial, 0 if it
+//       is absent or out of range
+T getCoeff(const vector<int>& exps) const {
+   uint64_t m;
+   if (!tryPack(exps, m))
+      return T(0);
+   size_t pos = findTerm(m);
+   return (pos < terms.size() && terms[pos].exp == m) ? terms[pos].coeff
+                                                      : T(0);
+}
+
+//----------------------------- setCoeff ----------------------------------
+// Overwrite the term of a monomial
+// Preconditions:   exps holds getVars() exponents in [0, maxExponent()]
+// Postconditions:  the monomial's coefficient is c, the term being
+//       removed if c is 0; throws domain_error for a bad exponent
+void setCoeff(T c, const vector<int>& exps) {
+   uint64_t m = pack(exps);
+   size_t pos = findTerm(m);
+   bool found = pos < terms.size() && terms[pos].exp == m;
+   if (found && c == T(0)) {
+      terms.erase(terms.begin() + pos);
+   } else if (found) {
+      terms[pos].coeff = c;
+   } else if (c != T(0)) {
+      Term t = { c, m };
+      terms.insert(terms.begin() + pos, t);
+   }
+}
+
+//----------------------------- addCoeff ----------------------------------
+// Add c to the coefficient of a monomial
+// Preconditions:   as for setCoeff()
+// Postconditions:  as for setCoeff() with the sum
+void addCoeff(T c, const vector<int>& exps) {
+   setCoeff(getCoeff(exps) + c, exps);
+}
+
+//----------------------------- evaluate ----------------------------------
+// Value at a point
+// Preconditions:   point holds getVars() values; X can be made from T,
+//       and has a PolyCoeffTraits Word of the same size
+// Postconditions:  returns the value, computed in Word by Horner's rule
+//       in each variable in turn over the sorted terms; one variable is
+//       evaluated by BasicPoly::evaluate().  Throws invalid_argument for
+//       a point of another size
+template <class X>
+X evaluate(const vector<X>& point) const {
+   typedef typename PolyCoeffTraits<X>::Word W;
+   if ((int)point.size() != varCount)
+      throw invalid_argument("MultiPoly evaluate: wrong number of values");
+   if (varCount == 1)
+      return toPoly().evaluate(point[0]);
+   if (terms.empty())
+      return X(0);
+   W x[MAX_VARS];
+   for (int v = 0; v < varCount; v++)
+      x[v] = W(point[v]);
+   return X(hornerAt<W>(0, 0, (int)terms.size(), x));
+}
+
+//------------------------------  +  -  -----------------------------------
+// Sum or difference of two MultiPolys, merged by monomial in one pass
+// Preconditions:   rhs has the same number of variables
+BasicMultiPoly operator+(const BasicMultiPoly& rhs) const {
+   return combine<1>(rhs, "+");
+}
+
+BasicMultiPoly operator-(const BasicMultiPoly& rhs) const {
+   return combine<-1>(rhs, "-");
+}
+
+BasicMultiPoly& operator+=(const BasicMultiPoly& rhs) {
+   return *this = *this + rhs;
+}
+
+BasicMultiPoly& operator-=(const BasicMultiPoly& rhs) {
+   return *this = *this - rhs;
+}
+
+//------------------------------  *  --------------------------------------
+// Product of two MultiPolys
+// Preconditions:   rhs has the same number of variables, and the degree
+//       of the product in each is at most maxExponent()
+// Postconditions:  returns the product, by BasicPoly on the Kronecker
+//       images when a dense product is cheaper, or by the heap merge of
+//       polysparse.h on the packed terms; throws overflow_error if a
+//       degree would pass maxExponent()
+BasicMultiPoly operator*(const BasicMultiPoly& rhs) const {
+   typedef typename PolyCoeffTraits<T>::Word W;
+   requireSameVars(rhs, "*");
+   BasicMultiPoly product(varCount);
+   if (terms.empty() || rhs.terms.empty())
+      return product;
+
+   //bound[v] = degree of the product in v, plus 1; Kronecker weights
+   long long bound[MAX_VARS], weight[MAX_VARS];
+   for (int v = 0; v < varCount; v++) {
+      bound[v] = (long long)degree(v) + rhs.degree(v) + 1;
+      if (bound[v] - 1 > maxExponent())
+         throw overflow_error("MultiPoly *: exponent above maxExponent()");
+   }
+   long long size = 1;              //product of the bounds so far
+   bool fits = true;
+   for (int v = varCount - 1; v >= 0 && fits; v--) {
+      weight[v] = size;
+      size *= bound[v];
+      fits = size - 1 <= INT_MAX;
+   }
+
+   if (fits && (varCount == 1 ||
+         !polysparse::useHeap(terms.size(), rhs.terms.size(),
+                              image(terms.back().exp, weight) + 1,
+                              image(rhs.terms.back().exp, weight) + 1))) {
+      BasicPoly<T> a = toUnivariate(weight), b = rhs.toUnivariate(weight);
+      vector<typename BasicPoly<T>::Term> list;
+      (a * b).getTerms(list);
+      product.fromUnivariate(list, weight, bound);
+   } else {
+      polysparse::multiply<W>(&terms[0], (int)terms.size(),
+                              &rhs.terms[0], (int)rhs.terms.size(),
+                              product.terms);
+   }
+   return product;
+}
+
+BasicMultiPoly& operator*=(const BasicMultiPoly& rhs) {
+   return *this = *this * rhs;
+}
+
+//-----------------------------  ==  !=  ----------------------------------
+// Preconditions:   none
+// Postconditions:  true if both have the same variables and terms
+bool operator==(const BasicMultiPoly& rhs) const {
+   if (varCount != rhs.varCount || terms.size() != rhs.terms.size())
+      return false;
+   for (size_t k = 0; k < terms.size(); k++)
+      if (terms[k].exp != rhs.terms[k].exp ||
+            terms[k].coeff != rhs.terms[k].coeff)
+         return false;
+   return true;
+}
+
+bool operator!=(const BasicMultiPoly& rhs) const {
+   return !(*this == rhs);
+}
+
+//------------------------------ format -----------------------------------
+// Append MultiPoly to out as operator<< prints it
+void format(string& out) const {
+   char buffer[polytext::TERM_MAX];
+   for (size_t k = terms.size(); k-- > 0; ) {
+      typename polytext::Signed<T>::Int value =
+            polytext::Signed<T>::of(terms[k].coeff);
+      out += ' ';
+      if (value > 0)
+         out += '+';
+      out.append(buffer, polytext::writeInteger(buffer, value));
+      for (int v = 0; v < varCount; v++) {
+         int e = exponent(terms[k].exp, v);
+         if (e == 0)
+            continue;
+         out += names()[v];
+         if (e > 1) {
+            out += '^';
+            out.append(buffer, to_chars(buffer, buffer + polytext::TERM_MAX,
+                                        e).ptr);
+         }
+      }
+   }
+}
+
+private:
+//---------------------------- field layout -------------------------------
+int fieldBits() const { return 64 / varCount; }
+
+int shift(int var) const { return fieldBits() * (varCount - 1 - var); }
+
+uint64_t fieldMask() const {
+   return (fieldBits() == 64) ? ~0ull : (1ull << fieldBits()) - 1;
+}
+
+//exponent of variable var in the packed monomial m
+int exponent(uint64_t m, int var) const {
+   return (int)((m >> shift(var)) & fieldMask());
+}
+
+//pack exps into m; false if there are not getVars() of them in range
+bool tryPack(const vector<int>& exps, uint64_t& m) const {
+   if ((int)exps.size() != varCount)
+      return false;
+   m = 0;
+   for (int v = 0; v < varCount; v++) {
+      if (exps[v] < 0 || exps[v] > maxExponent())
+         return false;
+      m |= (uint64_t)exps[v] << shift(v);
+   }
+   return true;
+}
+
+uint64_t pack(const vector<int>& exps) const {
+   uint64_t m;
+   if (!tryPack(exps, m))
+      throw domain_error("MultiPoly: exponent out of range");
+   return m;
+}
+
+//index of the first term whose monomial is not below m
+size_t findTerm(uint64_t m) const {
+   size_t low = 0, high = terms.size();
+   while (low < high) {
+      size_t middle = (low + high) / 2;
+      if (terms[middle].exp < m)
+         low = middle + 1;
+      else
+         high = middle;
+   }
+   return low;
+}
+
+void requireSameVars(const BasicMultiPoly& rhs, const char* op) const {
+   if (varCount != rhs.varCount)
+      throw invalid_argument(string("MultiPoly ") + op +
+                             ": different numbers of variables");
+}
+
+//------------------------------ combine ----------------------------------
+// this + rhs (SIGN 1) or this - rhs (SIGN -1), merging the sorted terms
+template <int SIGN>
+BasicMultiPoly combine(const BasicMultiPoly& rhs, const char* op) const {
+   requireSameVars(rhs, op);
+   BasicMultiPoly out(varCount);
+   out.terms.reserve(terms.size() + rhs.terms.size());
+   size_t i = 0, j = 0;
+   while (i < terms.size() || j < rhs.terms.size()) {
+      Term t;
+      if (j == rhs.terms.size() ||
+            (i < terms.size() && terms[i].exp < rhs.terms[j].exp)) {
+         t = terms[i++];
+      } else {
+         t = rhs.terms[j++];
+         if (SIGN < 0)
+            t.coeff = T(0) - t.coeff;
+         if (i < terms.size() && terms[i].exp == t.exp)
+            t.coeff = terms[i++].coeff + t.coeff;
+      }
+      if (t.coeff != T(0))
+         out.terms.push_back(t);
+   }
+   return out;
+}
+
+//------------------------------- image -----------------------------------
+// Kronecker image of the packed monomial m under the weights
+long long image(uint64_t m, const long long* weight) const {
+   long long e = 0;
+   for (int v = 0; v < varCount; v++)
+      e += exponent(m, v) * weight[v];
+   return e;
+}
+
+//--------------------------- toUnivariate --------------------------------
+// The Poly in t of the Kronecker images of the terms, which keep their
+// order
+BasicPoly<T> toUnivariate(const long long* weight) const {
+   vector<typename BasicPoly<T>::Term> list(terms.size());
+   for (size_t k = 0; k < terms.size(); k++) {
+      list[k].coeff = terms[k].coeff;
+      list[k].exp = (int)image(terms[k].exp, weight);
+   }
+   BasicPoly<T> result;
+   result.setTerms(list, list.empty() ? 0 : list.back().exp);
+   return result;
+}
+
+//-------------------------- fromUnivariate -------------------------------
+// Overwrite the terms from sorted Poly terms, undoing the Kronecker
+// substitution with the weights and bounds; with one variable both may
+// be NULL, since the image is the identity
+void fromUnivariate(const vector<typename BasicPoly<T>::Term>& list,
+                    const long long* weight, const long long* bound) {
+   terms.resize(list.size());
+   for (size_t k = 0; k < list.size(); k++) {
+      uint64_t m = 0;
+      if (varCount == 1) {
+         m = (uint64_t)list[k].exp;
+      } else {
+         for (int v = 0; v < varCount; v++)
+            m |= (uint64_t)(list[k].exp / weight[v] % bound[v]) << shift(v);
+      }
+      terms[k].coeff = list[k].coeff;
+      terms[k].exp = m;
+   }
+}
+
+//------------------------------ hornerAt ---------------------------------
+// Value of terms[lo..hi), whose exponents of the variables before var
+// are all equal, at x with those variables left out: the terms are
+// grouped by their exponent of var and Horner's rule runs over the
+// groups, from the highest, each group being evaluated in the next
+// variable
+template <class W>
+W hornerAt(int var, int lo, int hi, const W* x) const {
+   if (var == varCount)
+      return W(terms[lo].coeff);
+   W acc(0);
+   int above = -1;                  //exponent of the group last added
+   for (int end = hi; end > lo; ) {
+      int e = exponent(terms[end - 1].exp, var);
+      int start = end - 1;
+      while (start > lo && exponent(terms[start - 1].exp, var) == e)
+         start--;
+      if (above >= 0)
+         acc = acc * polyseries::power(x[var], above - e);
+      acc = acc + hornerAt(var + 1, start, end, x);
+      above = e;
+      end = start;
+   }
+   return acc * polyseries::power(x[var], above);
+}
+
+int varCount;
+vector<Term> terms;                 //nonzero, by increasing monomial
+};
+
+//-----------------------------  <<  --------------------------------------
+template <class T>
+ostream& operator<<(ostream& out, const BasicMultiPoly<T>& rhs) {
+   string text;
+   rhs.format(text);
+   return out << text;
+}
+
+//-----------------------------  >>  --------------------------------------
+template <class T>
+istream& operator>>(istream& in, BasicMultiPoly<T>& rhs) {
+   typedef typename BasicMultiPoly<T>::Term Term;
+   int vars = rhs.getVars();
+   vector<Term> list;
+   vector<int> exps(vars);
+   string token;
+   for (;;) {
+      typename polytext::Digits<T>::Int value;
+      bool range = false, ended = true;
+      for (int k = 0; k <= vars; k++) {
+         int e = 0;
+         bool bad = !(in >> token);
+         if (!bad) {
+            const char* first = token.data();
+            const char* last = first + token.size();
+            const char* q = (k == 0)
+                  ? polytext::readInteger(first, last, value, range)
+                  : polytext::readInteger(first, last, e, range);
+            bad = (q != last) || range;
+         }
+         if (bad) {
+            in.setstate(ios::failbit);
+            return in;
+         }
+         if (k > 0) {
+            exps[k - 1] = e;
+            ended = ended && e == -1;
+         }
+      }
+      Term t;
+      t.coeff = T(value);
+      if (ended && t.coeff == T(-1))
+         break;
+      if (!rhs.tryPack(exps, t.exp)) {
+         in.setstate(ios::failbit);
+         return in;
+      }
+      list.push_back(t);
+   }
+   //sort by monomial, the last of equal ones winning, as setCoeff()
+   stable_sort(list.begin(), list.end(), [](const Term& a, const Term& b) {
+      return a.exp < b.exp;
+   });
+   BasicMultiPoly<T> result(vars);
+   for (size_t k = 0; k < list.size(); k++) {
+      if (k + 1 < list.size() && list[k + 1].exp == list[k].exp)
+         continue;
+      if (list[k].coeff != T(0))
+         result.terms.push_back(list[k]);
+   }
+   rhs = result;
+   return in;
+}
+
+//-------------------------- MultiPoly types ------------------------------
+typedef BasicMultiPoly<int> MultiPoly;
+typedef BasicMultiPoly<int64_t> MultiPoly64;
+template <uint32_t P> using ModMultiPoly = BasicMultiPoly<ModInt<P> >;
+
+#endif
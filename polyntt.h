@@ -0,0 +1,490 @@
+//-----------------------------------------------------------------------//
+// POLYNTT.H                                                             //
+//                                                                       //
+// Number theoretic transform (NTT) multiplication used by Poly          //
+//-----------------------------------------------------------------------//
+// The product of two int coefficient arrays is computed modulo three    //
+// primes of the form c*2^k + 1, where a length 2^k cyclic convolution   //
+// is a pointwise product between two transforms:                        //
+//                                                                       //
+//     2013265921 = 15*2^27 + 1      1811939329 = 27*2^26 + 1            //
+//      469762049 =  7*2^26 + 1                                          //
+//                                                                       //
+// The three residues of each coefficient are combined with the Chinese  //
+// remainder theorem (Garner's algorithm).  The primes multiply to about //
+// 2^90, while a product of int arrays of length n <= 2^26 has           //
+// coefficients of absolute value below n * 2^62 <= 2^88, so the signed  //
+// result is exact, and its low 32 bits match the schoolbook int loop    //
+// bit for bit.                                                          //
+//                                                                       //
+// A product of ModInt<P> arrays (see polycoeff.h) is needed modulo P    //
+// instead.  When P = c*2^k + 1 with 2^k at least the transform length,  //
+// one transform modulo P itself is enough; otherwise the exact product  //
+// is recombined from the three primes as above and reduced modulo P.    //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- runs on the CPU with no external libraries                       //
+//   -- residues are kept in Montgomery form, so a modular product is    //
+//      two integer multiplies and a shift                               //
+//   -- the forward transform is decimation in frequency and leaves its  //
+//      output in bit reversed order; the inverse transform is           //
+//      decimation in time and takes bit reversed input, so no           //
+//      reordering pass is needed between them                           //
+//   -- an operand's forward transforms can be kept as a Spectrum and    //
+//      handed to later products by it, which then skip them             //
+//   -- results longer than 2^MAX_LOG are not supported                  //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYNTT_H
+#define POLYNTT_H
+
+#include <stdint.h>
+#include <vector>
+using namespace std;
+
+namespace polyntt {
+
+//largest supported transform is 2^MAX_LOG
+const int MAX_LOG = 26;
+
+//Poly::multiply() uses NTT once both operands have this many terms
+const int NTT_THRESHOLD = 16384;
+
+//ModPoly products use NTT once both operands have this many terms: the
+//first when one transform modulo P does, the second when three do
+const int MOD_NTT_THRESHOLD = 192;
+const int MOD_CRT_THRESHOLD = 2048;
+
+//number of primes the residues are taken modulo
+const int PRIME_COUNT = 3;
+
+//the primes, and a primitive root of each
+const uint32_t PRIMES[PRIME_COUNT] = { 2013265921u, 1811939329u, 469762049u };
+const uint32_t ROOTS[PRIME_COUNT] = { 31u, 13u, 3u };
+
+//------------------------------ Montgomery -------------------------------
+// Modular arithmetic for an odd prime p < 2^31 in Montgomery form,
+// where x is stored as x * 2^32 mod p
+struct Montgomery {
+   uint32_t p;
+   uint32_t pInv;    //-p^-1 mod 2^32
+   uint32_t r2;      //2^64 mod p
+
+   explicit Montgomery(uint32_t prime) {
+      p = prime;
+      uint32_t inv = p;               //Newton iteration for p^-1 mod 2^32
+      for (int i = 0; i < 4; i++)
+         inv *= 2u - p * inv;
+      pInv = 0u - inv;
+      r2 = (uint32_t)((((unsigned __int128)1) << 64) % p);
+   }
+
+   uint32_t reduce(uint64_t t) const {
+      uint32_t m = (uint32_t)t * pInv;
+      uint32_t u = (uint32_t)((t + (uint64_t)m * p) >> 32);
+      return (u >= p) ? u - p : u;
+   }
+   uint32_t mul(uint32_t a, uint32_t b) const {
+      return reduce((uint64_t)a * b);
+   }
+   uint32_t add(uint32_t a, uint32_t b) const {
+      uint32_t s = a + b;
+      return (s >= p) ? s - p : s;
+   }
+   uint32_t sub(uint32_t a, uint32_t b) const {
+      return (a >= b) ? a - b : a + p - b;
+   }
+   uint32_t toMont(uint32_t a) const { return mul(a, r2); }
+   uint32_t fromMont(uint32_t a) const { return reduce(a); }
+   uint32_t pow(uint32_t base, uint64_t e) const {    //Montgomery form
+      uint32_t result = toMont(1);
+      while (e > 0) {
+         if (e & 1)
+            result = mul(result, base);
+         base = mul(base, base);
+         e >>= 1;
+      }
+      return result;
+   }
+};
+
+//------------------------------ buildRoots -------------------------------
+// Fill the twiddle table for transforms of length n
+// Preconditions:   n is a power of 2, 2 <= n <= 2^MAX_LOG
+// Postconditions:  roots[len + j] = w^j for every power of 2 len < n and
+//       0 <= j < len, where w is a primitive 2*len-th root of unity (or
+//       its inverse), in Montgomery form
+inline void buildRoots(const Montgomery& m, uint32_t g, int n, bool inverse,
+                       vector<uint32_t>& roots) {
+   roots.assign(n, 0);
+   for (int len = 1; len < n; len <<= 1) {
+      uint32_t w = m.pow(m.toMont(g), (m.p - 1) / (2 * (uint64_t)len));
+      if (inverse)
+         w = m.pow(w, m.p - 2);
+      uint32_t cur = m.toMont(1);
+      for (int j = 0; j < len; j++) {
+         roots[len + j] = cur;
+         cur = m.mul(cur, w);
+      }
+   }
+}
+
+//------------------------------ forward ----------------------------------
+// Decimation in frequency transform, natural order in, bit reversed out
+// Preconditions:   n is a power of 2, roots built for n, a in Montgomery
+//       form
+// Postconditions:  a holds the transform
+inline void forward(uint32_t* a, int n, const uint32_t* roots,
+                    const Montgomery& m) {
+   for (int len = n >> 1; len >= 1; len >>= 1) {
+      for (int i = 0; i < n; i += 2 * len) {
+         uint32_t* x = a + i;
+         uint32_t* y = x + len;
+         const uint32_t* w = roots + len;
+         for (int j = 0; j < len; j++) {
+            uint32_t u = x[j];
+            uint32_t v = y[j];
+            x[j] = m.add(u, v);
+            y[j] = m.mul(m.sub(u, v), w[j]);
+         }
+      }
+   }
+}
+
+//------------------------------ inverse ----------------------------------
+// Decimation in time transform, bit reversed in, natural order out
+// Preconditions:   n is a power of 2, inverse roots built for n
+// Postconditions:  a holds n times the inverse transform
+inline void inverse(uint32_t* a, int n, const uint32_t* roots,
+                    const Montgomery& m) {
+   for (int len = 1; len < n; len <<= 1) {
+      for (int i = 0; i < n; i += 2 * len) {
+         uint32_t* x = a + i;
+         uint32_t* y = x + len;
+         const uint32_t* w = roots + len;
+         for (int j = 0; j < len; j++) {
+            uint32_t u = x[j];
+            uint32_t v = m.mul(y[j], w[j]);
+            x[j] = m.add(u, v);
+            y[j] = m.sub(u, v);
+         }
+      }
+   }
+}
+
+//------------------------------ transformSize ----------------------------
+// Smallest power of 2 that holds a product of length outLen
+// Preconditions:   outLen >= 1
+// Postconditions:  returns the transform length, or 0 if outLen is longer
+//       than 2^MAX_LOG
+inline int transformSize(long long outLen) {
+   long long n = 2;
+   while (n < outLen)
+      n <<= 1;
+   return (n > (1LL << MAX_LOG)) ? 0 : (int)n;
+}
+
+//------------------------------- Buffers ---------------------------------
+// Scratch vectors of a product: twiddles, transforms, CRT residues, and
+// the int operands and result of a caller such as Poly's mulNtt().  A
+// caller that multiplies many times keeps one Buffers, reserved for its
+// longest product, so that no product allocates
+struct Buffers {
+   vector<uint32_t> roots, fa, fb, r1, r2, r3, result;
+   vector<int> va, vb;
+
+   //room for products of up to outLen coefficients
+   void reserve(long long outLen) {
+      int n = transformSize(outLen);
+      roots.reserve(n);
+      fa.reserve(n);
+      fb.reserve(n);
+      vector<uint32_t>* residues[] = { &r1, &r2, &r3, &result };
+      for (int i = 0; i < 4; i++)
+         residues[i]->reserve(outLen);
+      va.reserve(outLen);
+      vb.reserve(outLen);
+   }
+};
+
+//------------------------------ toResidue --------------------------------
+// Reduce an int into [0, p), in Montgomery form
+inline uint32_t toResidue(int x, const Montgomery& m) {
+   long long r = x % (long long)m.p;
+   if (r < 0)
+      r += m.p;
+   return m.toMont((uint32_t)r);
+}
+
+//------------------------------ Spectrum ---------------------------------
+// Forward transforms of one operand b, as the products of length n by
+// multiplyMod() or multiply() would make them: one modulo p alone, or
+// one modulo each of the PRIMES.  A caller that multiplies by the same
+// b again keeps them to skip its transforms (see polycache.h)
+struct Spectrum {
+   int n;                                 //transform length
+   int length;                            //nb
+   vector<vector<uint32_t> > transforms;  //one per prime
+
+   Spectrum() : n(0), length(0) {}
+
+   //bytes held by the transforms
+   size_t bytes() const {
+      return transforms.size() * (size_t)n * sizeof(uint32_t);
+   }
+};
+
+//-------------------------- multiplyModPrime -----------------------------
+// Multiply two int arrays modulo the prime of m, whose multiplicative
+// group has the generator root
+// Preconditions:   na >= 1, nb >= 1, n = transformSize(na + nb - 1)
+//       divides m.p - 1, out has room for na + nb - 1; bTransform is NULL
+//       or the forward transform of b modulo m.p for length n
+// Postconditions:  out holds the residues of the product, in [0, p) and
+//       not in Montgomery form; the twiddles and transforms are kept in
+//       buffers.  A given bTransform is used as it is
+inline void multiplyModPrime(const Montgomery& m, uint32_t root,
+                             const int* a, int na, const int* b, int nb,
+                             int n, uint32_t* out, Buffers& buffers,
+                             const uint32_t* bTransform = NULL) {
+   vector<uint32_t>& roots = buffers.roots;
+   vector<uint32_t>& fa = buffers.fa;
+   vector<uint32_t>& fb = buffers.fb;
+   bool square = (a == b && na == nb && bTransform == NULL);
+
+   fa.assign(n, 0);
+
+   buildRoots(m, root, n, false, roots);
+   for (int i = 0; i < na; i++)
+      fa[i] = toResidue(a[i], m);
+   forward(&fa[0], n, &roots[0], m);
+   if (!square && bTransform == NULL) {
+      fb.assign(n, 0);
+      for (int i = 0; i < nb; i++)
+         fb[i] = toResidue(b[i], m);
+      forward(&fb[0], n, &roots[0], m);
+      bTransform = &fb[0];
+   }
+
+   const uint32_t* other = square ? &fa[0] : bTransform;
+   for (int i = 0; i < n; i++)
+      fa[i] = m.mul(fa[i], other[i]);
+
+   buildRoots(m, root, n, true, roots);
+   inverse(&fa[0], n, &roots[0], m);
+
+   //scale by n^-1 and leave Montgomery form in one multiply:
+   //reduce(x * toMont(n^-1)) == x * n^-1 in Montgomery form, and one more
+   //reduce() leaves it; fold both into a multiply by plain n^-1
+   uint32_t nInv = m.pow(m.toMont((uint32_t)n), m.p - 2);
+   nInv = m.fromMont(nInv);
+   for (int i = na + nb - 2; i >= 0; i--)
+      out[i] = m.mul(fa[i], nInv);
+}
+
+//with its own Buffers
+inline void multiplyModPrime(const Montgomery& m, uint32_t root,
+                             const int* a, int na, const int* b, int nb,
+                             int n, uint32_t* out) {
+   Buffers buffers;
+   multiplyModPrime(m, root, a, na, b, nb, n, out, buffers);
+}
+
+//------------------------------ transform --------------------------------
+// Forward transform of one int array modulo the prime of m
+// Preconditions:   1 <= nb <= n, n a power of 2 dividing m.p - 1
+// Postconditions:  out holds the transform, as multiplyModPrime() makes
+//       it for b
+inline void transform(const Montgomery& m, uint32_t root, const int* b,
+                      int nb, int n, vector<uint32_t>& out,
+                      Buffers& buffers) {
+   out.assign(n, 0);
+   buildRoots(m, root, n, false, buffers.roots);
+   for (int i = 0; i < nb; i++)
+      out[i] = toResidue(b[i], m);
+   forward(&out[0], n, &buffers.roots[0], m);
+}
+
+//------------------------------- Garner ----------------------------------
+// Recombines the residues modulo the three PRIMES into one integer
+struct Garner {
+   Montgomery m2, m3;
+   uint32_t p1InvMod2;     //p1^-1 mod p2
+   uint32_t p12InvMod3;    //(p1*p2)^-1 mod p3
+
+   Garner() : m2(PRIMES[1]), m3(PRIMES[2]) {
+      const uint64_t p1 = PRIMES[0], p2 = PRIMES[1], p3 = PRIMES[2];
+      p1InvMod2 = m2.pow(m2.toMont((uint32_t)(p1 % p2)), p2 - 2);
+      p12InvMod3 = m3.pow(m3.toMont((uint32_t)(p1 * p2 % p3)), p3 - 2);
+   }
+
+   //the x in [0, p1*p2*p3) with x = x1 mod p1, r2 mod p2, r3 mod p3,
+   //as x1 + y2*p1 + y3*p1*p2
+   unsigned __int128 combine(uint32_t x1, uint32_t r2, uint32_t r3) const {
+      const uint64_t p1 = PRIMES[0], p2 = PRIMES[1], p3 = PRIMES[2];
+      //y2 = (r2 - x1) / p1 mod p2
+      uint32_t t = m2.sub(r2, (uint32_t)(x1 % p2));
+      uint32_t y2 = m2.mul(t, p1InvMod2);           //plain * Mont == plain
+      //y3 = (r3 - x1 - y2*p1) / (p1*p2) mod p3
+      uint64_t sub = (x1 + (uint64_t)y2 * p1) % p3;
+      uint32_t s = m3.sub(r3, (uint32_t)sub);
+      uint32_t y3 = m3.mul(s, p12InvMod3);
+      return (unsigned __int128)x1 + (uint64_t)y2 * p1 +
+             (unsigned __int128)(p1 * p2) * y3;
+   }
+};
+
+//---------------------------- multiplyCrt --------------------------------
+// Multiply two int arrays modulo each of the three PRIMES
+// Preconditions:   na >= 1, nb >= 1, transformSize(na + nb - 1) != 0,
+//       each ri has room for na + nb - 1; sb is NULL or b's Spectrum
+//       with a transform per prime for that length
+// Postconditions:  ri holds the residues modulo PRIMES[i]
+inline void multiplyCrt(const int* a, int na, const int* b, int nb,
+                        uint32_t* r1, uint32_t* r2, uint32_t* r3,
+                        Buffers& buffers, const Spectrum* sb = NULL) {
+   int n = transformSize((long long)na + nb - 1);
+   uint32_t* residues[PRIME_COUNT] = { r1, r2, r3 };
+   for (int i = 0; i < PRIME_COUNT; i++)
+      multiplyModPrime(Montgomery(PRIMES[i]), ROOTS[i], a, na, b, nb, n,
+                       residues[i], buffers,
+                       (sb != NULL) ? &sb->transforms[i][0] : NULL);
+}
+
+//with its own Buffers
+inline void multiplyCrt(const int* a, int na, const int* b, int nb,
+                        uint32_t* r1, uint32_t* r2, uint32_t* r3) {
+   Buffers buffers;
+   multiplyCrt(a, na, b, nb, r1, r2, r3, buffers);
+}
+
+//------------------------------ multiply ---------------------------------
+// Multiply two int arrays exactly, keeping the low 32 bits of each
+// coefficient
+// Preconditions:   na >= 1, nb >= 1, transformSize(na + nb - 1) != 0,
+//       out has room for na + nb - 1
+// Postconditions:  out holds the product, identical to the wrapping
+//       schoolbook int loop.  The scratch vectors are taken from buffers,
+//       and sb, if not NULL, is b's Spectrum for this product
+inline void multiply(const int* a, int na, const int* b, int nb, int* out,
+                     Buffers& buffers, const Spectrum* sb = NULL) {
+   int outLen = na + nb - 1;
+   const uint64_t p1 = PRIMES[0], p2 = PRIMES[1], p3 = PRIMES[2];
+   unsigned __int128 bigM = (unsigned __int128)(p1 * p2) * p3;
+   unsigned __int128 half = bigM / 2;
+
+   vector<uint32_t>& r1 = buffers.r1;
+   vector<uint32_t>& r2 = buffers.r2;
+   vector<uint32_t>& r3 = buffers.r3;
+   r1.resize(outLen);
+   r2.resize(outLen);
+   r3.resize(outLen);
+   multiplyCrt(a, na, b, nb, &r1[0], &r2[0], &r3[0], buffers, sb);
+   Garner garner;
+   for (int i = 0; i < outLen; i++) {
+      unsigned __int128 x = garner.combine(r1[i], r2[i], r3[i]);
+      if (x > half)
+         x -= bigM;                 //negative, wraps modulo 2^128
+      out[i] = (int)(uint32_t)x;
+   }
+}
+
+//with its own Buffers
+inline void multiply(const int* a, int na, const int* b, int nb, int* out) {
+   Buffers buffers;
+   multiply(a, na, b, nb, out, buffers);
+}
+
+//---------------------------- primitiveRoot ------------------------------
+// Find a generator of the multiplicative group modulo a prime
+// Preconditions:   p is an odd prime < 2^31
+// Postconditions:  returns the smallest g whose order modulo p is p - 1
+inline uint32_t primitiveRoot(uint32_t p) {
+   vector<uint32_t> factors;           //distinct primes dividing p - 1
+   uint32_t rest = p - 1;
+   for (uint32_t q = 2; q * q <= rest; q++) {
+      if (rest % q == 0) {
+         factors.push_back(q);
+         while (rest % q == 0)
+            rest /= q;
+      }
+   }
+   if (rest > 1)
+      factors.push_back(rest);
+
+   Montgomery m(p);
+   uint32_t one = m.toMont(1);
+   for (uint32_t g = 2; ; g++) {
+      size_t i = 0;
+      while (i < factors.size() &&
+             m.pow(m.toMont(g), (p - 1) / factors[i]) != one)
+         i++;
+      if (i == factors.size())
+         return g;
+   }
+}
+
+//----------------------------- multiplyMod -------------------------------
+// Multiply two arrays of residues modulo an odd prime p
+// Preconditions:   na >= 1, nb >= 1, transformSize(na + nb - 1) != 0,
+//       0 <= a[i], b[i] < p < 2^31, root == primitiveRoot(p), out has
+//       room for na + nb - 1
+// Postconditions:  out holds the product modulo p, in [0, p).  If the
+//       transform length divides p - 1 (e.g. p = 998244353 = 119*2^23 + 1)
+//       one transform modulo p is enough; otherwise the exact product,
+//       below n * p^2 < 2^88, is recombined from the three PRIMES.  The
+//       scratch vectors are taken from buffers, and sb, if not NULL, is
+//       b's Spectrum for this product and modulus
+inline void multiplyMod(const int* a, int na, const int* b, int nb,
+                        uint32_t p, uint32_t root, uint32_t* out,
+                        Buffers& buffers, const Spectrum* sb = NULL) {
+   int outLen = na + nb - 1;
+   int n = transformSize(outLen);
+   if ((p - 1) % (uint32_t)n == 0) {
+      multiplyModPrime(Montgomery(p), root, a, na, b, nb, n, out, buffers,
+                       (sb != NULL) ? &sb->transforms[0][0] : NULL);
+      return;
+   }
+   vector<uint32_t>& r1 = buffers.r1;
+   vector<uint32_t>& r2 = buffers.r2;
+   vector<uint32_t>& r3 = buffers.r3;
+   r1.resize(outLen);
+   r2.resize(outLen);
+   r3.resize(outLen);
+   multiplyCrt(a, na, b, nb, &r1[0], &r2[0], &r3[0], buffers, sb);
+   Garner garner;
+   for (int i = 0; i < outLen; i++)
+      out[i] = (uint32_t)(garner.combine(r1[i], r2[i], r3[i]) % p);
+}
+
+//with its own Buffers
+inline void multiplyMod(const int* a, int na, const int* b, int nb,
+                        uint32_t p, uint32_t root, uint32_t* out) {
+   Buffers buffers;
+   multiplyMod(a, na, b, nb, p, root, out, buffers);
+}
+
+//---------------------------- makeSpectrum -------------------------------
+// The forward transforms of b for products of transform length n
+// Preconditions:   1 <= nb <= n, n = transformSize() of the products; p
+//       and root as for multiplyMod(), or p == 0 for multiply()
+// Postconditions:  s holds b's transforms: modulo p alone if n divides
+//       p - 1, else modulo each of the PRIMES
+inline void makeSpectrum(const int* b, int nb, int n, uint32_t p,
+                         uint32_t root, Spectrum& s, Buffers& buffers) {
+   s.n = n;
+   s.length = nb;
+   if (p != 0 && (p - 1) % (uint32_t)n == 0) {
+      s.transforms.resize(1);
+      transform(Montgomery(p), root, b, nb, n, s.transforms[0], buffers);
+      return;
+   }
+   s.transforms.resize(PRIME_COUNT);
+   for (int i = 0; i < PRIME_COUNT; i++)
+      transform(Montgomery(PRIMES[i]), ROOTS[i], b, nb, n, s.transforms[i],
+                buffers);
+}
+
+} // namespace polyntt
+
+#endif
@@ -0,0 +1,323 @@
+//-----------------------------------------------------------------------//
+// POLYSERIES.H                                                          //
+//                                                                       //
+// Truncated power series kernels used by Poly                           //
+//-----------------------------------------------------------------------//
+// A Poly used as a power series is only known modulo x^n, so a product  //
+// needs only its low n coefficients (mullow) or, for a quotient, its    //
+// high ones (mulhigh).  The series functions to n terms are found by    //
+// Newton iteration, each step doubling the number k of correct terms:   //
+//                                                                       //
+//   -- inverse:  b = b - b (a b - 1)                                    //
+//   -- log:      log a = integral of a' / a,  a[0] = 1                  //
+//   -- exp:      b = b (1 + a - log b),       a[0] = 0                  //
+//   -- sqrt:     b = b + (a - b^2) / (2 b),   a[0] a nonzero square     //
+//                                                                       //
+// The correction of a step is 0 modulo x^k, so only the coefficients    //
+// from k to 2k are computed, with products of k by k terms, and written //
+// after the first k in place.  Each function takes O(M(n)) time for     //
+// M(n) the time of a product.                                           //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- W is a field word with inverse() and value() (ModInt), n < p     //
+//   -- Mul multiplies two W arrays like polymul::multiply()             //
+//   -- the series functions take their scratch vectors from a           //
+//      Workspace, sized once for the largest precision, so the steps    //
+//      of a whole chain (exp calls log, which calls inverse) reuse the  //
+//      same buffers.  A Mul that allocates, e.g. for the transforms of  //
+//      an NTT product, should keep its own scratch too, as Poly's does  //
+//   -- below MULLOW_SCHOOLBOOK terms, mullow() and mulhigh() multiply   //
+//      only the coefficient pairs that reach the result                 //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYSERIES_H
+#define POLYSERIES_H
+
+#include <algorithm>
+#include <vector>
+using namespace std;
+
+namespace polyseries {
+
+//mullow() and mulhigh() of a shorter operand than this skip the pairs
+//outside the result instead of calling Mul
+const int MULLOW_SCHOOLBOOK = 32;
+
+//--------------------------------- power ---------------------------------
+// x^e by repeated squaring; x is not squared past the last bit of e, so
+// a CheckedInt power throws only if x^e itself overflows
+// Preconditions:   e >= 0
+// Postconditions:  returns x^e, with x^0 == 1
+template <class W>
+W power(W x, long long e) {
+   W result(1);
+   while (e > 0) {
+      if (e & 1)
+         result *= x;
+      e >>= 1;
+      if (e > 0)
+         x *= x;
+   }
+   return result;
+}
+
+//------------------------------ squareRoot -------------------------------
+// Square root modulo the prime p of W, by the Tonelli-Shanks algorithm
+// Preconditions:   none
+// Postconditions:  returns false if x is not a square; else root * root
+//       == x
+template <class W>
+bool squareRoot(W x, W& root) {
+   root = W(0);
+   if (x == W(0))
+      return true;
+   long long p = (long long)(W(0) - W(1)).value() + 1;
+   if (power(x, (p - 1) / 2) != W(1))
+      return false;
+   long long q = p - 1;                //p - 1 = q 2^s with q odd
+   int s = 0;
+   for (; q % 2 == 0; q /= 2)
+      s++;
+   W z(2);
+   while (power(z, (p - 1) / 2) == W(1))
+      z += W(1);
+   W c = power(z, q), t = power(x, q);
+   root = power(x, (q + 1) / 2);
+   while (t != W(1)) {
+      int i = 0;
+      for (W t2 = t; t2 != W(1); t2 *= t2)
+         i++;
+      W b = c;
+      for (int j = 0; j < s - i - 1; j++)
+         b *= b;
+      s = i;
+      c = b * b;
+      t *= c;
+      root *= b;
+   }
+   return true;
+}
+
+//-------------------------------- mullow ---------------------------------
+// The low n coefficients of a * b
+// Preconditions:   na, nb >= 0; out has room for n and does not overlap
+//       a or b
+// Postconditions:  out[0..n) holds (a * b) mod x^n, zero padded.  Only
+//       the first n terms of each operand are multiplied, in product
+//       when Mul is called
+template <class W, class Mul>
+void mullow(const W* a, int na, const W* b, int nb, int n, W* out,
+            vector<W>& product, Mul mul) {
+   na = min(na, n);
+   nb = min(nb, n);
+   fill(out, out + n, W(0));
+   if (na == 0 || nb == 0)
+      return;
+   if (min(na, nb) < MULLOW_SCHOOLBOOK) {
+      for (int i = 0; i < na; i++) {
+         W c = a[i];
+         int last = min(nb, n - i);
+         for (int j = 0; j < last; j++)
+            out[i + j] += c * b[j];
+      }
+      return;
+   }
+   product.resize(na + nb - 1);
+   mul(a, na, b, nb, &product[0]);
+   int len = min(n, na + nb - 1);
+   copy(product.begin(), product.begin() + len, out);
+}
+
+//-------------------------------- mulhigh --------------------------------
+// The coefficients of a * b from x^k up
+// Preconditions:   na, nb >= 1, 0 <= k; out has room for na + nb - 1 - k
+//       (if positive) and does not overlap a or b
+// Postconditions:  out holds (a * b) div x^k.  A short operand skips the
+//       pairs below x^k, which is most of them when k is near the top
+template <class W, class Mul>
+void mulhigh(const W* a, int na, const W* b, int nb, int k, W* out,
+             vector<W>& product, Mul mul) {
+   int len = na + nb - 1 - k;
+   if (len <= 0)
+      return;
+   if (min(na, nb) < MULLOW_SCHOOLBOOK) {
+      fill(out, out + len, W(0));
+      for (int i = 0; i < na; i++) {
+         W c = a[i];
+         for (int j = max(0, k - i); j < nb; j++)
+            out[i + j - k] += c * b[j];
+      }
+      return;
+   }
+   product.resize(na + nb - 1);
+   mul(a, na, b, nb, &product[0]);
+   copy(product.begin() + k, product.end(), out);
+}
+
+//------------------------------ Workspace --------------------------------
+// Scratch vectors of the series functions, each used by one of them, so
+// that a function may call another on the same Workspace
+template <class W>
+struct Workspace {
+   vector<W> product;      //full products of mullow() and mulhigh()
+   vector<W> error;        //inverse(): a b, whose high half is the error
+   vector<W> inv;          //log(): 1 / a; sqrt(): 1 / b
+   vector<W> slope;        //log(): a'
+   vector<W> quotient;     //log(): a' / a; sqrt(): the correction
+   vector<W> reciprocals;  //log(): 1 / i
+   vector<W> logs;         //exp(): log b
+   vector<W> step;         //exp(): 1 + a - log b; sqrt(): b^2
+
+   //reserve every vector for series of up to n terms
+   explicit Workspace(int n) {
+      n = max(n, 1);
+      product.reserve(2 * n);
+      vector<W>* vectors[] = { &error, &inv, &slope, &quotient, &logs,
+                              &step };
+      for (int i = 0; i < 6; i++)
+         vectors[i]->reserve(n);
+      reciprocals.reserve(n + 1);
+   }
+};
+
+//---------------------------- extendInverse ------------------------------
+// Newton steps of the power series inverse of a, from out[0] to n terms
+// Preconditions:   na >= 1, out[0] * a[0] == 1, n >= 1; out has room for
+//       n and does not overlap a
+// Postconditions:  out[0..n) holds b with a * b == 1 mod x^n.  With
+//       a b = 1 + x^k e after k terms, b[k..2k) = -(b e) mod x^k.  Needs
+//       no division, so any ring W will do
+template <class W, class Mul>
+void extendInverse(const W* a, int na, int n, W* out, Workspace<W>& work,
+                   Mul mul) {
+   for (int k = 1; k < n; k *= 2) {
+      int k2 = min(2 * k, n);
+      vector<W>& e = work.error;
+      e.resize(k2);
+      mullow(a, na, out, k, k2, &e[0], work.product, mul);
+      mullow(out, k, &e[k], k2 - k, k2 - k, out + k, work.product, mul);
+      for (int i = k; i < k2; i++)
+         out[i] = W(0) - out[i];
+   }
+}
+
+//------------------------------- inverse ---------------------------------
+// Power series inverse of a, to n terms
+// Preconditions:   na >= 1, a[0] != 0, n >= 1; out has room for n and
+//       does not overlap a
+// Postconditions:  out[0..n) holds b with a * b == 1 mod x^n
+template <class W, class Mul>
+void inverse(const W* a, int na, int n, W* out, Workspace<W>& work,
+             Mul mul) {
+   out[0] = a[0].inverse();
+   extendInverse(a, na, n, out, work, mul);
+}
+
+//----------------------------- reciprocals -------------------------------
+// 1 / i for i < n in work.reciprocals, from one inverse: with
+// f[i] = 1 * 2 * ... * i, 1 / i = f[i - 1] / f[i]
+// Preconditions:   n < p
+template <class W>
+void reciprocals(int n, Workspace<W>& work) {
+   vector<W>& r = work.reciprocals;
+   if ((int)r.size() >= n)
+      return;
+   r.resize(n);
+   r[0] = W(0);
+   if (n == 1)
+      return;
+   r[1] = W(1);
+   for (int i = 2; i < n; i++)
+      r[i] = r[i - 1] * W(i);       //f[i], for now
+   W f = r[n - 1].inverse();         //1 / f[i], going down
+   for (int i = n - 1; i >= 2; i--) {
+      W fi = f;
+      f *= W(i);
+      r[i] = fi * r[i - 1];
+   }
+}
+
+//--------------------------------- log -----------------------------------
+// Power series logarithm of a, to n terms
+// Preconditions:   na >= 1, a[0] == 1, 1 <= n < p; out has room for n and
+//       does not overlap a
+// Postconditions:  out[0..n) holds log a mod x^n, with out[0] == 0
+template <class W, class Mul>
+void log(const W* a, int na, int n, W* out, Workspace<W>& work, Mul mul) {
+   out[0] = W(0);
+   int m = n - 1;                 //terms of a' / a
+   int ns = min(na, n) - 1;       //terms of a' that reach them
+   if (m == 0)
+      return;
+   if (ns <= 0) {
+      fill(out + 1, out + n, W(0));
+      return;
+   }
+   work.slope.resize(ns);
+   for (int i = 0; i < ns; i++)
+      work.slope[i] = a[i + 1] * W(i + 1);
+   work.inv.resize(m);
+   inverse(a, na, m, &work.inv[0], work, mul);
+   work.quotient.resize(m);
+   mullow(&work.slope[0], ns, &work.inv[0], m, m, &work.quotient[0],
+          work.product, mul);
+   reciprocals(n, work);
+   for (int i = 1; i < n; i++)
+      out[i] = work.quotient[i - 1] * work.reciprocals[i];
+}
+
+//--------------------------------- exp -----------------------------------
+// Power series exponential of a, to n terms
+// Preconditions:   na >= 1, a[0] == 0, 1 <= n < p; out has room for n and
+//       does not overlap a
+// Postconditions:  out[0..n) holds exp a mod x^n.  1 + a - log b is
+//       1 + x^k h after k terms, so b[k..2k) = (b h) mod x^k
+template <class W, class Mul>
+void exp(const W* a, int na, int n, W* out, Workspace<W>& work, Mul mul) {
+   out[0] = W(1);
+   for (int k = 1; k < n; k *= 2) {
+      int k2 = min(2 * k, n);
+      work.logs.resize(k2);
+      log(out, k, k2, &work.logs[0], work, mul);
+      vector<W>& h = work.step;
+      h.resize(k2 - k);
+      for (int i = k; i < k2; i++)
+         h[i - k] = ((i < na) ? a[i] : W(0)) - work.logs[i];
+      mullow(out, k, &h[0], k2 - k, k2 - k, out + k, work.product, mul);
+   }
+}
+
+//--------------------------------- sqrt ----------------------------------
+// Power series square root of a, to n terms
+// Preconditions:   na >= 1, n >= 1; out has room for n and does not
+//       overlap a
+// Postconditions:  returns false if a[0] is not a nonzero square.  Else
+//       out[0..n) holds b with b * b == a mod x^n, and b[0] the root of
+//       a[0] squareRoot() finds.  a - b^2 is x^k d after k terms, so
+//       b[k..2k) = (d / 2b) mod x^k
+template <class W, class Mul>
+bool sqrt(const W* a, int na, int n, W* out, Workspace<W>& work, Mul mul) {
+   if (a[0] == W(0) || !squareRoot(a[0], out[0]))
+      return false;
+   W half = W(2).inverse();
+   for (int k = 1; k < n; k *= 2) {
+      int k2 = min(2 * k, n);
+      vector<W>& square = work.step;
+      square.resize(k2);
+      mullow(out, k, out, k, k2, &square[0], work.product, mul);
+      for (int i = k; i < k2; i++)
+         square[i] = ((i < na) ? a[i] : W(0)) - square[i];
+      work.inv.resize(k2 - k);
+      inverse(out, k, k2 - k, &work.inv[0], work, mul);
+      work.quotient.resize(k2 - k);
+      mullow(&square[k], k2 - k, &work.inv[0], k2 - k, k2 - k,
+             &work.quotient[0], work.product, mul);
+      for (int i = k; i < k2; i++)
+         out[i] = work.quotient[i - k] * half;
+   }
+   return true;
+}
+
+} // namespace polyseries
+
+#endif
@@ -0,0 +1,222 @@
+//-----------------------------------------------------------------------//
+// POLYSPARSE.H                                                          //
+//                                                                       //
+// Sparse polynomial multiplication kernel used by Poly                  //
+//-----------------------------------------------------------------------//
+// The product of a with na terms by b with nb terms, both sorted by     //
+// increasing exponent, is the merge of the na rows                      //
+//                                                                       //
+//     a[i] * b[0], a[i] * b[1], ..., a[i] * b[nb-1]                     //
+//                                                                       //
+// each already in exponent order.  As in Johnson's algorithm, a heap    //
+// holds the next pair (i, j) of each row, keyed on the exponent of      //
+// a[i] * b[j]; pairs are taken off in increasing exponent order, so     //
+// the terms of the product are summed and written out one at a time,    //
+// in order, with no sort.  As in Monagan and Pearce's version, row i+1  //
+// enters the heap only once row i has taken off (i, 0), since no pair   //
+// of it can come first before then.  That takes                         //
+//                                                                       //
+//     O(na nb log min(na, nb))  time                                    //
+//     O(min(na, nb))            memory, besides the product             //
+//                                                                       //
+// against the degree of the product for a dense array.                  //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- Term is a struct with a coefficient coeff and an exponent exp,   //
+//      an int or a monomial packed into an integer (see polymulti.h),   //
+//      whose sum is the exponent of a product; W is the word of         //
+//      polymul.h the coefficients are read as, so products and sums     //
+//      wrap exactly like a dense kernel                                 //
+//   -- exponents of the product fit in the exponent type; multiply()    //
+//      throws overflow_error before merging if the highest would not    //
+//   -- useHeap() estimates both costs, in dense multiply-adds, for      //
+//      callers that can take either route                               //
+//   -- multiplyHigh() merges only the pairs from a given exponent up,   //
+//      for the high part of a product                                   //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYSPARSE_H
+#define POLYSPARSE_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "polymul.h"
+using namespace std;
+
+namespace polysparse {
+
+//one heap step costs about this many dense multiply-adds per level of
+//the heap
+const double HEAP_STEP_COST = 2;
+
+//--------------------------------- Pair ----------------------------------
+// Heap entry: the pair a[i] * b[j], whose exponent is exp
+template <class E>
+struct Pair {
+   E exp;
+   int i;
+   int j;
+};
+
+//the heap is a min-heap on exp
+template <class E>
+bool pairAfter(const Pair<E>& x, const Pair<E>& y) {
+   return x.exp > y.exp;
+}
+
+//------------------------------ replaceTop -------------------------------
+// Put p in place of the smallest pair and sift it down: one pass where
+// pop_heap() and push_heap() would take two
+template <class E>
+void replaceTop(vector<Pair<E> >& heap, Pair<E> p) {
+   int n = (int)heap.size();
+   int hole = 0;
+   for (int child = 1; child < n; child = 2 * hole + 1) {
+      if (child + 1 < n && heap[child + 1].exp < heap[child].exp)
+         child++;
+      if (heap[child].exp >= p.exp)
+         break;
+      heap[hole] = heap[child];
+      hole = child;
+   }
+   heap[hole] = p;
+}
+
+//------------------------------- useHeap ---------------------------------
+// Whether multiply() is cheaper than a dense product
+// Preconditions:   ta and tb are the term counts of the operands, na and
+//       nb their dense lengths (degree + 1)
+// Postconditions:  returns true if ta tb heap steps of log2(min(ta, tb))
+//       levels cost less than the dense product, counted as na nb
+//       multiply-adds below polymul::KARATSUBA_THRESHOLD and as
+//       Karatsuba's n^log2(3) for each block of the shorter length n
+//       above, plus the na + nb coefficients read
+inline bool useHeap(long long ta, long long tb, long long na, long long nb) {
+   if (ta == 0 || tb == 0)
+      return true;
+   double shorter = (double)min(na, nb), longer = (double)max(na, nb);
+   double dense = (shorter < polymul::KARATSUBA_THRESHOLD)
+         ? shorter * longer
+         : ceil(longer / shorter) * pow(shorter, log2(3.0));
+   dense += shorter + longer;
+   double levels = log2((double)min(ta, tb)) + 1;
+   return HEAP_STEP_COST * (double)ta * (double)tb * levels < dense;
+}
+
+//------------------------------- mergeRows -------------------------------
+// Take the pairs of heap off in increasing exponent order, summing the
+// pairs of each exponent into one term of out
+// Preconditions:   heap holds the first pair of each row merged so far;
+//       with chained, rows enter one by one as in multiply(), else every
+//       row is in the heap already
+// Postconditions:  out holds the nonzero sums, sorted by increasing
+//       exponent; heap is empty
+template <class W, class Term, class E>
+void mergeRows(const Term* a, int na, const Term* b, int nb,
+               vector<Pair<E> >& heap, bool chained, vector<Term>& out) {
+   while (!heap.empty()) {
+      E exp = heap.front().exp;
+      W sum(0);
+      do {
+         //the pair on top leaves; its successor in its row, if any,
+         //takes its place, and when chained the next row's first pair
+         //is added
+         Pair<E> p = heap.front();
+         sum += W(a[p.i].coeff) * W(b[p.j].coeff);
+         if (p.j + 1 < nb) {
+            Pair<E> right = { a[p.i].exp + b[p.j + 1].exp, p.i, p.j + 1 };
+            replaceTop(heap, right);
+         } else {
+            pop_heap(heap.begin(), heap.end(), pairAfter<E>);
+            heap.pop_back();
+         }
+         if (chained && p.j == 0 && p.i + 1 < na) {
+            Pair<E> down = { a[p.i + 1].exp + b[0].exp, p.i + 1, 0 };
+            heap.push_back(down);
+            push_heap(heap.begin(), heap.end(), pairAfter<E>);
+         }
+      } while (!heap.empty() && heap.front().exp == exp);
+      if (sum != W(0)) {
+         Term t;
+         t.coeff = sum;
+         t.exp = exp;
+         out.push_back(t);
+      }
+   }
+}
+
+//---------------------------- checkExponent ------------------------------
+// Throw overflow_error if the highest exponent of a * b is above the
+// largest E
+template <class Term>
+void checkExponent(const Term* a, int na, const Term* b, int nb) {
+   typedef decltype(Term::exp) E;
+   if (b[nb - 1].exp > 0 &&
+         a[na - 1].exp > numeric_limits<E>::max() - b[nb - 1].exp)
+      throw overflow_error("polysparse: exponent above its type");
+}
+
+//------------------------------ multiply ---------------------------------
+// Multiply two sorted term arrays by merging their rows in a heap
+// Preconditions:   na >= 1, nb >= 1; exponents strictly increase in a
+//       and in b
+// Postconditions:  out holds the nonzero terms of the product, sorted by
+//       increasing exponent; previous contents are discarded.  The heap
+//       runs over the rows of the shorter operand.  Throws overflow_error
+//       if the highest exponent of the product is above the largest E
+template <class W, class Term>
+void multiply(const Term* a, int na, const Term* b, int nb,
+              vector<Term>& out) {
+   typedef decltype(Term::exp) E;
+   checkExponent(a, na, b, nb);
+   if (na > nb) {
+      swap(a, b);
+      swap(na, nb);
+   }
+   out.clear();
+   vector<Pair<E> > heap;
+   heap.reserve(na);
+   Pair<E> first = { a[0].exp + b[0].exp, 0, 0 };
+   heap.push_back(first);
+   mergeRows<W>(a, na, b, nb, heap, true, out);
+}
+
+//---------------------------- multiplyHigh -------------------------------
+// The terms of a * b from exponent low up, for mulhigh()
+// Preconditions:   as for multiply()
+// Postconditions:  out holds the nonzero terms of the product with
+//       exponent >= low, as multiply() would.  Each row starts at its
+//       first pair with exponent >= low, found by binary search in b, so
+//       pairs below low are never formed.  Those starts are in no order
+//       of exponent from row to row, so every row enters the heap at once
+template <class W, class Term>
+void multiplyHigh(const Term* a, int na, const Term* b, int nb,
+                  decltype(Term::exp) low, vector<Term>& out) {
+   typedef decltype(Term::exp) E;
+   checkExponent(a, na, b, nb);
+   if (na > nb) {
+      swap(a, b);
+      swap(na, nb);
+   }
+   out.clear();
+   vector<Pair<E> > heap;
+   heap.reserve(na);
+   for (int i = 0; i < na; i++) {
+      E rowExp = a[i].exp;
+      const Term* start = partition_point(b, b + nb,
+            [rowExp, low](const Term& t) { return rowExp + t.exp < low; });
+      if (start < b + nb) {
+         Pair<E> p = { rowExp + start->exp, i, (int)(start - b) };
+         heap.push_back(p);
+      }
+   }
+   make_heap(heap.begin(), heap.end(), pairAfter<E>);
+   mergeRows<W>(a, na, b, nb, heap, false, out);
+}
+
+} // namespace polysparse
+
+#endif
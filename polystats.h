@@ -0,0 +1,306 @@
+//-----------------------------------------------------------------------//
+// POLYSTATS.H                                                           //
+//                                                                       //
+// Optional instrumentation counters and timers for Poly                 //
+//-----------------------------------------------------------------------//
+// Compiled with POLY_STATS defined, e.g.                                //
+//                                                                       //
+//     g++ -DPOLY_STATS -O2 lab1.cpp poly.cpp                            //
+//                                                                       //
+// Poly counts, on each thread, the arrays it allocates and frees, their //
+// bytes, resizeArray() calls, copies and moves of Polys, and the calls  //
+// of each operator (Op) with the coefficients or terms they processed.  //
+// After PolyStats::setTiming(true) each operator call is timed too.  A  //
+// host application reads the counts with                                //
+//                                                                       //
+//     PolyStats::Counters c = PolyStats::snapshotAll();                 //
+//     for (int i = 0; i < PolyStats::OP_COUNT; i++)                     //
+//        export(PolyStats::name(PolyStats::Op(i)), c.calls[i]);         //
+//                                                                       //
+// and clears them with reset() or resetAll().                           //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- without POLY_STATS the hooks (POLY_STATS_ADD, POLY_STATS_OP and  //
+//      POLY_STATS_ELEMENTS) expand to nothing, so they cost nothing;    //
+//      every file including poly.h must be compiled the same way        //
+//   -- each thread writes only its own block of counters, with relaxed  //
+//      atomic loads and stores, so counting takes no lock; a snapshot   //
+//      of other threads may be a moment out of date                     //
+//   -- the counts of a thread that exits are kept, in snapshotAll()     //
+//   -- operators that call others count each one: A *= B is an          //
+//      OP_MUL_ASSIGN and, for large operands, an OP_MUL; times are      //
+//      inclusive                                                        //
+//   -- the element count of OP_PARSE is the number of terms read, and   //
+//      of OP_EXPR (+, - and scalar * of polyexpr.h) the degree + 1 of   //
+//      the result                                                       //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYSTATS_H
+#define POLYSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+using namespace std;
+
+class PolyStats {
+public:
+//------------------------------ Counter ----------------------------------
+// Event counted by POLY_STATS_ADD
+enum Counter { ALLOCATIONS,    //arrays taken from a PolyAllocator
+               BYTES,          //bytes in those arrays
+               FREES,          //arrays given back
+               RESIZES,        //resizeArray() calls
+               COPIES,         //copy constructions and copy assignments
+               MOVES,          //move constructions and move assignments
+               SHARES,         //copies that share the array instead
+               UNSHARES,       //shared arrays copied before a write
+               COUNTER_COUNT };
+
+//-------------------------------- Op -------------------------------------
+// Operator timed by POLY_STATS_OP
+enum Op { OP_EXPR, OP_ADD_ASSIGN, OP_SUB_ASSIGN, OP_MUL, OP_MUL_ASSIGN,
+          OP_DIVMOD, OP_ASSIGN, OP_EQUAL, OP_EVALUATE, OP_PARSE, OP_FORMAT,
+          OP_SAVE, OP_LOAD, OP_COUNT };
+
+//----------------------------- Counters ----------------------------------
+// Counts of one thread, or the sum over threads
+struct Counters {
+   long long counts[COUNTER_COUNT];
+   long long calls[OP_COUNT];
+   long long elements[OP_COUNT];
+   long long nanoseconds[OP_COUNT];    //0 unless timing is on
+
+   Counters() {
+      for (int i = 0; i < COUNTER_COUNT; i++)
+         counts[i] = 0;
+      for (int i = 0; i < OP_COUNT; i++)
+         calls[i] = elements[i] = nanoseconds[i] = 0;
+   }
+
+   Counters& operator+=(const Counters& rhs) {
+      for (int i = 0; i < COUNTER_COUNT; i++)
+         counts[i] += rhs.counts[i];
+      for (int i = 0; i < OP_COUNT; i++) {
+         calls[i] += rhs.calls[i];
+         elements[i] += rhs.elements[i];
+         nanoseconds[i] += rhs.nanoseconds[i];
+      }
+      return *this;
+   }
+};
+
+//true when compiled with POLY_STATS, i.e. when anything is counted
+#ifdef POLY_STATS
+static const bool ENABLED = true;
+#else
+static const bool ENABLED = false;
+#endif
+
+//------------------------------- name ------------------------------------
+// Name of a Counter or Op for export, e.g. "allocations" or "mul"
+static const char* name(Counter counter) {
+   static const char* const names[COUNTER_COUNT] = {
+      "allocations", "bytes", "frees", "resizes", "copies", "moves",
+      "shares", "unshares" };
+   return names[counter];
+}
+
+static const char* name(Op op) {
+   static const char* const names[OP_COUNT] = {
+      "expr", "add_assign", "sub_assign", "mul", "mul_assign", "divmod",
+      "assign", "equal", "evaluate", "parse", "format", "save", "load" };
+   return names[op];
+}
+
+//----------------------------- snapshot ----------------------------------
+// Preconditions:   none
+// Postconditions:  returns the counts of the calling thread since it
+//       started or since its last reset
+static Counters snapshot() {
+   Counters c;
+   local().read(c);
+   return c;
+}
+
+//---------------------------- snapshotAll --------------------------------
+// Preconditions:   none
+// Postconditions:  returns the sum of the counts of every thread, running
+//       or exited, since resetAll()
+static Counters snapshotAll() {
+   Registry& r = registry();
+   lock_guard<mutex> lock(r.lock);
+   Counters c = r.exited;
+   for (size_t i = 0; i < r.blocks.size(); i++)
+      r.blocks[i]->read(c);
+   return c;
+}
+
+//------------------------------ reset ------------------------------------
+// Preconditions:   none
+// Postconditions:  the counts of the calling thread are zero
+static void reset() { local().clear(); }
+
+//----------------------------- resetAll ----------------------------------
+// Preconditions:   none
+// Postconditions:  the counts of every thread are zero; counts other
+//       threads make during the call may be lost
+static void resetAll() {
+   Registry& r = registry();
+   lock_guard<mutex> lock(r.lock);
+   r.exited = Counters();
+   for (size_t i = 0; i < r.blocks.size(); i++)
+      r.blocks[i]->clear();
+}
+
+//---------------------------- setTiming ----------------------------------
+// Turn timing of operator calls on or off, on every thread
+// Preconditions:   none
+// Postconditions:  returns the previous setting; initially off, as each
+//       timed call reads the clock twice
+static bool setTiming(bool on) { return timing().exchange(on); }
+static bool getTiming() { return timing().load(memory_order_relaxed); }
+
+//------------------------------- add -------------------------------------
+// Add to a counter of the calling thread; used by POLY_STATS_ADD
+static void add(Counter counter, long long n) {
+   local().bump(counter, n);
+}
+
+//---------------------------- addElements --------------------------------
+// Add elements to an Op of the calling thread, for operators that only
+// know how many they processed at the end; used by POLY_STATS_ELEMENTS
+static void addElements(Op op, long long n) {
+   local().bump(COUNTER_COUNT + OP_COUNT + op, n);
+}
+
+//------------------------------- Timer -----------------------------------
+// Counts one call of an Op and its elements, and times it until the end
+// of the scope if timing is on; used by POLY_STATS_OP
+class Timer {
+public:
+Timer(Op timedOp, long long elements) : op(timedOp), timed(getTiming()) {
+   Block& b = local();
+   b.bump(COUNTER_COUNT + op, 1);
+   b.bump(COUNTER_COUNT + OP_COUNT + op, elements);
+   if (timed)
+      start = chrono::steady_clock::now();
+}
+
+~Timer() {
+   if (timed) {
+      chrono::nanoseconds t = chrono::steady_clock::now() - start;
+      local().bump(COUNTER_COUNT + 2 * OP_COUNT + op, t.count());
+   }
+}
+
+private:
+Timer(const Timer&);
+Timer& operator=(const Timer&);
+
+Op op;
+bool timed;
+chrono::steady_clock::time_point start;
+};
+
+private:
+//the counters of one thread, in the order of Counters: counts, calls,
+//elements, nanoseconds
+struct Block {
+   static const int SIZE = COUNTER_COUNT + 3 * OP_COUNT;
+   atomic<long long> values[SIZE];
+
+   Block() { clear(); }
+
+   //only the owning thread bumps, so load and store need no lock
+   void bump(int i, long long n) {
+      values[i].store(values[i].load(memory_order_relaxed) + n,
+                      memory_order_relaxed);
+   }
+
+   void clear() {
+      for (int i = 0; i < SIZE; i++)
+         values[i].store(0, memory_order_relaxed);
+   }
+
+   //add into c
+   void read(Counters& c) const {
+      long long* out[4] = { c.counts, c.calls, c.elements, c.nanoseconds };
+      for (int i = 0; i < SIZE; i++) {
+         int part = (i < COUNTER_COUNT) ? 0
+                                        : 1 + (i - COUNTER_COUNT) / OP_COUNT;
+         int index = (part == 0) ? i : (i - COUNTER_COUNT) % OP_COUNT;
+         out[part][index] += values[i].load(memory_order_relaxed);
+      }
+   }
+};
+
+//every running thread's Block, and the sum of the exited ones
+struct Registry {
+   mutex lock;
+   vector<Block*> blocks;
+   Counters exited;
+};
+
+//registers a thread's Block for its lifetime
+struct Local {
+   Block block;
+
+   Local() {
+      Registry& r = registry();
+      lock_guard<mutex> lock(r.lock);
+      r.blocks.push_back(&block);
+   }
+
+   ~Local() {
+      Registry& r = registry();
+      lock_guard<mutex> lock(r.lock);
+      block.read(r.exited);
+      for (size_t i = 0; i < r.blocks.size(); i++) {
+         if (r.blocks[i] == &block) {
+            r.blocks.erase(r.blocks.begin() + i);
+            break;
+         }
+      }
+   }
+};
+
+static Block& local() {
+   static thread_local Local instance;
+   return instance.block;
+}
+
+static Registry& registry() {
+   static Registry instance;
+   return instance;
+}
+
+static atomic<bool>& timing() {
+   static atomic<bool> on(false);
+   return on;
+}
+};
+
+#define POLY_STATS_CONCAT2(a, b) a##b
+#define POLY_STATS_CONCAT(a, b) POLY_STATS_CONCAT2(a, b)
+
+//---------------------------- hook macros --------------------------------
+// POLY_STATS_ADD(ALLOCATIONS, 1)       add to a Counter
+// POLY_STATS_OP(OP_MUL, n)             count and time this call of an Op
+//                                      that processes n elements, until
+//                                      the end of the enclosing scope
+// POLY_STATS_ELEMENTS(OP_PARSE, n)     add elements to an Op
+#ifdef POLY_STATS
+#define POLY_STATS_ADD(counter, n) PolyStats::add(PolyStats::counter, (n))
+#define POLY_STATS_OP(op, n) \
+   PolyStats::Timer POLY_STATS_CONCAT(polyStatsTimer, __LINE__)( \
+         PolyStats::op, (n))
+#define POLY_STATS_ELEMENTS(op, n) PolyStats::addElements(PolyStats::op, (n))
+#else
+#define POLY_STATS_ADD(counter, n) ((void)0)
+#define POLY_STATS_OP(op, n) ((void)0)
+#define POLY_STATS_ELEMENTS(op, n) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,355 @@
+//-----------------------------------------------------------------------//
+// POLYTEXT.H                                                            //
+//                                                                       //
+// Bulk text parser and formatter for Poly                               //
+//-----------------------------------------------------------------------//
+// BasicPoly::parse() and operator>> read text in either of two forms:   //
+//                                                                       //
+//   -- pairs:   "coeff exp" pairs, optionally ended by "-1 -1", as      //
+//               typed into operator>>:          5 7  -4 3  10 1  -2 0   //
+//   -- printed: the form operator<< prints:     +5x^7 -4x^3 +10x -2     //
+//               a term is a signed coefficient, then optionally x or    //
+//               x^exp, "*" before the x and a missing coefficient       //
+//               ("-x^2") being allowed too                              //
+//                                                                       //
+// The text is in pairs form when its first two tokens are both plain    //
+// numbers.  A repeated exponent overwrites the earlier term in pairs    //
+// form, as setCoeff() does, and is added to it in printed form.         //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- Parser collects every term first, so the Poly is sized from the  //
+//      highest exponent and filled with one allocation                  //
+//   -- numbers are read with from_chars(), except __int128, which it    //
+//      does not support in strict ISO mode; ModInt reads a long long    //
+//      and reduces it                                                   //
+//   -- malformed input throws PolyParseError, which carries the offset  //
+//      of the first character that could not be parsed                  //
+//                                                                       //
+// BasicPoly::format() and operator<< print the printed form.  Terms are //
+// rendered with to_chars() into a FORMAT_CHUNK buffer that is handed to //
+// a sink whenever it fills, so output of any degree takes no more       //
+// memory than one chunk.  DENSE arrays are scanned for the next nonzero //
+// coefficient a 64-byte block at a time, which assumes that a zero      //
+// coefficient is all zero bytes, as it is for every type of polycoeff.h //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYTEXT_H
+#define POLYTEXT_H
+
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "polycoeff.h"
+using namespace std;
+
+//--------------------------- PolyParseError ------------------------------
+// Malformed Poly text, with where it went wrong
+class PolyParseError : public invalid_argument {
+public:
+PolyParseError(const string& message, size_t offset)
+      : invalid_argument(message + " at offset " + to_string(offset)),
+        at(offset) {}
+
+//----------------------------- position ----------------------------------
+// Offset into the text of the first character that could not be parsed
+size_t position() const { return at; }
+
+private:
+size_t at;
+};
+
+namespace polytext {
+
+//---------------------------- readInteger --------------------------------
+// Read an optionally signed decimal integer of type I from [first, last)
+// Preconditions:   none
+// Postconditions:  returns the end of the number, or NULL if there is no
+//       number there; range is set if it does not fit in I
+template <class I>
+const char* readInteger(const char* first, const char* last, I& value,
+                        bool& range) {
+   range = false;
+   if (first < last && *first == '+') {
+      first++;
+      if (first < last && *first == '-')
+         return NULL;
+   }
+   from_chars_result r = from_chars(first, last, value);
+   if (r.ec == errc::invalid_argument)
+      return NULL;
+   range = (r.ec == errc::result_out_of_range);
+   return r.ptr;
+}
+
+//digit by digit, with the overflow checks from_chars() would make
+template <>
+inline const char* readInteger(const char* first, const char* last,
+                               __int128& value, bool& range) {
+   range = false;
+   bool negative = (first < last && *first == '-');
+   if (first < last && (*first == '-' || *first == '+'))
+      first++;
+   if (first == last || *first < '0' || *first > '9')
+      return NULL;
+   const unsigned __int128 limit =
+         ((unsigned __int128)1 << 127) - (negative ? 0 : 1);
+   unsigned __int128 u = 0;
+   for (; first < last && *first >= '0' && *first <= '9'; first++) {
+      unsigned digit = (unsigned)(*first - '0');
+      if (u > (limit - digit) / 10)
+         range = true;
+      u = u * 10 + digit;
+   }
+   value = negative ? (__int128)(0 - u) : (__int128)u;
+   return first;
+}
+
+//------------------------------- Digits ----------------------------------
+// How a coefficient of type T is read: as the integer type Int, then
+// converted to T
+template <class T> struct Digits { typedef T Int; };
+template <> struct Digits<CheckedInt> { typedef int Int; };
+template <uint32_t P> struct Digits<ModInt<P> > { typedef long long Int; };
+
+//------------------------------- Parser ----------------------------------
+// Reads the terms of one Poly from [first, last); Term has the coeff and
+// exp fields of BasicPoly<T>::Term
+template <class T, class Term>
+class Parser {
+public:
+Parser(const char* first, const char* last)
+      : begin(first), p(first), end(last) {}
+
+//------------------------------- terms -----------------------------------
+// Preconditions:   none
+// Postconditions:  out holds the terms in the order written, pairs is
+//       true for the pairs form, and highestExp is the largest exponent
+//       (-1 with no terms); throws PolyParseError
+void terms(vector<Term>& out, bool& pairs, int& highestExp) {
+   out.clear();
+   highestExp = -1;
+   pairs = isPairs();
+   skipSpace();
+   while (p < end) {
+      Term t;
+      if (pairs) {
+         t.coeff = coefficient();
+         skipSpace();
+         const char* start = p;
+         t.exp = exponent();
+         if (t.coeff == T(-1) && t.exp == -1) {
+            skipSpace();
+            if (p < end)
+               fail("text after -1 -1");
+            break;
+         }
+         if (t.exp < 0) {
+            p = start;
+            fail("negative exponent");
+         }
+      } else {
+         printedTerm(t, out.empty());
+      }
+      out.push_back(t);
+      highestExp = max(highestExp, t.exp);
+      skipSpace();
+   }
+}
+
+private:
+//is the text "number number ..."?
+bool isPairs() {
+   const char* start = p;
+   bool plain = plainNumber() && plainNumber();
+   p = start;
+   return plain;
+}
+
+//a number followed by whitespace or the end of the text
+bool plainNumber() {
+   skipSpace();
+   typename Digits<T>::Int value;
+   bool range;
+   const char* q = readInteger(p, end, value, range);
+   if (q == NULL || (q < end && !isspace((unsigned char)*q)))
+      return false;
+   p = q;
+   return true;
+}
+
+T coefficient() {
+   typename Digits<T>::Int value;
+   bool range;
+   const char* q = readInteger(p, end, value, range);
+   if (q == NULL)
+      fail("expected a coefficient");
+   if (range)
+      fail("coefficient out of range");
+   p = q;
+   return T(value);
+}
+
+int exponent() {
+   int value;
+   bool range;
+   const char* q = readInteger(p, end, value, range);
+   if (q == NULL)
+      fail("expected an exponent");
+   if (range)
+      fail("exponent out of range");
+   p = q;
+   return value;
+}
+
+//[sign] [coefficient] [[*] x [^ exponent]]; a term after the first
+//starts with its sign, which may be followed by spaces
+void printedTerm(Term& t, bool first) {
+   bool hasSign = (p < end && (*p == '+' || *p == '-'));
+   if (!first && !hasSign)
+      fail("expected + or -");
+   bool negative = hasSign && *p == '-';
+   const char* sign = p;
+   if (hasSign) {
+      p++;
+      skipSpace();
+   }
+   bool digits = (p < end && *p >= '0' && *p <= '9');
+   if (digits && p == sign + 1) {
+      p = sign;                       //read with the sign, e.g. INT_MIN
+      t.coeff = coefficient();
+   } else if (digits) {
+      t.coeff = coefficient();
+      if (negative)
+         t.coeff = T(0) - t.coeff;
+   } else {
+      t.coeff = negative ? T(-1) : T(1);
+   }
+   t.exp = 0;
+   bool star = (p < end && *p == '*');
+   if (star && !digits)
+      fail("expected a coefficient");
+   if (star)
+      p++;
+   if (p < end && *p == 'x') {
+      p++;
+      t.exp = 1;
+      if (p < end && *p == '^') {
+         p++;
+         if (p == end || *p < '0' || *p > '9')
+            fail("expected an exponent");
+         t.exp = exponent();
+      }
+   } else if (star || !digits) {
+      fail(star ? "expected x" : "expected a term");
+   }
+   if (p < end && !isspace((unsigned char)*p) && *p != '+' && *p != '-')
+      fail("unexpected character");
+}
+
+void skipSpace() {
+   while (p < end && isspace((unsigned char)*p))
+      p++;
+}
+
+void fail(const char* message) const {
+   throw PolyParseError(string("Poly text: ") + message, p - begin);
+}
+
+const char* begin;
+const char* p;
+const char* end;
+};
+
+//bytes handed to the sink of BasicPoly::format() at a time
+const int FORMAT_CHUNK = 4096;
+
+//longest term: " -", 39 digits of an __int128, "x^" and 10 digits
+const int TERM_MAX = 64;
+
+//---------------------------- writeInteger -------------------------------
+// Write a signed decimal integer with to_chars()
+// Preconditions:   out has room for the digits and sign
+// Postconditions:  returns the end of what was written
+template <class I>
+char* writeInteger(char* out, I value) {
+   return to_chars(out, out + TERM_MAX, value).ptr;
+}
+
+//two 19-digit halves, as to_chars() lacks __int128 in strict ISO mode
+template <>
+inline char* writeInteger(char* out, __int128 value) {
+   unsigned __int128 u = (value < 0) ? 0 - (unsigned __int128)value
+                                     : (unsigned __int128)value;
+   if (value < 0)
+      *out++ = '-';
+   const uint64_t TEN19 = 10000000000000000000ull;
+   if (u < TEN19)
+      return to_chars(out, out + TERM_MAX, (uint64_t)u).ptr;
+   char* end = writeInteger(out, (__int128)(u / TEN19));
+   uint64_t low = (uint64_t)(u % TEN19);
+   char digits[20];
+   char* last = to_chars(digits, digits + 20, low).ptr;
+   int n = (int)(last - digits);
+   memset(end, '0', 19 - n);         //zero padded to 19 digits
+   memcpy(end + 19 - n, digits, n);
+   return end + 19;
+}
+
+//------------------------------- Signed ----------------------------------
+// The integer a coefficient of type T is printed as, and its sign
+template <class T> struct Signed {
+   typedef T Int;
+   static Int of(T x) { return x; }
+};
+template <> struct Signed<CheckedInt> {
+   typedef int Int;
+   static Int of(CheckedInt x) { return x.value(); }
+};
+template <uint32_t P> struct Signed<ModInt<P> > {
+   typedef uint32_t Int;
+   static Int of(ModInt<P> x) { return x.value(); }
+};
+
+//----------------------------- writeTerm ---------------------------------
+// Write one nonzero term as operator<< prints it: " +3x^5", " -2x", " +1"
+// Preconditions:   out has room for TERM_MAX characters, coeff != 0
+// Postconditions:  returns the end of what was written
+template <class T>
+char* writeTerm(char* out, T coeff, int exponent) {
+   typename Signed<T>::Int value = Signed<T>::of(coeff);
+   *out++ = ' ';
+   if (value > 0)
+      *out++ = '+';
+   out = writeInteger(out, value);
+   if (exponent > 0) {
+      *out++ = 'x';
+      if (exponent > 1) {
+         *out++ = '^';
+         out = to_chars(out, out + TERM_MAX, exponent).ptr;
+      }
+   }
+   return out;
+}
+
+//----------------------------- lastNonzero -------------------------------
+// Index of the highest nonzero coefficient of a[0..k], or -1
+// Preconditions:   a zero T is all zero bytes
+// Postconditions:  whole 64-byte blocks of zeros are skipped with memcmp()
+template <class T>
+int lastNonzero(const T* a, int k) {
+   const int BLOCK = (sizeof(T) < 64) ? 64 / sizeof(T) : 1;
+   static const char zeros[BLOCK * sizeof(T)] = {};
+   while (k + 1 >= BLOCK &&
+          memcmp(a + k + 1 - BLOCK, zeros, sizeof(zeros)) == 0)
+      k -= BLOCK;
+   while (k >= 0 && a[k] == 0)
+      k--;
+   return k;
+}
+
+} // namespace polytext
+
+#endif
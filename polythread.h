@@ -0,0 +1,254 @@
+//-----------------------------------------------------------------------//
+// POLYTHREAD.H                                                          //
+//                                                                       //
+// Work-stealing thread pool for parallel Poly operations                //
+//-----------------------------------------------------------------------//
+// parallelFor() splits a range of indexes into tasks and waits until    //
+// every one has run:                                                    //
+//                                                                       //
+//     PolyThreadPool& pool = PolyThreadPool::shared();                  //
+//     pool.parallelFor(0, n, grain, [&](int lo, int hi) {               //
+//        ... work on [lo, hi) ...                                       //
+//     });                                                               //
+//                                                                       //
+// Every thread of the pool has a deque of tasks.  A range is split in   //
+// halves; the upper half is pushed on the back of the deque of the      //
+// thread doing the split, which goes on with the lower half, so a busy  //
+// thread works depth first.  An idle thread steals from the front of    //
+// another deque, taking the largest pieces left.                        //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- the thread that calls parallelFor() runs tasks too while it      //
+//      waits, so a task may itself call parallelFor() (nested           //
+//      parallelism, e.g. the recursive products of a multiplication)    //
+//   -- a thread outside the pool pushes onto one shared extra deque     //
+//   -- each deque is guarded by its own mutex; tasks are coarse         //
+//      (grain sized), so the locking is not a bottleneck                //
+//   -- an exception thrown by a task is rethrown by parallelFor() once  //
+//      every task of the call has finished                              //
+//   -- which thread runs a piece does not change what it computes, so   //
+//      results do not depend on the number of threads                   //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYTHREAD_H
+#define POLYTHREAD_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+class PolyThreadPool {
+public:
+//------------------------------ Constructor ------------------------------
+// Preconditions:   none
+// Postconditions:  threads - 1 worker threads are started, the calling
+//       thread of parallelFor() being the last; 0 means one per hardware
+//       thread
+explicit PolyThreadPool(int threads = 0) {
+   if (threads <= 0)
+      threads = max(1, (int)thread::hardware_concurrency());
+   stopping = false;
+   pending = 0;
+   queues.resize(threads);          //workers, then the outside deque
+   for (int i = 0; i < threads; i++)
+      queues[i] = new Queue;
+   for (int i = 0; i + 1 < threads; i++)
+      workers.push_back(thread(&PolyThreadPool::work, this, i));
+}
+
+~PolyThreadPool() {
+   {
+      lock_guard<mutex> lock(sleepLock);
+      stopping = true;
+   }
+   wake.notify_all();
+   for (size_t i = 0; i < workers.size(); i++)
+      workers[i].join();
+   for (size_t i = 0; i < queues.size(); i++)
+      delete queues[i];
+}
+
+//------------------------------- size ------------------------------------
+// Number of threads that run tasks, counting the caller
+int size() const { return (int)queues.size(); }
+
+//---------------------------- parallelFor --------------------------------
+// Run fn(lo, hi) over pieces of [begin, end) of at most grain indexes
+// Preconditions:   grain >= 1; fn may be called from several threads at
+//       once, on disjoint pieces
+// Postconditions:  fn has been called exactly once for each piece, and
+//       every call has returned
+template <class F>
+void parallelFor(int begin, int end, int grain, F fn) {
+   if (end - begin <= grain || size() == 1) {
+      for (int lo = begin; lo < end; lo += grain)
+         fn(lo, min(lo + grain, end));
+      return;
+   }
+   Group group;
+   split(begin, end, grain, fn, group);
+   wait(group);
+   if (group.error)
+      rethrow_exception(group.error);
+}
+
+//------------------------------ shared -----------------------------------
+// The pool used by Poly, with one thread per hardware thread, or as many
+// as the environment variable POLY_THREADS says
+static PolyThreadPool& shared() {
+   static PolyThreadPool instance(threadsFromEnvironment());
+   return instance;
+}
+
+private:
+PolyThreadPool(const PolyThreadPool&);
+PolyThreadPool& operator=(const PolyThreadPool&);
+
+//tasks of one parallelFor() call
+struct Group {
+   atomic<int> left;
+   mutex errorLock;
+   exception_ptr error;
+
+   Group() : left(0) {}
+};
+
+struct Task {
+   function<void()> run;
+   Group* group;
+};
+
+struct Queue {
+   mutex lock;
+   deque<Task> tasks;
+};
+
+//push the upper halves of [begin, end) as tasks, run the lowest piece
+template <class F>
+void split(int begin, int end, int grain, F& fn, Group& group) {
+   while (end - begin > grain) {
+      int mid = begin + (end - begin) / 2;
+      Task task;
+      task.group = &group;
+      task.run = [this, mid, end, grain, &fn, &group]() {
+         split(mid, end, grain, fn, group);
+      };
+      push(task);
+      end = mid;
+   }
+   try {
+      fn(begin, end);
+   } catch (...) {
+      lock_guard<mutex> lock(group.errorLock);
+      if (!group.error)
+         group.error = current_exception();
+   }
+}
+
+void push(const Task& task) {
+   task.group->left++;
+   Queue* queue = queues[self()];
+   {
+      lock_guard<mutex> lock(queue->lock);
+      queue->tasks.push_back(task);
+   }
+   pending++;
+   {
+      //a worker between its check of pending and its wait holds sleepLock
+      lock_guard<mutex> lock(sleepLock);
+   }
+   wake.notify_one();
+}
+
+//pop from the back of our own deque, else steal from the front of another
+bool take(Task& task) {
+   int me = self();
+   int n = size();
+   for (int k = 0; k < n; k++) {
+      Queue* queue = queues[(me + k) % n];
+      lock_guard<mutex> lock(queue->lock);
+      if (!queue->tasks.empty()) {
+         if (k == 0) {
+            task = queue->tasks.back();
+            queue->tasks.pop_back();
+         } else {
+            task = queue->tasks.front();
+            queue->tasks.pop_front();
+         }
+         pending--;
+         return true;
+      }
+   }
+   return false;
+}
+
+static int threadsFromEnvironment() {
+   const char* value = getenv("POLY_THREADS");
+   return (value != NULL) ? atoi(value) : 0;
+}
+
+void runTask(Task& task) {
+   task.run();
+   task.group->left--;
+}
+
+//run tasks until every task of the group is done
+void wait(Group& group) {
+   Task task;
+   while (group.left > 0) {
+      if (take(task))
+         runTask(task);
+      else
+         this_thread::yield();
+   }
+}
+
+void work(int index) {
+   workerIndex() = index;
+   owner() = this;
+   Task task;
+   for (;;) {
+      if (take(task)) {
+         runTask(task);
+         continue;
+      }
+      unique_lock<mutex> lock(sleepLock);
+      if (stopping)
+         return;
+      if (pending == 0)
+         wake.wait(lock);
+   }
+}
+
+//deque of the calling thread: its own in a worker, else the last one
+int self() const {
+   return (owner() == this) ? workerIndex() : size() - 1;
+}
+
+static int& workerIndex() {
+   static thread_local int index = 0;
+   return index;
+}
+
+static const PolyThreadPool*& owner() {
+   static thread_local const PolyThreadPool* pool = NULL;
+   return pool;
+}
+
+vector<Queue*> queues;
+vector<thread> workers;
+atomic<int> pending;       //tasks in all deques
+mutex sleepLock;
+condition_variable wake;
+bool stopping;
+};
+
+#endif
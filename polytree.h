@@ -0,0 +1,312 @@
+//-----------------------------------------------------------------------//
+// POLYTREE.H                                                            //
+//                                                                       //
+// Subproduct tree evaluation and interpolation kernels used by Poly     //
+//-----------------------------------------------------------------------//
+// For points x[0..n), the subproduct tree holds the products            //
+//                                                                       //
+//     M(x) = (x - x[lo]) * (x - x[lo+1]) * ... * (x - x[hi-1])          //
+//                                                                       //
+// over halving ranges [lo, hi), from all n points at the root down to   //
+// leaves of at most LEAF_SIZE points.  With a fast multiplication both  //
+// of these take O(M(n) log n) time instead of O(n^2):                   //
+//                                                                       //
+//   -- evaluation:    p mod M at the root, then the remainder modulo    //
+//                     each child, down to the leaves, where the         //
+//                     remainder has degree < LEAF_SIZE and is           //
+//                     evaluated at each point by Horner's rule          //
+//   -- interpolation: with w[i] = M'(x[i]) at the root, the Poly        //
+//                     through (x[i], y[i]) is the sum of                //
+//                     y[i]/w[i] * M(x)/(x - x[i]), built bottom up as   //
+//                     left * M(right) + right * M(left)                 //
+//                                                                       //
+// Implementation and assumptions:                                       //
+//   -- W is a ring word as in polymul.h; remainders are only taken      //
+//      modulo the monic products M, so evaluation is exact for every    //
+//      W.  Interpolation divides by the w[i], so W must be a field      //
+//      type with inverse() (ModInt)                                     //
+//   -- Mul multiplies two W arrays like polymul::multiply()             //
+//   -- a remainder with a long quotient is computed with Newton         //
+//      iteration: the quotient is the reversed dividend times the       //
+//      power series inverse of the reversed divisor.  divideMonic() is  //
+//      also what Poly's / and % use                                     //
+//-----------------------------------------------------------------------//
+
+#ifndef POLYTREE_H
+#define POLYTREE_H
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include "polyseries.h"
+using namespace std;
+
+namespace polytree {
+
+//most points in a leaf of the tree
+const int LEAF_SIZE = 32;
+
+//remainders use Newton iteration once both the quotient and the divisor
+//have this many terms; shorter ones use long division
+const int NEWTON_MIN = 128;
+
+//Poly::evaluate() uses the tree once both the degree and the number of
+//points reach this: sooner for ModInt than for the integer types, whose
+//Horner steps are SIMD multiply-adds
+const int TREE_MIN_SIZE = 8192;
+const int MOD_TREE_MIN_SIZE = 2048;
+
+//------------------------------ mulInto ----------------------------------
+// out = a * b, resized to the product length
+// Preconditions:   a and b are not empty
+// Postconditions:  out holds the full product
+template <class W, class Mul>
+void mulInto(const vector<W>& a, const vector<W>& b, vector<W>& out,
+             Mul mul) {
+   out.resize(a.size() + b.size() - 1);
+   mul(&a[0], (int)a.size(), &b[0], (int)b.size(), &out[0]);
+}
+
+//---------------------------- seriesInverse ------------------------------
+// Power series inverse of a, to n terms, by the Newton steps of
+// polyseries::extendInverse()
+// Preconditions:   na >= 1, a[0] == 1, n >= 1
+// Postconditions:  out holds b[0..n) with a * b == 1 mod x^n
+template <class W, class Mul>
+void seriesInverse(const W* a, int na, int n, vector<W>& out, Mul mul) {
+   polyseries::Workspace<W> work(n);
+   out.assign(n, W(0));
+   out[0] = W(1);
+   polyseries::extendInverse(a, na, n, &out[0], work, mul);
+}
+
+//----------------------------- divideMonic -------------------------------
+// Quotient and remainder of a divided by a monic m
+// Preconditions:   na >= 1, nm >= 1, m[nm - 1] == 1
+// Postconditions:  quotient holds the na - nm + 1 coefficients of a / m
+//       (none when a is shorter than m), and remainder the nm - 1
+//       coefficients of a mod m (zero padded when a is shorter).  Long
+//       quotients by long divisors take a few products: with rev(p) the
+//       coefficients of p in reverse order, rev(a / m) is rev(a) times
+//       the series inverse of rev(m), to na - nm + 1 terms
+template <class W, class Mul>
+void divideMonic(const W* a, int na, const W* m, int nm,
+                 vector<W>& quotient, vector<W>& remainder, Mul mul) {
+   int d = nm - 1;
+   remainder.assign(d, W(0));
+   if (na <= d) {
+      quotient.clear();
+      copy(a, a + na, remainder.begin());
+      return;
+   }
+   int q = na - d;
+   if (q < NEWTON_MIN || d < NEWTON_MIN) {
+      vector<W> r(a, a + na);
+      quotient.resize(q);
+      for (int i = na - 1; i >= d; i--) {
+         W c = r[i];
+         W* row = &r[i - d];
+         quotient[i - d] = c;
+         for (int j = 0; j < d; j++)
+            row[j] -= c * m[j];
+      }
+      copy(r.begin(), r.begin() + d, remainder.begin());
+      return;
+   }
+
+   vector<W> revM(m, m + nm), inv, revA(q), product;
+   reverse(revM.begin(), revM.end());
+   seriesInverse(&revM[0], nm, q, inv, mul);
+   for (int i = 0; i < q; i++)
+      revA[i] = a[na - 1 - i];
+   mulInto(revA, inv, quotient, mul);
+   quotient.resize(q);
+   reverse(quotient.begin(), quotient.end());
+
+   vector<W> divisor(m, m + nm);
+   mulInto(quotient, divisor, product, mul);
+   for (int i = 0; i < d; i++)
+      remainder[i] = a[i] - product[i];
+}
+
+//---------------------------- remainderMonic -----------------------------
+// Remainder of a divided by a monic m
+// Preconditions:   na >= 1, nm >= 2, m[nm - 1] == 1
+// Postconditions:  out holds the nm - 1 coefficients of a mod m (zero
+//       padded when a is shorter), from divideMonic()
+template <class W, class Mul>
+void remainderMonic(const W* a, int na, const W* m, int nm, vector<W>& out,
+                    Mul mul) {
+   vector<W> quotient;
+   divideMonic(a, na, m, nm, quotient, out, mul);
+}
+
+//--------------------------- SubproductTree ------------------------------
+// The products M of a set of points over halving ranges, stored as a
+// heap: node 1 covers every point, node k has children 2k and 2k + 1
+template <class W, class Mul>
+class SubproductTree {
+public:
+//------------------------------ Constructor ------------------------------
+// Preconditions:   n >= 1; xs outlives the tree
+// Postconditions:  every node holds its monic product
+SubproductTree(const W* xs, int n, Mul multiplier)
+      : x(xs), count(n), mul(multiplier) {
+   int leaves = (n + LEAF_SIZE - 1) / LEAF_SIZE;
+   int size = 2;
+   while (size < 2 * leaves)
+      size *= 2;
+   nodes.resize(size);
+   build(1, 0, n);
+}
+
+//------------------------------- root ------------------------------------
+// The product over every point, of degree n
+const vector<W>& root() const { return nodes[1]; }
+
+//------------------------------ evaluate ---------------------------------
+// Evaluate a coefficient array at every point
+// Preconditions:   nc >= 1, out has room for n values
+// Postconditions:  out[i] is the value at x[i]
+void evaluate(const W* coeffs, int nc, W* out) const {
+   vector<W> r;
+   remainderMonic(coeffs, nc, &nodes[1][0], (int)nodes[1].size(), r, mul);
+   down(1, 0, count, r, out);
+}
+
+//------------------------------ combine ----------------------------------
+// Linear combination of the products M(x)/(x - x[i]) of the root
+// Preconditions:   c holds n weights, out has room for n coefficients
+// Postconditions:  out holds the sum of c[i] * M(x)/(x - x[i])
+void combine(const W* c, W* out) const {
+   vector<W> result;
+   up(1, 0, count, c, result);
+   copy(result.begin(), result.end(), out);
+}
+
+private:
+//fill node with the product over [lo, hi)
+void build(int node, int lo, int hi) {
+   vector<W>& m = nodes[node];
+   if (hi - lo <= LEAF_SIZE) {
+      m.assign(1, W(1));
+      for (int i = lo; i < hi; i++) {
+         m.push_back(W(1));
+         for (int j = (int)m.size() - 2; j > 0; j--)
+            m[j] = m[j - 1] - x[i] * m[j];
+         m[0] = W(0) - x[i] * m[0];
+      }
+      return;
+   }
+   int mid = lo + (hi - lo) / 2;
+   build(2 * node, lo, mid);
+   build(2 * node + 1, mid, hi);
+   mulInto(nodes[2 * node], nodes[2 * node + 1], m, mul);
+}
+
+//r is the remainder modulo node's product; evaluate it at [lo, hi)
+void down(int node, int lo, int hi, const vector<W>& r, W* out) const {
+   if (hi - lo <= LEAF_SIZE) {
+      for (int i = lo; i < hi; i++) {
+         W value = W(0);
+         for (int j = (int)r.size() - 1; j >= 0; j--)
+            value = value * x[i] + r[j];
+         out[i] = value;
+      }
+      return;
+   }
+   int mid = lo + (hi - lo) / 2;
+   vector<W> child;
+   const vector<W>& left = nodes[2 * node];
+   remainderMonic(&r[0], (int)r.size(), &left[0], (int)left.size(), child,
+                  mul);
+   down(2 * node, lo, mid, child, out);
+   const vector<W>& right = nodes[2 * node + 1];
+   remainderMonic(&r[0], (int)r.size(), &right[0], (int)right.size(), child,
+                  mul);
+   down(2 * node + 1, mid, hi, child, out);
+}
+
+//result = sum of c[i] * M(x)/(x - x[i]) over [lo, hi), with hi - lo
+//coefficients
+void up(int node, int lo, int hi, const W* c, vector<W>& result) const {
+   const vector<W>& m = nodes[node];
+   int d = hi - lo;
+   if (d <= LEAF_SIZE) {
+      //synthetic division of m by (x - x[i]) gives d coefficients
+      result.assign(d, W(0));
+      for (int i = lo; i < hi; i++) {
+         W q = m[d];
+         result[d - 1] += c[i] * q;
+         for (int j = d - 1; j > 0; j--) {
+            q = m[j] + x[i] * q;
+            result[j - 1] += c[i] * q;
+         }
+      }
+      return;
+   }
+   int mid = lo + (hi - lo) / 2;
+   vector<W> left, right, product;
+   up(2 * node, lo, mid, c, left);
+   up(2 * node + 1, mid, hi, c, right);
+   mulInto(left, nodes[2 * node + 1], result, mul);
+   mulInto(right, nodes[2 * node], product, mul);
+   result.resize(d);
+   for (int i = 0; i < d; i++)
+      result[i] += product[i];
+}
+
+vector<vector<W> > nodes;
+const W* x;
+int count;
+Mul mul;
+};
+
+//------------------------------ evaluate ---------------------------------
+// Evaluate a coefficient array at n points, a tree of at most
+// max(nc, LEAF_SIZE) points at a time
+// Preconditions:   nc >= 1, out has room for n values
+// Postconditions:  out[i] is the value at xs[i]
+template <class W, class Mul>
+void evaluate(const W* coeffs, int nc, const W* xs, int n, W* out,
+              Mul mul) {
+   int chunk = max(nc, LEAF_SIZE);
+   for (int start = 0; start < n; start += chunk) {
+      SubproductTree<W, Mul> tree(xs + start, min(chunk, n - start), mul);
+      tree.evaluate(coeffs, nc, out + start);
+   }
+}
+
+//----------------------------- interpolate -------------------------------
+// Coefficients of the Poly of degree < n through (xs[i], ys[i])
+// Preconditions:   n >= 1, W is a field type with inverse(), out has
+//       room for n coefficients
+// Postconditions:  out holds the coefficients; throws domain_error if
+//       two points are equal
+template <class W, class Mul>
+void interpolate(const W* xs, const W* ys, int n, W* out, Mul mul) {
+   SubproductTree<W, Mul> tree(xs, n, mul);
+   const vector<W>& m = tree.root();
+   vector<W> derivative(n), w(n);
+   for (int i = 1; i <= n; i++)
+      derivative[i - 1] = m[i] * W(i);
+   tree.evaluate(&derivative[0], n, &w[0]);
+
+   //c[i] = ys[i] / w[i], with one inverse for all of them
+   vector<W> prefix(n + 1), c(n);
+   prefix[0] = W(1);
+   for (int i = 0; i < n; i++)
+      prefix[i + 1] = prefix[i] * w[i];
+   if (prefix[n] == W(0))
+      throw domain_error("interpolate: the points must be distinct");
+   W inv = prefix[n].inverse();
+   for (int i = n - 1; i >= 0; i--) {
+      c[i] = ys[i] * inv * prefix[i];
+      inv = inv * w[i];
+   }
+   tree.combine(&c[0], out);
+}
+
+} // namespace polytree
+
+#endif